@@ -0,0 +1,42 @@
+/**
+ * @file bench.h
+ * @brief Shared helpers for the benchmark programs.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#ifndef LIBRTP_BENCH_H_
+#define LIBRTP_BENCH_H_
+
+#include <stdio.h>
+#include <time.h>
+
+/**
+ * @brief Returns a monotonic timestamp in nanoseconds.
+ */
+static inline double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+/**
+ * @brief Print a benchmark result.
+ *
+ * @param [in] name - benchmark name.
+ * @param [in] elapsed - elapsed time in nanoseconds.
+ * @param [in] ops - number of operations performed.
+ */
+static inline void bench_report(const char *name, double elapsed, double ops)
+{
+    printf("%-32s %10.2f ns/op %12.0f ops/s\n",
+        name, elapsed / ops, ops / (elapsed / 1e9));
+}
+
+/**
+ * @brief Prevent the compiler from discarding a value.
+ */
+#define BENCH_KEEP(x) __asm__ __volatile__("" : : "g"(x) : "memory")
+
+#endif // LIBRTP_BENCH_H_
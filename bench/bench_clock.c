@@ -0,0 +1,70 @@
+/**
+ * @file bench_clock.c
+ * @brief Compare ways of getting an arrival time in RTP units.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include "rtp_clock.h"
+#include "rtp_source.h"
+#include "bench.h"
+
+#define READS (1 << 22)
+#define RATE (90000)
+
+int main(void)
+{
+    // Baseline: wallclock as a double, scaled per packet
+    uint32_t sum = 0;
+    double start = bench_now();
+    for(int i = 0; i < READS; ++i) {
+        struct timespec ts;
+        clock_gettime(CLOCK_REALTIME, &ts);
+        const double s = (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+        sum += (uint32_t)(uint64_t)(s * RATE);
+    }
+    bench_report("realtime double", bench_now() - start, READS);
+    BENCH_KEEP(sum);
+
+    sum = 0;
+    start = bench_now();
+    for(int i = 0; i < READS; ++i) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        sum += rtp_timespec_to_rtp(&ts, RATE);
+    }
+    bench_report("rtp_timespec_to_rtp", bench_now() - start, READS);
+    BENCH_KEEP(sum);
+
+    // Long enough for a TSC build to calibrate
+    rtp_clock c;
+    rtp_clock_init(&c);
+
+    const struct timespec pause = { 0, 20000000 };
+    nanosleep(&pause, NULL);
+    rtp_clock_sync(&c);
+
+    rtp_clock_rate r;
+    rtp_clock_rate_init(&r, RATE);
+
+    sum = 0;
+    start = bench_now();
+    for(int i = 0; i < READS; ++i)
+        sum += rtp_clock_to_rtp(&r, rtp_clock_now(&c));
+    bench_report("rtp_clock_to_rtp", bench_now() - start, READS);
+    BENCH_KEEP(sum);
+
+    // Conversion alone, as for kernel receive timestamps
+    uint64_t ns = rtp_clock_now(&c);
+    sum = 0;
+    start = bench_now();
+    for(int i = 0; i < READS; ++i) {
+        sum += rtp_clock_to_rtp(&r, ns);
+        ns += 20000000u;
+        BENCH_KEEP(ns);
+    }
+    bench_report("rtp_clock_to_rtp (no read)", bench_now() - start, READS);
+    BENCH_KEEP(sum);
+
+    return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file bench_jitter.c
+ * @brief Compare per-packet and batched jitter estimation.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp_source.h"
+#include "bench.h"
+
+#define PACKETS (1 << 16)
+#define BATCH (32)
+#define ROUNDS (64)
+
+int main(void)
+{
+    static uint32_t ts[PACKETS];
+    static uint32_t arrival[PACKETS];
+
+    srand(1234);
+    for(int i = 0; i < PACKETS; ++i) {
+        ts[i] = (uint32_t)i * 160;
+        arrival[i] = ts[i] + 5000 + (uint32_t)(rand() % 40);
+    }
+
+    printf("jitter: %s\n", (LIBRTP_JITTER_FIXED) ? "fixed" : "double");
+
+    rtp_source s;
+    memset(&s, 0, sizeof(s));
+
+    double start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < PACKETS; ++i)
+            rtp_source_update_jitter(&s, ts[i], arrival[i]);
+    }
+    bench_report("rtp_source_update_jitter",
+        bench_now() - start, (double)PACKETS * ROUNDS);
+    BENCH_KEEP(rtp_source_jitter(&s));
+
+    memset(&s, 0, sizeof(s));
+
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < PACKETS; i += BATCH)
+            rtp_source_update_jitter_batch(&s, &ts[i], &arrival[i], BATCH);
+    }
+    bench_report("rtp_source_update_jitter_batch",
+        bench_now() - start, (double)PACKETS * ROUNDS);
+    BENCH_KEEP(rtp_source_jitter(&s));
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file bench_loss.c
+ * @brief Per-packet cost of loss, burst and reordering tracking.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp_loss.h"
+#include "bench.h"
+
+#define PACKETS (1 << 22)
+
+/**
+ * @brief Feed a sequence with the given loss and reorder rates (percent).
+ */
+static void run(const char *name, int loss, int reorder)
+{
+    static uint32_t seqs[PACKETS];
+
+    srand(1234);
+    size_t n = 0;
+    for(uint32_t seq = 0; n < PACKETS; ++seq) {
+        if(rand() % 100 < loss)
+            continue;
+
+        seqs[n++] = seq;
+        if(n > 1 && rand() % 100 < reorder) {
+            const uint32_t tmp = seqs[n - 1];
+            seqs[n - 1] = seqs[n - 2];
+            seqs[n - 2] = tmp;
+        }
+    }
+
+    rtp_loss l;
+    rtp_loss_init(&l);
+
+    const double start = bench_now();
+    for(size_t i = 0; i < n; ++i)
+        rtp_loss_update(&l, seqs[i]);
+
+    bench_report(name, bench_now() - start, (double)n);
+
+    rtp_loss_stats stats;
+    rtp_loss_get_stats(&l, &stats);
+    BENCH_KEEP(stats.lost);
+}
+
+int main(void)
+{
+    printf("window: %d packets\n", LIBRTP_LOSS_WINDOW);
+    run("in order", 0, 0);
+    run("1% loss", 1, 0);
+    run("5% loss, 5% reordered", 5, 5);
+    return 0;
+}
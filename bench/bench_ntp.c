@@ -0,0 +1,73 @@
+/**
+ * @file bench_ntp.c
+ * @brief Compare DLSR computation in double and fixed point.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+
+#include "ntp.h"
+#include "bench.h"
+
+#define PAIRS (1 << 16)
+#define ROUNDS (64)
+
+int main(void)
+{
+    static ntp_tv now[PAIRS];
+    static ntp_tv lsr[PAIRS];
+
+    srand(1234);
+    for(int i = 0; i < PAIRS; ++i) {
+        now[i].sec = 0xe5000000u + (uint32_t)(rand() % 1000);
+        now[i].frac = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+        lsr[i].sec = now[i].sec - 1 - (uint32_t)(rand() % 10);
+        lsr[i].frac = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+    }
+
+    // Each round clobbers the inputs so the rounds cannot be folded into one
+
+    // Baseline: the round trip through double that ntp_diff() used to do
+    uint32_t sum = 0;
+    double start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        BENCH_KEEP(now);
+        BENCH_KEEP(lsr);
+        for(int i = 0; i < PAIRS; ++i) {
+            const double d = ntp_to_double(now[i]) - ntp_to_double(lsr[i]);
+            sum += ntp_short(ntp_from_double(d));
+        }
+    }
+    bench_report("double diff + short", bench_now() - start,
+        (double)PAIRS * ROUNDS);
+    BENCH_KEEP(sum);
+
+    sum = 0;
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        BENCH_KEEP(now);
+        BENCH_KEEP(lsr);
+        for(int i = 0; i < PAIRS; ++i) {
+            sum += ntp64_short(ntp64_sub(
+                ntp64_from_tv(now[i]), ntp64_from_tv(lsr[i])));
+        }
+    }
+    bench_report("ntp64 diff + short", bench_now() - start,
+        (double)PAIRS * ROUNDS);
+    BENCH_KEEP(sum);
+
+    sum = 0;
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        BENCH_KEEP(now);
+        BENCH_KEEP(lsr);
+        for(int i = 0; i < PAIRS; ++i)
+            sum += ntp_short(ntp_diff(now[i], lsr[i]));
+    }
+    bench_report("ntp_diff + short", bench_now() - start,
+        (double)PAIRS * ROUNDS);
+    BENCH_KEEP(sum);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file bench_parse.c
+ * @brief Compare rtp_parse_batch() with per-packet rtp_header_parse() calls.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp_header.h"
+#include "rtp_packet_view.h"
+#include "bench.h"
+
+#define BATCH (64)
+#define ROUNDS (100000)
+#define PACKET_SIZE (172)
+
+int main(void)
+{
+    static uint8_t data[BATCH][PACKET_SIZE];
+    struct iovec iov[BATCH];
+
+    // Build a recvmmsg() sized batch of 20ms Opus-like packets.
+    rtp_header *header = rtp_header_create();
+    rtp_header_init(header, 96, 0x12345678, 1000, 48000);
+
+    for(int i = 0; i < BATCH; ++i) {
+        header->seq += 1;
+        header->ts += 960;
+
+        const int size = rtp_header_serialize(header, data[i], PACKET_SIZE);
+        memset(data[i] + size, i, PACKET_SIZE - (size_t)size);
+
+        iov[i].iov_base = data[i];
+        iov[i].iov_len = PACKET_SIZE;
+    }
+
+    rtp_header_free(header);
+
+    // Baseline: one rtp_header_parse() per datagram, as in pa_receive.
+    double start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < BATCH; ++i) {
+            rtp_header *h = rtp_header_create();
+            rtp_header_parse(h, iov[i].iov_base, iov[i].iov_len);
+            BENCH_KEEP(h->seq);
+            rtp_header_free(h);
+        }
+    }
+    bench_report("rtp_header_parse", bench_now() - start,
+        (double)ROUNDS * BATCH);
+
+    // Views parsed one at a time.
+    rtp_packet_view views[BATCH];
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < BATCH; ++i) {
+            rtp_packet_view_parse(&views[i], iov[i].iov_base, iov[i].iov_len);
+            BENCH_KEEP(views[i].seq);
+        }
+    }
+    bench_report("rtp_packet_view_parse", bench_now() - start,
+        (double)ROUNDS * BATCH);
+
+    // Whole vector at once.
+    uint8_t status[BATCH];
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        size_t valid = rtp_parse_batch(iov, BATCH, views, status);
+        BENCH_KEEP(valid);
+    }
+    bench_report("rtp_parse_batch", bench_now() - start,
+        (double)ROUNDS * BATCH);
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file bench_seq.c
+ * @brief Compare per-packet and batched sequence number validation.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp_source.h"
+#include "bench.h"
+
+#define PACKETS (1 << 16)
+#define BATCH (32)
+#define ROUNDS (64)
+
+/**
+ * @brief Validate the stream per packet and in batches.
+ */
+static void run(const char *name, const uint16_t *seqs)
+{
+    char label[64];
+    rtp_source s;
+
+    memset(&s, 0, sizeof(s));
+    rtp_source_init(&s, 0x1234, seqs[0]);
+
+    double start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < PACKETS; ++i)
+            BENCH_KEEP(rtp_source_update_seq(&s, seqs[i]));
+    }
+    snprintf(label, sizeof(label), "%s, update_seq", name);
+    bench_report(label, bench_now() - start, (double)PACKETS * ROUNDS);
+
+    memset(&s, 0, sizeof(s));
+    rtp_source_init(&s, 0x1234, seqs[0]);
+
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < PACKETS; i += BATCH)
+            BENCH_KEEP(rtp_source_update_seq_batch(&s, &seqs[i], BATCH));
+    }
+    snprintf(label, sizeof(label), "%s, update_seq_batch", name);
+    bench_report(label, bench_now() - start, (double)PACKETS * ROUNDS);
+}
+
+int main(void)
+{
+    static uint16_t seqs[PACKETS];
+
+    // The sequence repeats every round, a whole number of wraps
+    for(int i = 0; i < PACKETS; ++i)
+        seqs[i] = (uint16_t)i;
+    run("in order", seqs);
+
+    srand(1234);
+    uint16_t next = 0;
+    for(int i = 0; i < PACKETS; ++i) {
+        if(rand() % 100 == 0)
+            next += 1;
+        seqs[i] = next++;
+    }
+    run("1% loss", seqs);
+
+    return 0;
+}
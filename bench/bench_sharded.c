@@ -0,0 +1,146 @@
+/**
+ * @file bench_sharded.c
+ * @brief Receive throughput of the sharded engine from 1 to N shards.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "rtp_header.h"
+#include "rtp_source.h"
+#include "rtp_transport_sharded.h"
+#include "bench.h"
+
+#define SOURCES (256)
+#define BATCH (32)
+#define PACKET_SIZE (172)
+#define DURATION_NS (300e6)
+
+/**
+ * @brief Per-shard state, padded so shards never share a cache line.
+ */
+typedef struct shard_state {
+    uint64_t received;
+    rtp_source sources[SOURCES];
+    char pad[64];
+} shard_state;
+
+static shard_state states[LIBRTP_MAX_SHARDS];
+static volatile int sending;
+
+static void handle(
+    void *ctx, unsigned int shard, rtp_transport_udp_packet *packets, size_t n)
+{
+    (void)ctx;
+
+    // SSRC affinity means per-source state is only touched by this thread
+    shard_state *state = &states[shard];
+    for(size_t i = 0; i < n; ++i) {
+        const rtp_packet_view *view = &packets[i].view;
+        rtp_source_update_seq(&state->sources[view->ssrc % SOURCES], view->seq);
+    }
+
+    state->received += n;
+}
+
+static void *send_main(void *arg)
+{
+    const struct sockaddr_in *addr = (const struct sockaddr_in*)arg;
+
+    static uint8_t data[SOURCES][PACKET_SIZE];
+    rtp_header *header = rtp_header_create();
+    for(int i = 0; i < SOURCES; ++i) {
+        rtp_header_init(header, 96, (uint32_t)i, 0, 0);
+        rtp_header_serialize(header, data[i], PACKET_SIZE);
+    }
+    rtp_header_free(header);
+
+    rtp_transport_udp *tx = rtp_transport_udp_create(AF_INET, NULL);
+    rtp_transport_udp_connect(tx, (const struct sockaddr*)addr, sizeof(*addr));
+
+    struct iovec iov[BATCH];
+    int next = 0;
+    while(sending) {
+        for(int i = 0; i < BATCH; ++i) {
+            iov[i].iov_base = data[next];
+            iov[i].iov_len = PACKET_SIZE;
+            next = (next + 1) % SOURCES;
+        }
+
+        rtp_transport_udp_send(tx, iov, BATCH);
+    }
+
+    rtp_transport_udp_free(tx);
+    return NULL;
+}
+
+int main(void)
+{
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    const size_t max_shards = (cpus > 4) ? (size_t)cpus : 4;
+    printf("%ld online CPUs\n", cpus);
+
+    for(size_t shards = 1; shards <= max_shards; shards *= 2) {
+        memset(states, 0, sizeof(states));
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        // Find a free port for the group
+        const int probe = socket(AF_INET, SOCK_DGRAM, 0);
+        socklen_t len = sizeof(addr);
+        bind(probe, (struct sockaddr*)&addr, sizeof(addr));
+        getsockname(probe, (struct sockaddr*)&addr, &len);
+        close(probe);
+
+        rtp_transport_sharded_config config;
+        memset(&config, 0, sizeof(config));
+        config.shards = shards;
+        config.ssrc_affinity = 1;
+        config.pin = 1;
+        config.handler = handle;
+
+        rtp_transport_sharded *t = rtp_transport_sharded_create(
+            AF_INET, (struct sockaddr*)&addr, sizeof(addr), &config);
+
+        if(!t) {
+            printf("failed to create %zu shards\n", shards);
+            return 1;
+        }
+
+        rtp_transport_sharded_start(t);
+
+        sending = 1;
+        pthread_t sender;
+        pthread_create(&sender, NULL, send_main, &addr);
+
+        const double start = bench_now();
+        while(bench_now() - start < DURATION_NS)
+            usleep(1000);
+
+        sending = 0;
+        pthread_join(sender, NULL);
+        rtp_transport_sharded_stop(t);
+        const double elapsed = bench_now() - start;
+
+        uint64_t received = 0;
+        for(size_t i = 0; i < shards; ++i)
+            received += states[i].received;
+
+        char name[32];
+        snprintf(name, sizeof(name), "%zu shards", shards);
+        bench_report(name, elapsed, (double)received);
+
+        rtp_transport_sharded_free(t);
+    }
+
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file bench_source_table.c
+ * @brief Compare SSRC lookup in a source table with a linear list.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp_source_table.h"
+#include "bench.h"
+
+#define SOURCES (2000)
+#define LOOKUPS (1 << 20)
+
+int main(void)
+{
+    static uint32_t ssrcs[SOURCES];
+    static uint32_t order[LOOKUPS];
+
+    srand(1234);
+    for(int i = 0; i < SOURCES; ++i)
+        ssrcs[i] = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+
+    for(int i = 0; i < LOOKUPS; ++i)
+        order[i] = ssrcs[rand() % SOURCES];
+
+    // Baseline: a linear list of sources scanned per packet
+    static rtp_source list[SOURCES];
+    for(int i = 0; i < SOURCES; ++i)
+        rtp_source_init(&list[i], ssrcs[i], 0);
+
+    double start = bench_now();
+    for(int i = 0; i < LOOKUPS; ++i) {
+        rtp_source *s = NULL;
+        for(int j = 0; j < SOURCES; ++j) {
+            if(list[j].id == order[i]) {
+                s = &list[j];
+                break;
+            }
+        }
+        BENCH_KEEP(s);
+    }
+    bench_report("linear scan (2000 sources)", bench_now() - start, LOOKUPS);
+
+    rtp_source_table *t = rtp_source_table_create(SOURCES);
+    for(int i = 0; i < SOURCES; ++i)
+        rtp_source_table_insert(t, ssrcs[i], 0);
+
+    start = bench_now();
+    for(int i = 0; i < LOOKUPS; ++i) {
+        rtp_source *s = rtp_source_table_find(t, order[i]);
+        BENCH_KEEP(s);
+    }
+    bench_report("rtp_source_table_find", bench_now() - start, LOOKUPS);
+
+    start = bench_now();
+    for(int i = 0; i < LOOKUPS; ++i) {
+        rtp_source *s = NULL;
+        rtp_source_table_receive(t, order[i], 0, NULL, 0, &s);
+        BENCH_KEEP(s);
+    }
+    bench_report("rtp_source_table_receive", bench_now() - start, LOOKUPS);
+
+    rtp_source_table_free(t);
+    return 0;
+}
@@ -0,0 +1,65 @@
+/**
+ * @file bench_template.c
+ * @brief Compare rtp_header_template_write() with rtp_header_serialize().
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp_header.h"
+#include "rtp_header_template.h"
+#include "bench.h"
+
+#define ROUNDS (10000000)
+
+int main(void)
+{
+    static uint8_t buffer[1500];
+
+    // A mixer stream: two contributing sources and a one word extension.
+    const uint32_t ext[1] = { 0x10ff0000 };
+
+    rtp_header *header = rtp_header_create();
+    rtp_header_init(header, 96, 0x12345678, 1000, 48000);
+    rtp_header_add_csrc(header, 0x11111111);
+    rtp_header_add_csrc(header, 0x22222222);
+    header->x = 1;
+    rtp_header_set_ext(header, 0xbede, ext, 1);
+
+    // Baseline: serialize the whole header per packet, as in pa_transmit.
+    double start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        header->seq += 1;
+        header->ts += 960;
+        int size = rtp_header_serialize(header, buffer, sizeof(buffer));
+        BENCH_KEEP(size);
+    }
+    const double serialize = bench_now() - start;
+    bench_report("rtp_header_serialize", serialize, ROUNDS);
+
+    rtp_header_template tmpl;
+    rtp_header_template_init(&tmpl, header);
+
+    uint16_t seq = 1000;
+    uint32_t ts = 48000;
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        seq += 1;
+        ts += 960;
+        int size = rtp_header_template_write(
+            &tmpl, buffer, sizeof(buffer), 0, seq, ts);
+        BENCH_KEEP(size);
+    }
+    const double write = bench_now() - start;
+    bench_report("rtp_header_template_write", write, ROUNDS);
+
+    // The target is 5x, see the README
+    const double speedup = serialize / write;
+    printf("speedup %.1fx (target 5.0x%s)\n",
+        speedup, (speedup >= 5.0) ? "" : ", not met");
+
+    rtp_header_free(header);
+    return 0;
+}
@@ -0,0 +1,152 @@
+/**
+ * @file bench_timer.c
+ * @brief Compare timer churn in a timer wheel with a binary heap.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+
+#include "rtp_timer_wheel.h"
+#include "bench.h"
+
+#define TIMERS (1 << 20)
+#define OPS (1 << 22)
+#define OPS_PER_TICK (64)
+#define MAX_DELAY (1 << 16)
+
+static uint32_t timer_index[OPS];
+static uint32_t delay[OPS];
+static size_t next_delay;
+
+/**
+ * @brief Returns the next delay from the shared sequence.
+ */
+static uint64_t draw_delay(void)
+{
+    const uint64_t d = delay[next_delay];
+    next_delay = (next_delay + 1) % OPS;
+    return d;
+}
+
+/**
+ * @brief Baseline: indexed binary min-heap, as a priority queue of timers.
+ */
+static uint64_t heap_key[TIMERS];
+static uint32_t heap[TIMERS];
+static uint32_t heap_pos[TIMERS];
+
+static void heap_swap(uint32_t a, uint32_t b)
+{
+    const uint32_t tmp = heap[a];
+    heap[a] = heap[b];
+    heap[b] = tmp;
+    heap_pos[heap[a]] = a;
+    heap_pos[heap[b]] = b;
+}
+
+static void heap_update(uint32_t timer, uint64_t key)
+{
+    heap_key[timer] = key;
+
+    uint32_t i = heap_pos[timer];
+    while(i > 0 && heap_key[heap[(i - 1) / 2]] > heap_key[heap[i]]) {
+        heap_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+
+    for(;;) {
+        uint32_t min = i;
+        const uint32_t l = 2 * i + 1;
+        const uint32_t r = 2 * i + 2;
+        if(l < TIMERS && heap_key[heap[l]] < heap_key[heap[min]])
+            min = l;
+        if(r < TIMERS && heap_key[heap[r]] < heap_key[heap[min]])
+            min = r;
+        if(min == i)
+            break;
+
+        heap_swap(i, min);
+        i = min;
+    }
+}
+
+static size_t fired;
+static rtp_timer_wheel *wheel;
+
+static void rearm(void *ctx, rtp_timer *timer)
+{
+    (void)ctx;
+    fired += 1;
+    rtp_timer_wheel_add(
+        wheel, timer, rtp_timer_wheel_now(wheel) + draw_delay());
+}
+
+int main(void)
+{
+    srand(1234);
+    for(int i = 0; i < OPS; ++i) {
+        timer_index[i] = (uint32_t)rand() % TIMERS;
+        delay[i] = 1 + (uint32_t)rand() % MAX_DELAY;
+    }
+
+    // Each op moves a random timer, as a received packet moves a source
+    // timeout, and time advances one tick every OPS_PER_TICK ops
+    uint64_t now = 0;
+    next_delay = 0;
+    for(uint32_t i = 0; i < TIMERS; ++i) {
+        heap[i] = i;
+        heap_pos[i] = i;
+        heap_key[i] = 0;
+    }
+    for(uint32_t i = 0; i < TIMERS; ++i)
+        heap_update(i, draw_delay());
+
+    fired = 0;
+    double start = bench_now();
+    for(int i = 0; i < OPS; ++i) {
+        heap_update(timer_index[i], now + draw_delay());
+        if((i + 1) % OPS_PER_TICK == 0) {
+            now += 1;
+            while(heap_key[heap[0]] <= now) {
+                fired += 1;
+                heap_update(heap[0], now + draw_delay());
+            }
+        }
+    }
+    bench_report("binary heap (1M timers)", bench_now() - start, OPS);
+    BENCH_KEEP(fired);
+
+    static rtp_timer timers[TIMERS];
+    wheel = rtp_timer_wheel_create(0);
+    next_delay = 0;
+    for(uint32_t i = 0; i < TIMERS; ++i) {
+        rtp_timer_init(&timers[i], rearm, NULL);
+        rtp_timer_wheel_add(wheel, &timers[i], draw_delay());
+    }
+
+    now = 0;
+    fired = 0;
+    start = bench_now();
+    for(int i = 0; i < OPS; ++i) {
+        rtp_timer_wheel_add(wheel, &timers[timer_index[i]], now + draw_delay());
+        if((i + 1) % OPS_PER_TICK == 0) {
+            now += 1;
+            rtp_timer_wheel_advance(wheel, now);
+        }
+    }
+    bench_report("rtp_timer_wheel (1M timers)", bench_now() - start, OPS);
+    BENCH_KEEP(fired);
+
+    // Cancel and re-add, as sources leave and join
+    start = bench_now();
+    for(int i = 0; i < OPS; ++i) {
+        rtp_timer *timer = &timers[timer_index[i]];
+        rtp_timer_wheel_cancel(wheel, timer);
+        rtp_timer_wheel_add(wheel, timer, now + delay[i]);
+    }
+    bench_report("rtp_timer_wheel cancel/add", bench_now() - start, OPS);
+
+    rtp_timer_wheel_free(wheel);
+    return 0;
+}
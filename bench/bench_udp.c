@@ -0,0 +1,120 @@
+/**
+ * @file bench_udp.c
+ * @brief Compare the batched UDP transport with per-packet sendto/recvfrom.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "rtp_header.h"
+#include "rtp_transport_udp.h"
+#include "bench.h"
+
+#define BATCH (32)
+#define ROUNDS (20000)
+#define PACKET_SIZE (172)
+
+static struct sockaddr_in loopback(void)
+{
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    return addr;
+}
+
+int main(void)
+{
+    static uint8_t data[BATCH][PACKET_SIZE];
+    struct iovec iov[BATCH];
+
+    rtp_header *header = rtp_header_create();
+    rtp_header_init(header, 96, 0x12345678, 1000, 48000);
+    for(int i = 0; i < BATCH; ++i) {
+        header->seq += 1;
+        rtp_header_serialize(header, data[i], PACKET_SIZE);
+        iov[i].iov_base = data[i];
+        iov[i].iov_len = PACKET_SIZE;
+    }
+    rtp_header_free(header);
+
+    // Baseline: one system call per packet in each direction, as in the
+    // examples.
+    struct sockaddr_in addr = loopback();
+    socklen_t len = sizeof(addr);
+
+    int rx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    int tx_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    bind(rx_fd, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(rx_fd, (struct sockaddr*)&addr, &len);
+
+    uint64_t syscalls = 0;
+    uint8_t buffer[2048];
+    double start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < BATCH; ++i) {
+            sendto(tx_fd, data[i], PACKET_SIZE, 0,
+                (struct sockaddr*)&addr, sizeof(addr));
+        }
+
+        for(int i = 0; i < BATCH; ++i) {
+            ssize_t size = recvfrom(rx_fd, buffer, sizeof(buffer), 0, NULL, 0);
+            BENCH_KEEP(size);
+        }
+
+        syscalls += 2 * BATCH;
+    }
+    bench_report("sendto/recvfrom", bench_now() - start,
+        (double)ROUNDS * BATCH);
+    printf("  %.3f syscalls/packet\n", (double)syscalls / (ROUNDS * BATCH));
+
+    close(rx_fd);
+    close(tx_fd);
+
+    // Batched transport.
+    rtp_transport_udp_config config;
+    memset(&config, 0, sizeof(config));
+    config.batch = BATCH;
+
+    rtp_transport_udp *rx = rtp_transport_udp_create(AF_INET, &config);
+    rtp_transport_udp *tx = rtp_transport_udp_create(AF_INET, &config);
+
+    addr = loopback();
+    len = sizeof(addr);
+    rtp_transport_udp_bind(rx, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(rtp_transport_udp_fd(rx), (struct sockaddr*)&addr, &len);
+    rtp_transport_udp_connect(tx, (struct sockaddr*)&addr, sizeof(addr));
+
+    rtp_transport_udp_packet packets[BATCH];
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        rtp_transport_udp_send(tx, iov, BATCH);
+
+        int received = 0;
+        while(received < BATCH) {
+            const int n = rtp_transport_udp_recv(rx, packets, BATCH);
+            if(n < 0)
+                break;
+
+            received += n;
+        }
+    }
+    const double elapsed = bench_now() - start;
+    bench_report("rtp_transport_udp", elapsed, (double)ROUNDS * BATCH);
+
+    rtp_transport_udp_stats rx_stats, tx_stats;
+    rtp_transport_udp_get_stats(rx, &rx_stats);
+    rtp_transport_udp_get_stats(tx, &tx_stats);
+    printf("  %.3f syscalls/packet\n",
+        (double)(rx_stats.rx_syscalls + tx_stats.tx_syscalls)
+        / (double)rx_stats.rx_packets);
+
+    rtp_transport_udp_free(rx);
+    rtp_transport_udp_free(tx);
+    return 0;
+}
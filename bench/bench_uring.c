@@ -0,0 +1,152 @@
+/**
+ * @file bench_uring.c
+ * @brief Compare the io_uring transport with an epoll loop over many sockets.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "rtp_header.h"
+#include "rtp_transport_uring.h"
+#include "bench.h"
+
+#define SOCKETS (64)
+#define ROUNDS (10000)
+#define PACKET_SIZE (172)
+
+/**
+ * @brief Open SOCKETS receivers and a connected sender for each.
+ */
+static void open_sockets(int *rx_fd, int *tx_fd)
+{
+    for(int i = 0; i < SOCKETS; ++i) {
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        socklen_t len = sizeof(addr);
+        rx_fd[i] = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        bind(rx_fd[i], (struct sockaddr*)&addr, sizeof(addr));
+        getsockname(rx_fd[i], (struct sockaddr*)&addr, &len);
+
+        tx_fd[i] = socket(AF_INET, SOCK_DGRAM, 0);
+        connect(tx_fd[i], (struct sockaddr*)&addr, sizeof(addr));
+    }
+}
+
+static void close_sockets(int *rx_fd, int *tx_fd)
+{
+    for(int i = 0; i < SOCKETS; ++i) {
+        close(rx_fd[i]);
+        close(tx_fd[i]);
+    }
+}
+
+int main(void)
+{
+    uint8_t data[PACKET_SIZE];
+    memset(data, 0, sizeof(data));
+
+    rtp_header *header = rtp_header_create();
+    rtp_header_init(header, 96, 0x12345678, 1000, 48000);
+    rtp_header_serialize(header, data, sizeof(data));
+    rtp_header_free(header);
+
+    int rx_fd[SOCKETS], tx_fd[SOCKETS];
+
+    // Baseline: epoll readiness, then one recvfrom() per datagram and one
+    // send() per datagram.
+    open_sockets(rx_fd, tx_fd);
+
+    const int ep = epoll_create1(0);
+    for(int i = 0; i < SOCKETS; ++i) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.fd = rx_fd[i];
+        epoll_ctl(ep, EPOLL_CTL_ADD, rx_fd[i], &ev);
+    }
+
+    uint64_t syscalls = 0;
+    uint8_t buffer[2048];
+    struct epoll_event events[SOCKETS];
+    double start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < SOCKETS; ++i)
+            send(tx_fd[i], data, sizeof(data), 0);
+
+        syscalls += SOCKETS;
+
+        int received = 0;
+        while(received < SOCKETS) {
+            const int n = epoll_wait(ep, events, SOCKETS, -1);
+            syscalls += 1;
+
+            for(int i = 0; i < n; ++i) {
+                const ssize_t size = recvfrom(events[i].data.fd,
+                    buffer, sizeof(buffer), 0, NULL, NULL);
+
+                syscalls += 1;
+                if(size > 0)
+                    received += 1;
+
+                BENCH_KEEP(size);
+            }
+        }
+    }
+    bench_report("epoll + recvfrom/send", bench_now() - start,
+        (double)ROUNDS * SOCKETS);
+    printf("  %.3f syscalls/packet\n", (double)syscalls / (ROUNDS * SOCKETS));
+
+    close(ep);
+    close_sockets(rx_fd, tx_fd);
+
+    // io_uring transport.
+    rtp_transport_uring *t = rtp_transport_uring_create(NULL);
+    if(!t) {
+        printf("io_uring unavailable\n");
+        return 0;
+    }
+
+    open_sockets(rx_fd, tx_fd);
+
+    int tx[SOCKETS];
+    for(int i = 0; i < SOCKETS; ++i) {
+        rtp_transport_uring_add(t, rx_fd[i]);
+        tx[i] = rtp_transport_uring_add(t, tx_fd[i]);
+    }
+
+    struct iovec iov = { data, sizeof(data) };
+    rtp_transport_uring_packet packets[SOCKETS];
+    start = bench_now();
+    for(int r = 0; r < ROUNDS; ++r) {
+        for(int i = 0; i < SOCKETS; ++i)
+            rtp_transport_uring_send(t, tx[i], &iov, 1);
+
+        int received = 0;
+        while(received < SOCKETS) {
+            const int n = rtp_transport_uring_recv(t, packets, SOCKETS);
+            if(n < 0)
+                break;
+
+            received += n;
+        }
+    }
+    const double elapsed = bench_now() - start;
+    bench_report("rtp_transport_uring", elapsed, (double)ROUNDS * SOCKETS);
+
+    rtp_transport_uring_stats stats;
+    rtp_transport_uring_get_stats(t, &stats);
+    printf("  %.3f syscalls/packet\n",
+        (double)stats.syscalls / (double)stats.rx_packets);
+
+    rtp_transport_uring_free(t);
+    close_sockets(rx_fd, tx_fd);
+    return 0;
+}
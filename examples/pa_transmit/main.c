@@ -22,6 +22,8 @@
 #include <pulse/error.h>
 
 #include "rtp_header.h"
+#include "rtp_header_template.h"
+#include "rtp_random.h"
 
 #define DEFAULT_HOST "127.0.0.1"
 #define DEFAULT_PORT (5002)
@@ -166,8 +168,19 @@ int main(int argc, char *argv[])
     // Create the RTP packet structure.
     // For a dynamic payload set PT to any number [96-127].
     // The values for SSRC, timestamp, and sequence should be randomly assigned.
+    rtp_random *rng = rtp_random_thread();
     rtp_header *header = rtp_header_create();
-    rtp_header_init(header, 96, rand(), rand(), rand());
+    rtp_header_init(header, 96, rtp_random_ssrc(rng), rtp_random_seq(rng),
+        rtp_random_ts(rng));
+
+    // Render the constant parts of the header once. Only the sequence number
+    // and timestamp change from packet to packet.
+    rtp_header_template tmpl;
+    rtp_header_template_init(&tmpl, header);
+
+    uint16_t seq = header->seq;
+    uint32_t ts = header->ts;
+    rtp_header_free(header);
 
     /* Create a Linux Datagram socket for sending UDP packets. Replace this
      * with your platform's transport layer.
@@ -234,9 +247,10 @@ int main(int argc, char *argv[])
         }
 
         // Add the RTP header
-        header->seq += 1;
-        header->ts += frame_samples;
-        int header_size = rtp_header_serialize(header, data, sizeof(data));
+        seq += 1;
+        ts += frame_samples;
+        int header_size = rtp_header_template_write(
+            &tmpl, data, sizeof(data), 0, seq, ts);
 
         // Encode the frame with Opus
         int size = opus_encode(enc, frame, frame_samples,
@@ -22,6 +22,145 @@ typedef struct ntp_tv {
     uint32_t frac;      /**< Fractional seconds (2^32). */
 } ntp_tv;
 
+/**
+ * @brief NTP timestamp as 32.32 fixed point, seconds in the upper word.
+ *
+ * Arithmetic is modulo 2^64, so differences stay exact across the era
+ * rollover in 2036 as long as the timestamps are within 68 years.
+ */
+typedef uint64_t ntp64;
+
+/**
+ * @brief Converts an NTP timeval to fixed point.
+ *
+ * @param [in] ntp - NTP timestamp.
+ * @return ntp64
+ */
+static inline ntp64 ntp64_from_tv(ntp_tv ntp)
+{
+    return ((uint64_t)ntp.sec << 32) | ntp.frac;
+}
+
+/**
+ * @brief Converts a fixed point NTP timestamp to a timeval.
+ *
+ * @param [in] t - NTP timestamp.
+ * @return ntp_tv
+ */
+static inline ntp_tv ntp64_to_tv(ntp64 t)
+{
+    ntp_tv ntp;
+    ntp.sec = (uint32_t)(t >> 32);
+    ntp.frac = (uint32_t)t;
+    return ntp;
+}
+
+/**
+ * @brief Returns a + b.
+ *
+ * @param [in] a - timestamp or duration.
+ * @param [in] b - duration.
+ */
+static inline ntp64 ntp64_add(ntp64 a, ntp64 b)
+{
+    return a + b;
+}
+
+/**
+ * @brief Returns a - b.
+ *
+ * @param [in] a - timestamp.
+ * @param [in] b - earlier timestamp.
+ */
+static inline ntp64 ntp64_sub(ntp64 a, ntp64 b)
+{
+    return a - b;
+}
+
+/**
+ * @brief Compare two timestamps less than 68 years apart.
+ *
+ * @param [in] a - first timestamp.
+ * @param [in] b - second timestamp.
+ * @return negative, zero or positive as a is before, at or after b.
+ */
+static inline int ntp64_cmp(ntp64 a, ntp64 b)
+{
+    const int64_t d = (int64_t)(a - b);
+    return (d > 0) - (d < 0);
+}
+
+/**
+ * @brief Returns the middle 32 bits of a timestamp, 16.16 fixed point.
+ *
+ * @see IETF RFC3550 "last SR timestamp (LSR)" (§6.4.1)
+ *
+ * @param [in] t - NTP timestamp.
+ */
+static inline uint32_t ntp64_short(ntp64 t)
+{
+    return (uint32_t)(t >> 16);
+}
+
+/**
+ * @brief Converts a 16.16 short format value to a 32.32 duration.
+ *
+ * @param [in] s - short format value.
+ */
+static inline ntp64 ntp64_from_short(uint32_t s)
+{
+    return (ntp64)s << 16;
+}
+
+/**
+ * @brief Converts nanoseconds to fixed point, rounding down.
+ *
+ * @param [in] ns - nanoseconds.
+ * @return ntp64
+ */
+static inline ntp64 ntp64_from_ns(uint64_t ns)
+{
+    const uint64_t sec = ns / 1000000000u;
+    const uint64_t rem = ns % 1000000000u;
+    return (sec << 32) + ((rem << 32) / 1000000000u);
+}
+
+/**
+ * @brief Converts fixed point to nanoseconds, rounding down.
+ *
+ * @param [in] t - NTP timestamp or duration.
+ * @return nanoseconds.
+ */
+static inline uint64_t ntp64_to_ns(ntp64 t)
+{
+    return (t >> 32) * 1000000000u
+        + (((t & 0xffffffffu) * 1000000000u) >> 32);
+}
+
+/**
+ * @brief Returns the round-trip time from a report block, short format.
+ *
+ * RTT = A - LSR - DLSR, where A is the short form of the arrival time of
+ * the report. Clock offsets can make the result negative, which is
+ * clamped to zero.
+ *
+ * @see IETF RFC3550 "Sender and Receiver Reports" (§6.4.1)
+ *
+ * @param [in] arrival - short format arrival time of the report.
+ * @param [in] lsr - LSR field of the report block.
+ * @param [in] dlsr - DLSR field of the report block.
+ * @return round-trip time in 1/65536 seconds, or 0 if lsr is 0.
+ */
+static inline uint32_t ntp_short_rtt(
+    uint32_t arrival, uint32_t lsr, uint32_t dlsr)
+{
+    if(lsr == 0)
+        return 0;
+
+    const int32_t rtt = (int32_t)(arrival - lsr - dlsr);
+    return (rtt > 0) ? (uint32_t)rtt : 0;
+}
+
 /**
  * @brief Converts an NTP timestamp to its double representation.
  *
@@ -65,6 +204,8 @@ uint32_t ntp_short(ntp_tv ntp);
 /**
  * @brief Returns the difference between two NTP timestamps.
  *
+ * Exact, modulo 2^32 seconds, see ntp64_sub().
+ *
  * @param [in] a - first timestamp.
  * @param [in] b - second timestamp.
  * @return ntp time difference (a - b).
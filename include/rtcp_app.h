@@ -32,6 +32,7 @@
 #define LIBRTP_RTCP_APP_H_
 
 #include "rtcp_header.h"
+#include "rtp_alloc.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -46,6 +47,7 @@ typedef struct rtcp_app {
     uint32_t name;          /**< Packet name (ASCII). */
     size_t app_size;        /**< Size of the application data in bytes. */
     void *app_data;         /**< Application data. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
 } rtcp_app;
 
 /**
@@ -55,6 +57,16 @@ typedef struct rtcp_app {
  */
 rtcp_app *rtcp_app_create(void);
 
+/**
+ * @brief Allocate a new APP packet using a specific allocator.
+ *
+ * The packet and everything it owns is allocated from the given allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return packet.
+ */
+rtcp_app *rtcp_app_create_with_allocator(const rtp_allocator *allocator);
+
 /**
  * @brief Free an APP packet.
  *
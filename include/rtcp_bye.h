@@ -31,6 +31,7 @@
 #define LIBRTP_RTCP_BYE_H_
 
 #include "rtcp_header.h"
+#include "rtp_alloc.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -43,6 +44,7 @@ typedef struct rtcp_bye {
     rtcp_header header;     /**< RTCP header. */
     uint32_t *src_ids;      /**< Source identifiers. */
     char *message;          /**< Reason for leaving. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
 } rtcp_bye;
 
 /**
@@ -52,6 +54,16 @@ typedef struct rtcp_bye {
  */
 rtcp_bye *rtcp_bye_create(void);
 
+/**
+ * @brief Allocate a new BYE packet using a specific allocator.
+ *
+ * The packet and everything it owns is allocated from the given allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return packet.
+ */
+rtcp_bye *rtcp_bye_create_with_allocator(const rtp_allocator *allocator);
+
 /**
  * @brief Free a BYE packet.
  *
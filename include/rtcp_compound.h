@@ -0,0 +1,310 @@
+/**
+ * @file rtcp_compound.h
+ * @brief Compound RTCP packets.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtcp
+ */
+
+#ifndef LIBRTP_RTCP_COMPOUND_H_
+#define LIBRTP_RTCP_COMPOUND_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rtcp_header.h"
+#include "rtcp_report.h"
+#include "rtcp_sr.h"
+#include "rtcp_rr.h"
+#include "rtcp_sdes.h"
+#include "rtcp_bye.h"
+#include "rtcp_app.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Result codes for rtcp_compound_iter_init().
+ */
+typedef enum rtcp_compound_status {
+    RTCP_COMPOUND_OK        = 0,    /**< Datagram is valid. */
+    RTCP_COMPOUND_SHORT     = 1,    /**< Empty, unaligned or overrun. */
+    RTCP_COMPOUND_VERSION   = 2,    /**< A version is not 2. */
+    RTCP_COMPOUND_FIRST     = 3,    /**< First packet is not SR or RR. */
+    RTCP_COMPOUND_PADDING   = 4,    /**< Padding not on the last packet. */
+    RTCP_COMPOUND_FORMAT    = 5     /**< Contents do not fit the length. */
+} rtcp_compound_status;
+
+/**
+ * @brief Sender or receiver report view.
+ */
+typedef struct rtcp_report_view {
+    uint32_t ssrc;              /**< Source identifier. */
+    uint32_t ntp_sec;           /**< NTP timestamp (SR only). */
+    uint32_t ntp_frac;          /**< NTP timestamp (SR only). */
+    uint32_t rtp_ts;            /**< RTP timestamp (SR only). */
+    uint32_t pkt_count;         /**< Sender's packet count (SR only). */
+    uint32_t byte_count;        /**< Sender's octet count (SR only). */
+    const uint8_t *reports;     /**< Report blocks, see rtcp_view_report(). */
+    const uint8_t *ext_data;    /**< Profile-specific extension or NULL. */
+    size_t ext_size;            /**< Size of the extension in bytes. */
+} rtcp_report_view;
+
+/**
+ * @brief Source description view.
+ */
+typedef struct rtcp_sdes_view {
+    const uint8_t *chunks;      /**< Chunks, see rtcp_view_next_chunk(). */
+    size_t size;                /**< Size of the chunks in bytes. */
+} rtcp_sdes_view;
+
+/**
+ * @brief Goodbye view.
+ */
+typedef struct rtcp_bye_view {
+    const uint8_t *src_ids;     /**< Source ids, see rtcp_view_bye_src(). */
+    const char *reason;         /**< Reason for leaving or NULL. */
+    uint8_t reason_length;      /**< Reason length, not null terminated. */
+} rtcp_bye_view;
+
+/**
+ * @brief Application-defined view.
+ */
+typedef struct rtcp_app_view {
+    uint32_t ssrc;              /**< Source identifier. */
+    uint32_t name;              /**< Packet name (ASCII). */
+    const uint8_t *app_data;    /**< Application data or NULL. */
+    size_t app_size;            /**< Size of the application data in bytes. */
+} rtcp_app_view;
+
+/**
+ * @brief Read-only view of one packet in a compound RTCP datagram.
+ *
+ * The fixed fields are decoded into the view and everything else is
+ * referenced in place. The body matching pt is filled, packet types this
+ * library does not know are only described by data and size.
+ */
+typedef struct rtcp_view {
+    uint8_t pt;                 /**< Packet type. */
+    uint8_t count;              /**< Count field, or the APP subtype. */
+    const uint8_t *data;        /**< Packet, starting at the header. */
+    size_t size;                /**< Packet size in bytes, less padding. */
+    union {
+        rtcp_report_view sr;    /**< RTCP_SR. */
+        rtcp_report_view rr;    /**< RTCP_RR, the sender info is zero. */
+        rtcp_sdes_view sdes;    /**< RTCP_SDES. */
+        rtcp_bye_view bye;      /**< RTCP_BYE. */
+        rtcp_app_view app;      /**< RTCP_APP. */
+    } body;                     /**< Typed contents. */
+} rtcp_view;
+
+/**
+ * @brief SDES chunk view.
+ */
+typedef struct rtcp_sdes_chunk_view {
+    uint32_t src;               /**< SSRC/CSRC. */
+    const uint8_t *items;       /**< Items, see rtcp_sdes_chunk_next_item(). */
+    size_t size;                /**< Size of the items in bytes, less END. */
+} rtcp_sdes_chunk_view;
+
+/**
+ * @brief SDES item view.
+ */
+typedef struct rtcp_sdes_item_view {
+    uint8_t type;               /**< Item type. */
+    uint8_t length;             /**< Data length, not null terminated. */
+    const char *data;           /**< Item data. */
+} rtcp_sdes_item_view;
+
+/**
+ * @brief Compound RTCP iterator.
+ */
+typedef struct rtcp_compound_iter {
+    const uint8_t *buffer;      /**< Datagram. */
+    size_t size;                /**< Datagram size, 0 if invalid. */
+    size_t offset;              /**< Offset of the next packet. */
+} rtcp_compound_iter;
+
+/**
+ * @brief Compound RTCP builder.
+ *
+ * Packets are written straight into the caller's buffer and each header
+ * length is kept current as the packet grows, so buffer[0..offset) is
+ * always a complete compound packet.
+ */
+typedef struct rtcp_compound_builder {
+    uint8_t *buffer;            /**< Output buffer. */
+    size_t size;                /**< Buffer size, at most the path MTU. */
+    size_t reserved;            /**< Bytes report blocks may not use. */
+    size_t offset;              /**< Bytes written. */
+    size_t report_packet;       /**< Offset of the SR/RR taking reports. */
+    int report_open;            /**< Whether report_packet takes reports. */
+    uint32_t ssrc;              /**< Reporter, for continuation RRs. */
+} rtcp_compound_builder;
+
+/**
+ * @brief Validate a compound RTCP datagram and start iterating over it.
+ *
+ * Walks the packets by their length fields and checks the compound rules
+ * and the structure of every SR, RR, SDES, BYE and APP packet before any
+ * packet is returned, so a datagram is either used whole or dropped. No
+ * memory is allocated and no data is copied.
+ *
+ * As in the reference code the first packet may not be padded, even when
+ * it is also the last.
+ *
+ * @see IETF RFC3550 "RTCP Header Validity Checks" (§A.2)
+ *
+ * @param [out] it - iterator to initialize.
+ * @param [in] buffer - datagram to read from.
+ * @param [in] size - datagram size.
+ * @return rtcp_compound_status, the iterator is empty unless RTCP_COMPOUND_OK.
+ */
+int rtcp_compound_iter_init(
+    rtcp_compound_iter *it, const uint8_t *buffer, size_t size);
+
+/**
+ * @brief Get the next packet of a compound RTCP datagram.
+ *
+ * @param [in,out] it - iterator to advance.
+ * @param [out] view - view to fill.
+ * @return 1 if a packet was read, 0 at the end of the datagram.
+ */
+int rtcp_compound_iter_next(rtcp_compound_iter *it, rtcp_view *view);
+
+/**
+ * @brief Read a report block from a SR or RR view.
+ *
+ * @param [in] view - view to read from.
+ * @param [in] index - report index, must be less than count.
+ * @param [out] report - report to fill.
+ */
+void rtcp_view_report(
+    const rtcp_view *view, uint8_t index, rtcp_report *report);
+
+/**
+ * @brief Read a source id from a BYE view.
+ *
+ * @param [in] view - view to read from.
+ * @param [in] index - source index, must be less than count.
+ * @return source id.
+ */
+uint32_t rtcp_view_bye_src(const rtcp_view *view, uint8_t index);
+
+/**
+ * @brief Get the next chunk of a SDES view.
+ *
+ * @param [in] view - view to read from.
+ * @param [in,out] offset - cursor, 0 for the first chunk.
+ * @param [out] chunk - chunk to fill.
+ * @return 1 if a chunk was read, 0 after the last chunk.
+ */
+int rtcp_view_next_chunk(
+    const rtcp_view *view, size_t *offset, rtcp_sdes_chunk_view *chunk);
+
+/**
+ * @brief Get the next item of a SDES chunk.
+ *
+ * @param [in] chunk - chunk to read from.
+ * @param [in,out] offset - cursor, 0 for the first item.
+ * @param [out] item - item to fill.
+ * @return 1 if an item was read, 0 after the last item.
+ */
+int rtcp_sdes_chunk_next_item(
+    const rtcp_sdes_chunk_view *chunk,
+    size_t *offset,
+    rtcp_sdes_item_view *item);
+
+/**
+ * @brief Start building a compound RTCP packet.
+ *
+ * @param [out] b - builder to initialize.
+ * @param [out] buffer - buffer to write to.
+ * @param [in] size - buffer size, at most the path MTU.
+ */
+void rtcp_compound_builder_init(
+    rtcp_compound_builder *b, uint8_t *buffer, size_t size);
+
+/**
+ * @brief Hold back space from the report blocks.
+ *
+ * Report blocks stop this many bytes short of the end of the buffer,
+ * leaving room for the SDES, BYE or APP packets that follow them.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] bytes - bytes to hold back.
+ */
+void rtcp_compound_builder_reserve(rtcp_compound_builder *b, size_t bytes);
+
+/**
+ * @brief Append a sender report.
+ *
+ * Writes the sender info and as many of the packet's report blocks as fit
+ * (see rtcp_compound_add_reports()). An extension is written after the
+ * report blocks and is never split, further reports go to a new RR.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] packet - packet to append.
+ * @return number of report blocks written or -1 if the packet does not fit.
+ */
+int rtcp_compound_add_sr(rtcp_compound_builder *b, const rtcp_sr *packet);
+
+/**
+ * @brief Append a receiver report.
+ *
+ * @see rtcp_compound_add_sr()
+ *
+ * @param [in,out] b - builder.
+ * @param [in] packet - packet to append.
+ * @return number of report blocks written or -1 if the packet does not fit.
+ */
+int rtcp_compound_add_rr(rtcp_compound_builder *b, const rtcp_rr *packet);
+
+/**
+ * @brief Append report blocks to the last SR/RR.
+ *
+ * Once a packet holds 31 blocks, the limit of the count field, another RR
+ * from the same reporter is started. Blocks that would overrun the buffer,
+ * less the reserved space, are left for the next compound packet.
+ *
+ * @param [in,out] b - builder, an SR or RR must have been added.
+ * @param [in] reports - report blocks.
+ * @param [in] count - number of report blocks.
+ * @return number of report blocks written.
+ */
+size_t rtcp_compound_add_reports(
+    rtcp_compound_builder *b, const rtcp_report *reports, size_t count);
+
+/**
+ * @brief Append a source description.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] packet - packet to append.
+ * @return number of bytes written or -1 if the packet does not fit.
+ */
+int rtcp_compound_add_sdes(rtcp_compound_builder *b, const rtcp_sdes *packet);
+
+/**
+ * @brief Append a goodbye.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] packet - packet to append.
+ * @return number of bytes written or -1 if the packet does not fit.
+ */
+int rtcp_compound_add_bye(rtcp_compound_builder *b, const rtcp_bye *packet);
+
+/**
+ * @brief Append an application-defined packet.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] packet - packet to append.
+ * @return number of bytes written or -1 if the packet does not fit.
+ */
+int rtcp_compound_add_app(rtcp_compound_builder *b, const rtcp_app *packet);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTCP_COMPOUND_H_
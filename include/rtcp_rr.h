@@ -47,6 +47,7 @@
 
 #include "rtcp_header.h"
 #include "rtcp_report.h"
+#include "rtp_alloc.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -61,6 +62,7 @@ typedef struct rtcp_rr {
     rtcp_report *reports;   /**< Reports. */
     size_t ext_size;        /**< Size of the extension data in bytes. */
     void *ext_data;         /**< Extension data. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
 } rtcp_rr;
 
 /**
@@ -70,6 +72,16 @@ typedef struct rtcp_rr {
  */
 rtcp_rr *rtcp_rr_create(void);
 
+/**
+ * @brief Allocate a new RR packet using a specific allocator.
+ *
+ * The packet and everything it owns is allocated from the given allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return packet.
+ */
+rtcp_rr *rtcp_rr_create_with_allocator(const rtp_allocator *allocator);
+
 /**
  * @brief Free an RR packet.
  *
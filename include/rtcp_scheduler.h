@@ -0,0 +1,217 @@
+/**
+ * @file rtcp_scheduler.h
+ * @brief RTCP transmission scheduling.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtcp
+ */
+
+#ifndef LIBRTP_RTCP_SCHEDULER_H_
+#define LIBRTP_RTCP_SCHEDULER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rtp_alloc.h"
+#include "rtp_timer_wheel.h"
+
+/**
+ * @brief Largest session that may send a BYE without backoff.
+ *
+ * @see IETF RFC3550 "Transmitting a BYE Packet" (§6.3.7)
+ */
+#ifndef LIBRTP_RTCP_BYE_BACKOFF_MEMBERS
+#define LIBRTP_RTCP_BYE_BACKOFF_MEMBERS (50)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief RTCP transmission state of one participant.
+ *
+ * Holds the variables of RFC 3550 §6.3 and applies forward and reverse
+ * reconsideration and BYE backoff to them. Times are in seconds on any
+ * clock the caller chooses. The member and sender tables themselves stay
+ * with the caller, which reports their sizes through
+ * rtcp_scheduler_set_members(). The scheduler counts itself.
+ *
+ * With a timer wheel attached, the deadline is kept in the wheel and every
+ * change to tn moves it, so many sessions can share one timer thread.
+ *
+ * @see IETF RFC3550 "RTCP Transmission Interval" (§6.3)
+ */
+typedef struct rtcp_scheduler {
+    double tp;                  /**< Last RTCP transmission time. */
+    double tn;                  /**< Next scheduled transmission time. */
+    int pmembers;               /**< Members when tn was last computed. */
+    int members;                /**< Session members, including us. */
+    int senders;                /**< Session senders, including us. */
+    double rtcp_bw;             /**< Target RTCP bandwidth in octets/s. */
+    double avg_rtcp_size;       /**< Average compound RTCP packet size. */
+    bool we_sent;               /**< RTP sent since the 2nd last report. */
+    bool initial;               /**< No RTCP packet sent yet. */
+    bool leaving;               /**< BYE is scheduled. */
+    int reports_since_rtp;      /**< Reports sent since the last RTP. */
+    rtp_timer timer;            /**< Deadline timer, see attach(). */
+    rtp_timer_wheel *wheel;     /**< Wheel the timer is kept in, or NULL. */
+    double tick;                /**< Seconds per wheel tick. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
+} rtcp_scheduler;
+
+/**
+ * @brief Allocate a new scheduler.
+ *
+ * @return rtcp_scheduler*
+ */
+rtcp_scheduler *rtcp_scheduler_create(void);
+
+/**
+ * @brief Allocate a new scheduler using a specific allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return rtcp_scheduler*
+ */
+rtcp_scheduler *rtcp_scheduler_create_with_allocator(
+    const rtp_allocator *allocator);
+
+/**
+ * @brief Free a scheduler.
+ *
+ * @param [out] s - scheduler to free.
+ */
+void rtcp_scheduler_free(rtcp_scheduler *s);
+
+/**
+ * @brief Initialize a scheduler on joining a session.
+ *
+ * Schedules the first report, using half the minimum interval.
+ *
+ * @see IETF RFC3550 "Initialization" (§6.3.2)
+ *
+ * @param [out] s - scheduler to initialize.
+ * @param [in] tc - current time.
+ * @param [in] rtcp_bw - target RTCP bandwidth of the session, in octets/s.
+ * @param [in] rtcp_size - expected size of the first compound packet,
+ *  including lower-layer headers.
+ */
+void rtcp_scheduler_init(
+    rtcp_scheduler *s, double tc, double rtcp_bw, double rtcp_size);
+
+/**
+ * @brief Keep the deadline in a timer wheel.
+ *
+ * The handler runs at tn, rounded up to a tick, and would normally call
+ * rtcp_scheduler_on_expire(). Call this after rtcp_scheduler_init(), and
+ * with a NULL wheel to stop before initializing again.
+ *
+ * @param [in,out] s - scheduler.
+ * @param [in,out] w - wheel, with ticks counted from time 0, or NULL.
+ * @param [in] tick - seconds per tick.
+ * @param [in] handler - expiry handler, passed the timer member.
+ * @param [in] ctx - handler context.
+ */
+void rtcp_scheduler_attach(
+    rtcp_scheduler *s,
+    rtp_timer_wheel *w,
+    double tick,
+    rtp_timer_handler handler,
+    void *ctx);
+
+/**
+ * @brief Returns the time of the next transmission or reconsideration.
+ *
+ * @param [in] s - scheduler.
+ * @return time at which rtcp_scheduler_on_expire() should be called.
+ */
+double rtcp_scheduler_next_deadline(const rtcp_scheduler *s);
+
+/**
+ * @brief Record that we sent an RTP packet.
+ *
+ * @param [in,out] s - scheduler.
+ */
+void rtcp_scheduler_on_rtp_sent(rtcp_scheduler *s);
+
+/**
+ * @brief Record a received compound RTCP packet.
+ *
+ * While a BYE is scheduled every received BYE counts as a member, so the
+ * backoff grows with the number of participants leaving at once.
+ *
+ * @see IETF RFC3550 "Receiving an RTP or Non-BYE RTCP Packet" (§6.3.3)
+ *
+ * @param [in,out] s - scheduler.
+ * @param [in] size - packet size, including lower-layer headers.
+ * @param [in] bye - true if the packet contained a BYE.
+ */
+void rtcp_scheduler_on_rtcp_received(
+    rtcp_scheduler *s, size_t size, bool bye);
+
+/**
+ * @brief Update the number of other members and senders.
+ *
+ * When members leave or time out the next transmission is pulled in by
+ * reverse reconsideration. Ignored while a BYE is scheduled.
+ *
+ * @see IETF RFC3550 "Receiving an RTCP BYE Packet" (§6.3.4)
+ *
+ * @param [in,out] s - scheduler.
+ * @param [in] tc - current time.
+ * @param [in] members - other members in the session.
+ * @param [in] senders - other senders in the session.
+ */
+void rtcp_scheduler_set_members(
+    rtcp_scheduler *s, double tc, int members, int senders);
+
+/**
+ * @brief Handle the expiry of the transmission timer.
+ *
+ * Recomputes the interval from the current state (forward
+ * reconsideration). If the packet is due the caller should send it, a
+ * report or the scheduled BYE, and call rtcp_scheduler_on_rtcp_sent().
+ * Otherwise the deadline has moved later.
+ *
+ * @see IETF RFC3550 "Expiration of Transmission Timer" (§6.3.6)
+ *
+ * @param [in,out] s - scheduler.
+ * @param [in] tc - current time.
+ * @return true if a packet should be sent now.
+ */
+bool rtcp_scheduler_on_expire(rtcp_scheduler *s, double tc);
+
+/**
+ * @brief Record that we sent a compound RTCP packet and schedule the next.
+ *
+ * @param [in,out] s - scheduler.
+ * @param [in] tc - current time.
+ * @param [in] size - packet size, including lower-layer headers.
+ */
+void rtcp_scheduler_on_rtcp_sent(rtcp_scheduler *s, double tc, size_t size);
+
+/**
+ * @brief Leave the session.
+ *
+ * Small sessions may send the BYE at once. In larger ones the BYE is
+ * scheduled as if we were joining a session with no members other than
+ * those that are leaving, and is due when rtcp_scheduler_on_expire()
+ * returns true.
+ *
+ * @see IETF RFC3550 "Transmitting a BYE Packet" (§6.3.7)
+ *
+ * @param [in,out] s - scheduler.
+ * @param [in] tc - current time.
+ * @param [in] size - size of the BYE packet, including lower-layer headers.
+ * @return 1 if the BYE may be sent now.
+ * @return 0 if the BYE is scheduled.
+ * @return -1 if no BYE may be sent because we never sent RTP or RTCP.
+ */
+int rtcp_scheduler_leave(rtcp_scheduler *s, double tc, size_t size);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTCP_SCHEDULER_H_
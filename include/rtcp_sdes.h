@@ -45,6 +45,7 @@
 #include <stdint.h>
 
 #include "rtcp_header.h"
+#include "rtp_alloc.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -89,6 +90,7 @@ typedef struct rtcp_sdes_entry {
 typedef struct rtcp_sdes {
     rtcp_header header;         /**< RTCP header. */
     rtcp_sdes_entry *srcs;      /**< Variable length source list. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
 } rtcp_sdes;
 
 /**
@@ -98,6 +100,16 @@ typedef struct rtcp_sdes {
  */
 rtcp_sdes *rtcp_sdes_create(void);
 
+/**
+ * @brief Allocate a new SDES packet using a specific allocator.
+ *
+ * The packet and everything it owns is allocated from the given allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return packet.
+ */
+rtcp_sdes *rtcp_sdes_create_with_allocator(const rtp_allocator *allocator);
+
 /**
  * @brief Free an SDES packet.
  *
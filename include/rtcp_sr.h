@@ -56,6 +56,7 @@
 
 #include "rtcp_header.h"
 #include "rtcp_report.h"
+#include "rtp_alloc.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -75,6 +76,7 @@ typedef struct rtcp_sr {
     rtcp_report *reports;       /**< Reports. */
     size_t ext_size;            /**< Size of the extension data in bytes. */
     void *ext_data;             /**< Extension data. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
 } rtcp_sr;
 
 /**
@@ -84,6 +86,16 @@ typedef struct rtcp_sr {
  */
 rtcp_sr *rtcp_sr_create(void);
 
+/**
+ * @brief Allocate a new SR packet using a specific allocator.
+ *
+ * The packet and everything it owns is allocated from the given allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return packet.
+ */
+rtcp_sr *rtcp_sr_create_with_allocator(const rtp_allocator *allocator);
+
 /**
  * @brief Free an SR packet.
  *
@@ -126,6 +138,24 @@ int rtcp_sr_serialize(const rtcp_sr *packet, uint8_t *buffer, size_t size);
  */
 int rtcp_sr_parse(rtcp_sr *packet, const uint8_t *buffer, size_t size);
 
+/**
+ * @brief Set the sender's NTP timestamp.
+ *
+ * @param [out] packet - packet to set on.
+ * @param [in] t - wallclock time the report is sent.
+ */
+void rtcp_sr_set_ntp(rtcp_sr *packet, ntp64 t);
+
+/**
+ * @brief Returns the sender's NTP timestamp.
+ *
+ * The receiver echoes ntp64_short() of it as LSR.
+ *
+ * @param [in] packet - packet to read.
+ * @return ntp64
+ */
+ntp64 rtcp_sr_ntp(const rtcp_sr *packet);
+
 /**
  * @brief Find a report.
  *
@@ -173,4 +203,4 @@ void rtcp_sr_clear_ext(rtcp_sr *packet);
 }
 #endif // __cplusplus
 
-#endif // LIBRTP_RTCP_SR_H_
\ No newline at end of file
+#endif // LIBRTP_RTCP_SR_H_
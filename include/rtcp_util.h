@@ -12,6 +12,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "rtp_random.h"
+
 /**
  * @brief The minimum average time between RTCP packets in seconds.
  *
@@ -58,6 +60,9 @@ int rtcp_type(const uint8_t *buffer, size_t size);
 /**
  * @brief Calculates the RTCP transmission interval in seconds.
  *
+ * The random factor is drawn from the calling thread's generator, see
+ * rtp_random_thread().
+ *
  * @see IETF RFC3550 "Computing the RTCP Transmission Interval" (§A.7)
  *
  * @param [in] members - the current estimate for the number of session members.
@@ -81,6 +86,30 @@ double rtcp_interval(
     double avg_rtcp_size,
     bool initial);
 
+/**
+ * @brief Calculates the RTCP transmission interval using a given generator.
+ *
+ * As rtcp_interval(), for sessions that keep their own generator.
+ *
+ * @param [in] members - the current estimate for the number of session members.
+ * @param [in] senders - the current estimate for the number of session senders.
+ * @param [in] rtcp_bw - the target RTCP bandwidth.
+ * @param [in] we_sent - true if the application has sent data since the 2nd
+ *  previous RTCP report was transmitted.
+ * @param [in] avg_rtcp_size - the average compound RTCP packet size.
+ * @param [in] initial - true if the application has not yet sent an RTCP packet.
+ * @param [in,out] r - generator for the random factor.
+ * @return interval in seconds.
+ */
+double rtcp_interval_with_random(
+    int members,
+    int senders,
+    double rtcp_bw,
+    bool we_sent,
+    double avg_rtcp_size,
+    bool initial,
+    rtp_random *r);
+
 /**
  * @brief Recompute the next RTCP packet transmission time.
  *
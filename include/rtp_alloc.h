@@ -0,0 +1,96 @@
+/**
+ * @file rtp_alloc.h
+ * @brief Pluggable memory allocation.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#ifndef LIBRTP_RTP_ALLOC_H_
+#define LIBRTP_RTP_ALLOC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Memory allocator interface.
+ *
+ * Every heap allocation made by the library goes through one of these. The
+ * functions follow the semantics of malloc(), realloc() and free().
+ */
+typedef struct rtp_allocator {
+    /** Allocate size bytes. */
+    void *(*alloc)(void *ctx, size_t size);
+
+    /** Resize a block returned by alloc, ptr may be NULL. */
+    void *(*resize)(void *ctx, void *ptr, size_t size);
+
+    /** Release a block returned by alloc or resize, ptr may be NULL. */
+    void (*release)(void *ctx, void *ptr);
+
+    /** User data passed to each function. */
+    void *ctx;
+} rtp_allocator;
+
+/**
+ * @brief Bump allocator over a caller-owned buffer.
+ *
+ * Allocation is a pointer increment and release is a no-op except for the
+ * most recent block, so an arena is ideal for short-lived RTCP packets that
+ * are all discarded together with rtp_arena_reset(), e.g. once per RTCP
+ * interval. Blocks are aligned to 16 bytes.
+ */
+typedef struct rtp_arena {
+    rtp_allocator allocator;    /**< Allocator interface for this arena. */
+    uint8_t *buffer;            /**< Backing storage. */
+    size_t size;                /**< Backing storage size in bytes. */
+    size_t used;                /**< Bytes in use. */
+    size_t last;                /**< Offset of the most recent block. */
+    size_t high_water;          /**< Most bytes ever in use. */
+} rtp_arena;
+
+/**
+ * @brief Set the allocator used by objects created from now on.
+ *
+ * Objects remember the allocator they were created with, so changing the
+ * global allocator does not affect existing objects. This function is not
+ * thread-safe and should be called once during start-up. The allocator must
+ * outlive every object created with it.
+ *
+ * @param [in] allocator - allocator to use, or NULL for malloc/realloc/free.
+ */
+void rtp_set_allocator(const rtp_allocator *allocator);
+
+/**
+ * @brief Returns the global allocator.
+ *
+ * @return allocator.
+ */
+const rtp_allocator *rtp_get_allocator(void);
+
+/**
+ * @brief Initialize an arena.
+ *
+ * @param [out] arena - arena to initialize.
+ * @param [in] buffer - backing storage.
+ * @param [in] size - backing storage size in bytes.
+ */
+void rtp_arena_init(rtp_arena *arena, void *buffer, size_t size);
+
+/**
+ * @brief Release every block in an arena at once.
+ *
+ * All objects allocated from the arena become invalid.
+ *
+ * @param [in,out] arena - arena to reset.
+ */
+void rtp_arena_reset(rtp_arena *arena);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_ALLOC_H_
@@ -0,0 +1,140 @@
+/**
+ * @file rtp_clock.h
+ * @brief Monotonic clock with NTP and RTP timestamp conversion.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_CLOCK_H_
+#define LIBRTP_RTP_CLOCK_H_
+
+#include <stdint.h>
+
+#include "ntp.h"
+
+/**
+ * @brief Read the clock from the x86-64 time stamp counter.
+ *
+ * Only used once rtp_clock_sync() has calibrated it against
+ * CLOCK_MONOTONIC, and only on CPUs with an invariant TSC, otherwise reads
+ * fall back to clock_gettime(). This changes the layout of rtp_clock, so
+ * set it for the whole build (-DLIBRTP_CLOCK_TSC=ON).
+ */
+#ifndef LIBRTP_CLOCK_TSC
+#define LIBRTP_CLOCK_TSC (0)
+#endif
+
+#if LIBRTP_CLOCK_TSC && !defined(__x86_64__)
+#error "LIBRTP_CLOCK_TSC requires x86-64"
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Monotonic clock with a wallclock anchor.
+ *
+ * Reads are nanoseconds of CLOCK_MONOTONIC, which the vDSO serves without
+ * a system call. The NTP time of one monotonic instant is kept so SR
+ * timestamps can be derived from monotonic reads, and so stay steady when
+ * the wallclock is stepped until the next rtp_clock_sync().
+ */
+typedef struct rtp_clock {
+    uint64_t mono;              /**< Monotonic time of the anchor in ns. */
+    ntp64 ntp;                  /**< Wallclock time of the anchor. */
+#if LIBRTP_CLOCK_TSC
+    uint64_t tsc;               /**< TSC at the anchor. */
+    uint64_t tsc_start;         /**< TSC at init, for calibration. */
+    uint64_t mono_start;        /**< Monotonic time at init in ns. */
+    uint64_t tsc_mult;          /**< ns per tick as 32.32, 0 if unused. */
+#endif
+} rtp_clock;
+
+/**
+ * @brief Conversion from nanoseconds to an RTP clock rate.
+ *
+ * Precomputed so that the conversion is one multiplication.
+ */
+typedef struct rtp_clock_rate {
+    uint64_t mult;              /**< 2^64 * rate / 10^9, rounded up. */
+    uint32_t clock_rate;        /**< RTP clock rate in Hz. */
+} rtp_clock_rate;
+
+/**
+ * @brief Initialize a clock and anchor it to the wallclock.
+ *
+ * @param [out] c - clock to initialize.
+ */
+void rtp_clock_init(rtp_clock *c);
+
+/**
+ * @brief Re-anchor a clock to the wallclock.
+ *
+ * Call this now and then, e.g. before each SR, to follow wallclock
+ * adjustments. With LIBRTP_CLOCK_TSC this also recalibrates the TSC over
+ * the time since rtp_clock_init().
+ *
+ * @param [in,out] c - clock to update.
+ */
+void rtp_clock_sync(rtp_clock *c);
+
+/**
+ * @brief Returns the monotonic time in nanoseconds.
+ *
+ * @param [in] c - clock.
+ */
+uint64_t rtp_clock_now(const rtp_clock *c);
+
+/**
+ * @brief Returns the wallclock time of a monotonic time.
+ *
+ * @param [in] c - clock.
+ * @param [in] now - time from rtp_clock_now().
+ * @return NTP timestamp, e.g. for rtcp_sr_set_ntp().
+ */
+ntp64 rtp_clock_ntp(const rtp_clock *c, uint64_t now);
+
+/**
+ * @brief Prepare the conversion to an RTP clock rate.
+ *
+ * @param [out] r - conversion to initialize.
+ * @param [in] clock_rate - RTP clock rate in Hz below 10^9, e.g. 8000,
+ *  48000 or 90000.
+ */
+void rtp_clock_rate_init(rtp_clock_rate *r, uint32_t clock_rate);
+
+/**
+ * @brief Convert nanoseconds to RTP timestamp units.
+ *
+ * Rounds down for inputs up to about 18 s. Beyond that a result a hair
+ * below a tick boundary may come out one tick high, which a jitter
+ * estimate cannot tell from noise. Only the low 32 bits are kept.
+ *
+ * @param [in] r - conversion.
+ * @param [in] ns - time in nanoseconds, e.g. from rtp_clock_now().
+ * @return time in RTP timestamp units.
+ */
+static inline uint32_t rtp_clock_to_rtp(const rtp_clock_rate *r, uint64_t ns)
+{
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 u128;
+    return (uint32_t)(((u128)ns * r->mult) >> 64);
+#else
+    // High half of the 128-bit product
+    const uint64_t a_lo = ns & 0xffffffffu, a_hi = ns >> 32;
+    const uint64_t b_lo = r->mult & 0xffffffffu, b_hi = r->mult >> 32;
+    const uint64_t mid1 = a_hi * b_lo;
+    const uint64_t mid2 = a_lo * b_hi;
+    const uint64_t carry = (((a_lo * b_lo) >> 32)
+        + (mid1 & 0xffffffffu) + (mid2 & 0xffffffffu)) >> 32;
+    return (uint32_t)(a_hi * b_hi + (mid1 >> 32) + (mid2 >> 32) + carry);
+#endif
+}
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_CLOCK_H_
@@ -33,12 +33,31 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "rtp_alloc.h"
+
+/**
+ * @brief The maximum number of contributing sources in a header.
+ */
+#define RTP_MAX_CSRC (15)
+
+/**
+ * @brief Header extension words stored inline before falling back to the heap.
+ */
+#ifndef LIBRTP_HEADER_EXT_INLINE
+#define LIBRTP_HEADER_EXT_INLINE (4)
+#endif
+
 #if defined(__cplusplus)
 extern "C" {
 #endif // __cplusplus
 
 /**
  * @brief RTP packet.
+ *
+ * CSRC lists and small extensions live inside the header so that building
+ * and updating headers does not touch the heap. Because ext_data may point
+ * into the header itself, a header with an extension must not be copied by
+ * value.
  */
 typedef struct rtp_header {
     // Required
@@ -53,11 +72,16 @@ typedef struct rtp_header {
     uint32_t ssrc;              /**< Synchronization source */
 
     // Optional
-    uint32_t *csrc;             /**< List of contributing sources. */
-
     uint16_t ext_id;            /**< Extension ID. */
     uint16_t ext_count;         /**< Number of extension entries. */
-    uint32_t *ext_data;         /**< Extension data. */
+    uint32_t *ext_data;         /**< Extension data, NULL if not set. */
+
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
+
+    uint32_t csrc[RTP_MAX_CSRC];    /**< List of contributing sources. */
+
+    /** Inline extension storage, used when ext_count fits. */
+    uint32_t ext_inline[LIBRTP_HEADER_EXT_INLINE];
 } rtp_header;
 
 /**
@@ -67,6 +91,16 @@ typedef struct rtp_header {
  */
 rtp_header *rtp_header_create(void);
 
+/**
+ * @brief Allocate a new RTP header using a specific allocator.
+ *
+ * The header and everything it owns is allocated from the given allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return header.
+ */
+rtp_header *rtp_header_create_with_allocator(const rtp_allocator *allocator);
+
 /**
  * @brief Free an RTP header.
  *
@@ -127,6 +161,9 @@ int rtp_header_find_csrc(rtp_header *header, uint32_t csrc);
 /**
  * @brief Add a contributing source id.
  *
+ * Fails if the id is already present or the list already holds RTP_MAX_CSRC
+ * entries.
+ *
  * @param [out] header - header to add to.
  * @param [in] csrc - id of the csrc to add.
  * @return 0 on success.
@@ -144,6 +181,9 @@ void rtp_header_remove_csrc(rtp_header *header, uint32_t csrc);
 /**
  * @brief Set the header extension.
  *
+ * Extensions of up to LIBRTP_HEADER_EXT_INLINE words are stored inside the
+ * header, larger ones are allocated.
+ *
  * @param [out] header - header to set on.
  * @param [in] id - extension id.
  * @param [in] data - extension data.
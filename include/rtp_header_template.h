@@ -0,0 +1,141 @@
+/**
+ * @file rtp_header_template.h
+ * @brief Pre-rendered RTP header for the send path.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_HEADER_TEMPLATE_H_
+#define LIBRTP_RTP_HEADER_TEMPLATE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "rtp_header.h"
+
+/**
+ * @brief The largest header a template can hold in bytes.
+ *
+ * The default fits a full CSRC list and a 12 word extension.
+ */
+#ifndef LIBRTP_HEADER_TEMPLATE_SIZE
+#define LIBRTP_HEADER_TEMPLATE_SIZE (128)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Pre-rendered RTP header.
+ *
+ * The SSRC, CSRC list and extension of a stream rarely change, so they are
+ * serialized once. Writing a packet header is then a copy of the rendered
+ * bytes with the marker, sequence number and timestamp patched in at their
+ * fixed offsets.
+ */
+typedef struct rtp_header_template {
+    size_t size;                /**< Header size in bytes. */
+    size_t ext_offset;          /**< Offset of the extension data, or 0. */
+    uint16_t ext_count;         /**< Number of extension words. */
+    uint8_t data[LIBRTP_HEADER_TEMPLATE_SIZE]; /**< Rendered header. */
+} rtp_header_template;
+
+/**
+ * @brief Render a header into a template.
+ *
+ * The header's extension, if any, reserves the extension words. Their values
+ * are the defaults that rtp_header_template_set_ext() can later overwrite.
+ *
+ * @param [out] tmpl - template to initialize.
+ * @param [in] header - header to render.
+ * @return 0 on success or -1 if the header does not fit.
+ */
+int rtp_header_template_init(
+    rtp_header_template *tmpl, const rtp_header *header);
+
+/**
+ * @brief Update a reserved extension word.
+ *
+ * @param [in,out] tmpl - template to update.
+ * @param [in] index - extension word index.
+ * @param [in] value - new value.
+ * @return 0 on success or -1 if index is not reserved.
+ */
+int rtp_header_template_set_ext(
+    rtp_header_template *tmpl, uint16_t index, uint32_t value);
+
+/**
+ * @brief Write a packet header from a template.
+ *
+ * This is inline because it runs once per transmitted packet and is cheaper
+ * than the call into the library. Exactly the header's bytes are written,
+ * so the payload may already be in the buffer.
+ *
+ * @param [in] tmpl - template to write.
+ * @param [out] buffer - buffer to write to.
+ * @param [in] size - buffer size.
+ * @param [in] m - marker bit.
+ * @param [in] seq - sequence number.
+ * @param [in] ts - packet timestamp.
+ * @return number of bytes written or -1 on failure.
+ */
+static inline int rtp_header_template_write(
+    const rtp_header_template *tmpl,
+    uint8_t *buffer,
+    size_t size,
+    uint8_t m,
+    uint16_t seq,
+    uint32_t ts)
+{
+    assert(tmpl != NULL);
+    assert(buffer != NULL);
+
+    if(size < tmpl->size)
+        return -1;
+
+    // Headers of 16 to 32 bytes, a CSRC or a short extension, are copied as
+    // two overlapping 16 byte moves instead of a call to memcpy(). Nothing
+    // past the header is written.
+    const size_t n = tmpl->size;
+    if(n >= 16 && n <= 32) {
+        memcpy(buffer, tmpl->data, 16);
+        memcpy(buffer + n - 16, tmpl->data + n - 16, 16);
+    }
+    else if(n == 12) {
+        memcpy(buffer, tmpl->data, 12);
+    }
+    else {
+        memcpy(buffer, tmpl->data, n);
+    }
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) \
+    && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    // Patch the marker, sequence number and timestamp with one 8 byte store
+    uint64_t head;
+    memcpy(&head, tmpl->data, sizeof(head));
+    head = (head & 0x7fffu) | ((uint64_t)(m & 1) << 15)
+        | ((uint64_t)__builtin_bswap16(seq) << 16)
+        | ((uint64_t)__builtin_bswap32(ts) << 32);
+    memcpy(buffer, &head, sizeof(head));
+#else
+    buffer[1] = (uint8_t)((tmpl->data[1] & 0x7f) | ((m & 1) << 7));
+    buffer[2] = (uint8_t)(seq >> 8);
+    buffer[3] = (uint8_t)(seq);
+    buffer[4] = (uint8_t)(ts >> 24);
+    buffer[5] = (uint8_t)(ts >> 16);
+    buffer[6] = (uint8_t)(ts >> 8);
+    buffer[7] = (uint8_t)(ts);
+#endif
+
+    return (int)tmpl->size;
+}
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_HEADER_TEMPLATE_H_
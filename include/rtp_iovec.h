@@ -0,0 +1,25 @@
+/**
+ * @file rtp_iovec.h
+ * @brief Scatter/gather vector definition.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#ifndef LIBRTP_RTP_IOVEC_H_
+#define LIBRTP_RTP_IOVEC_H_
+
+#include <stddef.h>
+
+#if defined(_WIN32)
+/**
+ * @brief Scatter/gather element, layout compatible with POSIX struct iovec.
+ */
+struct iovec {
+    void *iov_base;     /**< Start address. */
+    size_t iov_len;     /**< Size in bytes. */
+};
+#else
+#include <sys/uio.h>
+#endif
+
+#endif // LIBRTP_RTP_IOVEC_H_
@@ -0,0 +1,154 @@
+/**
+ * @file rtp_loss.h
+ * @brief RTP per-source loss, duplicate and reordering statistics.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_LOSS_H_
+#define LIBRTP_RTP_LOSS_H_
+
+#include <stdint.h>
+
+#include "rtp_alloc.h"
+
+/**
+ * @brief Receive window in sequence numbers, a multiple of 64.
+ *
+ * Packets up to this far behind the highest sequence number are still
+ * counted as received. A sequence number only counts as lost once it
+ * leaves the window, so a larger window tolerates deeper reordering but
+ * reports losses later.
+ */
+#ifndef LIBRTP_LOSS_WINDOW
+#define LIBRTP_LOSS_WINDOW (64)
+#endif
+
+/**
+ * @brief Default minimum gap length (Gmin).
+ *
+ * A burst ends after this many consecutive packets are received.
+ *
+ * @see IETF RFC3611 "VoIP Metrics Report Block" (§4.7.2)
+ */
+#ifndef LIBRTP_LOSS_GMIN
+#define LIBRTP_LOSS_GMIN (16)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Per-source loss state.
+ *
+ * Tracks which of the last LIBRTP_LOSS_WINDOW extended sequence numbers
+ * were received in a bitmap. Sequence numbers leaving the window are fed,
+ * in order, through the burst/gap classification of RFC 3611.
+ */
+typedef struct rtp_loss {
+    uint64_t window[LIBRTP_LOSS_WINDOW / 64]; /**< Received bits, indexed by
+                                               * sequence % window. */
+    uint32_t highest;           /**< Highest extended seq. number seen. */
+    uint32_t filled;            /**< Seq. numbers in the window. */
+    uint32_t gmin;              /**< Minimum gap length. */
+    uint32_t received;          /**< Packets received, without duplicates. */
+    uint32_t duplicates;        /**< Duplicate packets. */
+    uint32_t reordered;         /**< Packets older than the highest seen. */
+    uint32_t max_reorder;       /**< Largest reorder distance. */
+    uint32_t late;              /**< Packets too old for the window. */
+    uint32_t run;               /**< Received since the last loss. */
+    uint32_t cluster_packets;   /**< Packets in the open loss cluster. */
+    uint32_t cluster_lost;      /**< Losses in the open loss cluster. */
+    uint32_t bursts;            /**< Completed bursts. */
+    uint32_t burst_packets;     /**< Packets in completed bursts. */
+    uint32_t burst_lost;        /**< Losses in completed bursts. */
+    uint32_t gap_packets;       /**< Packets in gaps. */
+    uint32_t gap_lost;          /**< Losses in gaps. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
+} rtp_loss;
+
+/**
+ * @brief Loss statistics.
+ *
+ * Densities are fractions of 256, as in RFC 3611. Lengths are means in
+ * packets, multiply by the packet interval for a duration.
+ */
+typedef struct rtp_loss_stats {
+    uint32_t received;          /**< Packets received, without duplicates. */
+    uint32_t lost;              /**< Seq. numbers that left the window unseen. */
+    uint32_t duplicates;        /**< Duplicate packets. */
+    uint32_t reordered;         /**< Packets older than the highest seen. */
+    uint32_t max_reorder;       /**< Largest reorder distance. */
+    uint32_t late;              /**< Packets too old for the window. */
+    uint32_t bursts;            /**< Number of bursts. */
+    uint8_t burst_density;      /**< Loss density within bursts. */
+    uint8_t gap_density;        /**< Loss density within gaps. */
+    uint32_t burst_length;      /**< Mean burst length. */
+    uint32_t gap_length;        /**< Mean gap length. */
+} rtp_loss_stats;
+
+/**
+ * @brief Allocate a new loss state.
+ *
+ * @return rtp_loss*
+ */
+rtp_loss *rtp_loss_create(void);
+
+/**
+ * @brief Allocate a new loss state using a specific allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return rtp_loss*
+ */
+rtp_loss *rtp_loss_create_with_allocator(const rtp_allocator *allocator);
+
+/**
+ * @brief Free a loss state.
+ *
+ * @param [out] l - loss state to free.
+ */
+void rtp_loss_free(rtp_loss *l);
+
+/**
+ * @brief Initialize a loss state.
+ *
+ * The first update sets the start of the sequence. Gmin is set to
+ * LIBRTP_LOSS_GMIN and may be changed before the first update.
+ *
+ * @param [out] l - loss state to initialize.
+ */
+void rtp_loss_init(rtp_loss *l);
+
+/**
+ * @brief Record a received packet.
+ *
+ * Call this for every packet that passes rtp_source_update_seq(), with its
+ * sequence number extended by rtp_source_extended_seq(). The cost is
+ * constant per packet, plus one step per lost packet as it leaves the
+ * window.
+ *
+ * @param [in,out] l - loss state to update.
+ * @param [in] seq - extended sequence number.
+ * @return 0 if the packet is new.
+ * @return 1 if the packet is a duplicate.
+ * @return -1 if the packet is too old for the window.
+ */
+int rtp_loss_update(rtp_loss *l, uint32_t seq);
+
+/**
+ * @brief Get the loss statistics.
+ *
+ * A loss cluster that is still open is counted as it stands.
+ *
+ * @param [in] l - loss state.
+ * @param [out] stats - statistics.
+ */
+void rtp_loss_get_stats(const rtp_loss *l, rtp_loss_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_LOSS_H_
@@ -10,6 +10,7 @@
 #define LIBRTP_RTP_PACKET_H_
 
 #include "rtp_header.h"
+#include "rtp_iovec.h"
 
 #if defined(__cplusplus)
 extern "C" {
@@ -22,6 +23,8 @@ typedef struct rtp_packet {
     rtp_header *header;         /**< RTP header. */
     size_t payload_size;        /**< Size of the payload data in bytes. */
     void *payload_data;         /**< Payload data. */
+    size_t payload_capacity;    /**< Size of fixed payload storage, or 0. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
 } rtp_packet;
 
 /**
@@ -31,6 +34,17 @@ typedef struct rtp_packet {
  */
 rtp_packet *rtp_packet_create(void);
 
+/**
+ * @brief Allocate a new RTP packet using a specific allocator.
+ *
+ * The packet, its header and its payload are allocated from the given
+ * allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return packet.
+ */
+rtp_packet *rtp_packet_create_with_allocator(const rtp_allocator *allocator);
+
 /**
  * @brief Free a RTP packet.
  *
@@ -69,11 +83,35 @@ size_t rtp_packet_size(const rtp_packet *packet);
 int rtp_packet_serialize(
     const rtp_packet *packet, uint8_t *buffer, size_t size);
 
+/**
+ * @brief Write an RTP packet as a scatter/gather list.
+ *
+ * Only the header, and any padding, is written to the buffer. The payload is
+ * referenced in place so the iovec can be passed to sendmsg() or sendmmsg()
+ * without copying. Entries are the header, the payload and, if padding is
+ * non-zero, the padding. The payload must outlive the iovec.
+ *
+ * @param [in] packet - packet to serialize.
+ * @param [out] buffer - buffer for the header and padding.
+ * @param [in] size - buffer size.
+ * @param [in] padding - padding bytes to append including the count, or 0.
+ * @param [out] iov - scatter/gather list to fill.
+ * @param [in] iovcnt - number of entries in iov, 2 or 3 with padding.
+ * @return number of iov entries used or -1 on failure.
+ */
+int rtp_packet_serialize_iov(
+    const rtp_packet *packet,
+    uint8_t *buffer,
+    size_t size,
+    uint8_t padding,
+    struct iovec *iov,
+    size_t iovcnt);
+
 /**
  * @brief Fill an RTP packet from a buffer.
  *
- * This takes a copy of the payload. For a non-copy approach you can use the
- * rtp header api directly.
+ * This takes a copy of the payload. For a non-copy approach use
+ * rtp_packet_view_parse() instead.
  *
  * @param [out] packet - empty packet to fill.
  * @param [in] buffer - buffer to read from.
@@ -88,6 +126,10 @@ int rtp_packet_parse(rtp_packet *packet, const uint8_t *buffer, size_t size);
  * Allocates a new buffer and initializes it with the passed in data. If a
  * payload buffer already exists then this method will return -1.
  *
+ * Packets with fixed payload storage (payload_capacity is non-zero, e.g. from
+ * an rtp_pool) copy into that storage instead and return -1 if the data does
+ * not fit or a payload is already set.
+ *
  * @param [out] packet - packet to set on.
  * @param [in] data - payload data.
  * @param [in] size - payload data size.
@@ -0,0 +1,125 @@
+/**
+ * @file rtp_packet_view.h
+ * @brief Non-owning RTP packet view.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_PACKET_VIEW_H_
+#define LIBRTP_RTP_PACKET_VIEW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rtp_iovec.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Per-packet result codes for rtp_parse_batch().
+ */
+typedef enum rtp_parse_status {
+    RTP_PARSE_OK        = 0,    /**< Packet is valid. */
+    RTP_PARSE_SHORT     = 1,    /**< Shorter than the fixed header. */
+    RTP_PARSE_VERSION   = 2,    /**< Version is not 2. */
+    RTP_PARSE_PT        = 3,    /**< Payload type collides with RTCP. */
+    RTP_PARSE_LENGTH    = 4     /**< CSRC, extension or padding overruns. */
+} rtp_parse_status;
+
+/**
+ * @brief Read-only view of an RTP packet.
+ *
+ * The fixed header fields are decoded into the view while the CSRC list,
+ * header extension and payload are left in place and referenced by pointer.
+ * A view never owns memory and is only valid for as long as the buffer it was
+ * parsed from.
+ */
+typedef struct rtp_packet_view {
+    unsigned int version : 2;   /**< Protocol version. */
+    unsigned int p : 1;         /**< Padding flag. */
+    unsigned int x : 1;         /**< Header extension flag. */
+    unsigned int cc : 4;        /**< CSRC count. */
+    unsigned int m : 1;         /**< Marker bit. */
+    unsigned int pt : 7;        /**< Payload type. */
+    unsigned int seq : 16;      /**< Sequence number. */
+    uint32_t ts;                /**< Timestamp. */
+    uint32_t ssrc;              /**< Synchronization source. */
+
+    const uint8_t *csrc;        /**< CSRC list (big-endian) or NULL. */
+
+    uint16_t ext_id;            /**< Extension ID. */
+    uint16_t ext_count;         /**< Number of extension entries. */
+    const uint8_t *ext_data;    /**< Extension data (big-endian) or NULL. */
+
+    size_t payload_size;        /**< Payload size in bytes, less padding. */
+    const uint8_t *payload_data;/**< Payload data. */
+} rtp_packet_view;
+
+/**
+ * @brief Parse an RTP packet view from a buffer.
+ *
+ * Validates the packet in place and fills the view with pointers into the
+ * buffer. No memory is allocated and no data is copied.
+ *
+ * @see IETF RFC3550 "RTP Data Header Validity Checks" (§A.1)
+ *
+ * @param [out] view - view to fill.
+ * @param [in] buffer - buffer to read from.
+ * @param [in] size - buffer size.
+ * @return 0 on success.
+ */
+int rtp_packet_view_parse(
+    rtp_packet_view *view, const uint8_t *buffer, size_t size);
+
+/**
+ * @brief Parse a vector of RTP packets into views.
+ *
+ * Intended for the output of recvmmsg(). The fixed headers of a block of
+ * packets are decoded and validated together, using SIMD where the CPU
+ * supports it, before any variable length fields are decoded. Invalid packets
+ * are rejected without touching their CSRC or extension data. Views for
+ * packets that fail validation are left in an unspecified state.
+ *
+ * @param [in] in - datagrams to parse.
+ * @param [in] n - number of datagrams.
+ * @param [out] out - array of n views to fill.
+ * @param [out] status - array of n rtp_parse_status results.
+ * @return number of valid packets.
+ */
+size_t rtp_parse_batch(
+    const struct iovec *in, size_t n, rtp_packet_view *out, uint8_t *status);
+
+/**
+ * @brief Returns the size of the header referenced by a view.
+ *
+ * @param [in] view - view to check.
+ * @return header size in bytes.
+ */
+size_t rtp_packet_view_header_size(const rtp_packet_view *view);
+
+/**
+ * @brief Read a contributing source id from a view.
+ *
+ * @param [in] view - view to read from.
+ * @param [in] index - csrc index, must be less than cc.
+ * @return csrc.
+ */
+uint32_t rtp_packet_view_csrc(const rtp_packet_view *view, uint8_t index);
+
+/**
+ * @brief Read a header extension entry from a view.
+ *
+ * @param [in] view - view to read from.
+ * @param [in] index - entry index, must be less than ext_count.
+ * @return extension entry.
+ */
+uint32_t rtp_packet_view_ext(const rtp_packet_view *view, uint16_t index);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_PACKET_VIEW_H_
@@ -0,0 +1,117 @@
+/**
+ * @file rtp_pool.h
+ * @brief Fixed-capacity RTP packet pool.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_POOL_H_
+#define LIBRTP_RTP_POOL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rtp_packet.h"
+
+/**
+ * @brief Number of free lists a pool is split into.
+ *
+ * Each thread is pinned to one free list so that threads rarely contend on
+ * the same cache line. Must be a power of two.
+ */
+#ifndef LIBRTP_POOL_SHARDS
+#define LIBRTP_POOL_SHARDS (8)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Packet pool.
+ */
+typedef struct rtp_pool rtp_pool;
+
+/**
+ * @brief Packet pool statistics.
+ */
+typedef struct rtp_pool_stats {
+    size_t capacity;            /**< Number of packets in the pool. */
+    size_t in_use;              /**< Packets currently acquired. */
+    size_t high_water;          /**< Most packets ever acquired at once. */
+    uint64_t exhausted;         /**< Acquires that failed on an empty pool. */
+} rtp_pool_stats;
+
+/**
+ * @brief Allocate a new packet pool.
+ *
+ * All packets are allocated up front in a single cache-line aligned slab.
+ * Each packet carries its own header and payload storage so that acquiring
+ * and releasing packets never touches the heap.
+ *
+ * @param [in] capacity - number of packets.
+ * @param [in] payload_capacity - payload storage per packet in bytes.
+ * @return pool or NULL on failure.
+ */
+rtp_pool *rtp_pool_create(size_t capacity, size_t payload_capacity);
+
+/**
+ * @brief Allocate a new packet pool using a specific allocator.
+ *
+ * The slab and any CSRC or extension data added to pool packets is allocated
+ * from the given allocator.
+ *
+ * @param [in] capacity - number of packets.
+ * @param [in] payload_capacity - payload storage per packet in bytes.
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return pool or NULL on failure.
+ */
+rtp_pool *rtp_pool_create_with_allocator(
+    size_t capacity, size_t payload_capacity, const rtp_allocator *allocator);
+
+/**
+ * @brief Free a packet pool.
+ *
+ * All packets acquired from the pool become invalid.
+ *
+ * @param [out] pool - pool to free.
+ */
+void rtp_pool_free(rtp_pool *pool);
+
+/**
+ * @brief Take a packet from the pool.
+ *
+ * This is lock-free and may be called from any thread. The packet is empty,
+ * call rtp_packet_init() before use. Pool packets must be returned with
+ * rtp_pool_release() and never passed to rtp_packet_free().
+ *
+ * @param [in,out] pool - pool to acquire from.
+ * @return packet or NULL if the pool is exhausted.
+ */
+rtp_packet *rtp_pool_acquire(rtp_pool *pool);
+
+/**
+ * @brief Return a packet to the pool.
+ *
+ * This is lock-free and may be called from any thread, not only the one that
+ * acquired the packet.
+ *
+ * @param [in,out] pool - pool the packet was acquired from.
+ * @param [in] packet - packet to release.
+ */
+void rtp_pool_release(rtp_pool *pool, rtp_packet *packet);
+
+/**
+ * @brief Read the pool statistics.
+ *
+ * @param [in] pool - pool to read.
+ * @param [out] stats - statistics.
+ */
+void rtp_pool_get_stats(const rtp_pool *pool, rtp_pool_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_POOL_H_
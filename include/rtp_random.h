@@ -0,0 +1,104 @@
+/**
+ * @file rtp_random.h
+ * @brief Pseudo-random number generation.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_RANDOM_H_
+#define LIBRTP_RTP_RANDOM_H_
+
+#include <stdint.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief xoshiro256** generator state.
+ *
+ * Small enough to keep one per thread or per session, and unlike rand()
+ * it takes no lock. Not suitable where unpredictability matters against
+ * an attacker, e.g. SRTP keys.
+ *
+ * @see Blackman & Vigna "Scrambled Linear Pseudorandom Number Generators"
+ */
+typedef struct rtp_random {
+    uint64_t s[4];              /**< Generator state, never all zero. */
+} rtp_random;
+
+/**
+ * @brief Seed a generator for a reproducible sequence.
+ *
+ * @param [out] r - generator to seed.
+ * @param [in] seed - any value, expanded with splitmix64.
+ */
+void rtp_random_seed(rtp_random *r, uint64_t seed);
+
+/**
+ * @brief Seed a generator from the system entropy source.
+ *
+ * Falls back to the clock and the generator's address when there is none.
+ *
+ * @param [out] r - generator to seed.
+ */
+void rtp_random_init(rtp_random *r);
+
+/**
+ * @brief Returns the calling thread's generator.
+ *
+ * Seeded with rtp_random_init() on first use. Reseed it with
+ * rtp_random_seed() to make everything drawn on this thread repeatable,
+ * including rtcp_interval().
+ *
+ * @return rtp_random*
+ */
+rtp_random *rtp_random_thread(void);
+
+/**
+ * @brief Returns the next 64 random bits.
+ *
+ * @param [in,out] r - generator.
+ */
+uint64_t rtp_random_next(rtp_random *r);
+
+/**
+ * @brief Returns a uniform double in [0, 1).
+ *
+ * @param [in,out] r - generator.
+ */
+double rtp_random_double(rtp_random *r);
+
+/**
+ * @brief Returns a random synchronization source identifier.
+ *
+ * @see IETF RFC3550 "SSRC" (§5.1)
+ *
+ * @param [in,out] r - generator.
+ */
+uint32_t rtp_random_ssrc(rtp_random *r);
+
+/**
+ * @brief Returns a random initial sequence number.
+ *
+ * @see IETF RFC3550 "sequence number" (§5.1)
+ *
+ * @param [in,out] r - generator.
+ */
+uint16_t rtp_random_seq(rtp_random *r);
+
+/**
+ * @brief Returns a random initial timestamp.
+ *
+ * @see IETF RFC3550 "timestamp" (§5.1)
+ *
+ * @param [in,out] r - generator.
+ */
+uint32_t rtp_random_ts(rtp_random *r);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_RANDOM_H_
@@ -10,8 +10,11 @@
 #define LIBRTP_RTP_SOURCE_H_
 
 #include <stdint.h>
+#include <stddef.h>
+#include <time.h>
 
 #include "ntp.h"
+#include "rtp_alloc.h"
 
 /**
  * @brief The maximum acceptable gap in sequence numbers.
@@ -34,6 +37,17 @@
 #define LIBRTP_MIN_SEQUENTIAL (2)
 #endif
 
+/**
+ * @brief Keep the jitter estimate as an integer scaled by 16.
+ *
+ * Uses the integer form from RFC 3550 §A.8 instead of a double, which is
+ * exact and avoids floating point on every packet. This changes the layout
+ * of rtp_source, so set it for the whole build (-DLIBRTP_JITTER_FIXED=ON).
+ */
+#ifndef LIBRTP_JITTER_FIXED
+#define LIBRTP_JITTER_FIXED (0)
+#endif
+
 #if defined(__cplusplus)
 extern "C" {
 #endif // __cplusplus
@@ -54,10 +68,15 @@ typedef struct rtp_source {
     int expected_prior;         /**< Packets expected at last interval. */
     int received_prior;         /**< Packets received at last interval. */
     int transit;                /**< Relative transit time for prev. pkt. */
+#if LIBRTP_JITTER_FIXED
+    uint32_t jitter;            /**< Estimated jitter, scaled by 16. */
+#else
     double jitter;              /**< Estimated jitter. */
+#endif
     unsigned int fraction : 8;  /**< Fraction lost since last sent SR/RR. */
     int lost : 24;              /**< Cumulative number of packets lost. */
     ntp_tv lsr;                 /**< Timestamp of the most recent SR from this source. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
 } rtp_source;
 
 /**
@@ -67,6 +86,14 @@ typedef struct rtp_source {
  */
 rtp_source *rtp_source_create(void);
 
+/**
+ * @brief Allocate a new source using a specific allocator.
+ *
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return rtp_source*
+ */
+rtp_source *rtp_source_create_with_allocator(const rtp_allocator *allocator);
+
 /**
  * @brief Free a source.
  *
@@ -108,6 +135,35 @@ void rtp_source_reset_seq(rtp_source *s, uint16_t seq);
  */
 int rtp_source_update_seq(rtp_source *s, uint16_t seq);
 
+/**
+ * @brief Update the sequence number for a run of packets from one source.
+ *
+ * Equivalent to calling rtp_source_update_seq() for each packet in order.
+ * Runs that continue max_seq without wrapping, the common case after a
+ * receive batch, are checked with one vector compare per 8 packets and
+ * applied at once. Only the packets that break the run go through the
+ * scalar RFC 3550 checks.
+ *
+ * @param [in,out] s - source to update.
+ * @param [in] seqs - sequence numbers in arrival order.
+ * @param [in] n - number of packets, at most 64.
+ * @return mask with bit i set if packet i was accepted.
+ */
+uint64_t rtp_source_update_seq_batch(
+    rtp_source *s, const uint16_t *seqs, size_t n);
+
+/**
+ * @brief Extend a sequence number with the source's cycle count.
+ *
+ * Call this after rtp_source_update_seq() accepted the packet. A late
+ * packet from before the most recent wrap gets the previous cycle.
+ *
+ * @param [in] s - source.
+ * @param [in] seq - sequence number from the packet.
+ * @return extended sequence number.
+ */
+uint32_t rtp_source_extended_seq(const rtp_source *s, uint16_t seq);
+
 /**
  * @brief Update the packet lost count and fraction.
  *
@@ -136,6 +192,65 @@ void rtp_source_update_lost(rtp_source *s);
  */
 void rtp_source_update_jitter(rtp_source *s, uint32_t ts, uint32_t arrival);
 
+/**
+ * @brief Update the estimated jitter for a run of packets.
+ *
+ * Equivalent to calling rtp_source_update_jitter() for each packet in
+ * order. The transit time differences are computed in a separate pass that
+ * the compiler can vectorize, leaving only the filter itself serial.
+ *
+ * @param [in,out] s - source to update.
+ * @param [in] ts - the timestamps from the rtp packets.
+ * @param [in] arrival - the packet arrival times in the same units as ts.
+ * @param [in] n - number of packets.
+ */
+void rtp_source_update_jitter_batch(
+    rtp_source *s, const uint32_t *ts, const uint32_t *arrival, size_t n);
+
+/**
+ * @brief Returns the estimated jitter in timestamp units.
+ *
+ * @param [in] s - source.
+ * @return interarrival jitter as reported in RTCP.
+ */
+static inline uint32_t rtp_source_jitter(const rtp_source *s)
+{
+#if LIBRTP_JITTER_FIXED
+    return s->jitter >> 4;
+#else
+    return (uint32_t)s->jitter;
+#endif
+}
+
+/**
+ * @brief Convert a receive time to RTP timestamp units.
+ *
+ * Only the low 32 bits are kept, which is all the jitter calculation needs.
+ *
+ * @param [in] t - time, e.g. a kernel receive timestamp.
+ * @param [in] clock_rate - RTP clock rate of the stream in Hz.
+ * @return time in RTP timestamp units.
+ */
+uint32_t rtp_timespec_to_rtp(const struct timespec *t, uint32_t clock_rate);
+
+/**
+ * @brief Update the estimated jitter from a packet's receive time.
+ *
+ * Converts the arrival time to the stream's clock rate and updates the
+ * jitter estimate. Passing the kernel receive timestamp from the transport
+ * keeps scheduling delay out of the estimate and avoids reading the clock.
+ *
+ * @param [in,out] s - source to update.
+ * @param [in] ts - the timestamp from the rtp packet.
+ * @param [in] arrival - the packet arrival time.
+ * @param [in] clock_rate - RTP clock rate of the stream in Hz.
+ */
+void rtp_source_update_arrival(
+    rtp_source *s,
+    uint32_t ts,
+    const struct timespec *arrival,
+    uint32_t clock_rate);
+
 /**
  * @brief Update the LSR field.
  *
@@ -0,0 +1,245 @@
+/**
+ * @file rtp_source_map.h
+ * @brief Concurrent table of RTP sources.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_SOURCE_MAP_H_
+#define LIBRTP_RTP_SOURCE_MAP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "ntp.h"
+#include "rtcp_report.h"
+#include "rtp_alloc.h"
+#include "rtp_source.h"
+
+/**
+ * @brief The most threads that can read a map at once.
+ */
+#ifndef LIBRTP_SOURCE_MAP_THREADS
+#define LIBRTP_SOURCE_MAP_THREADS (64)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Table of sources keyed by SSRC, shared between threads.
+ *
+ * Built for receive workers that update sources while a separate thread
+ * generates RTCP reports from them:
+ *
+ * - Lookups and iteration take no locks. Each thread registers once with
+ *   rtp_source_map_join() and brackets its accesses with
+ *   rtp_source_map_read_lock() and rtp_source_map_read_unlock(), which only
+ *   publish the thread's epoch.
+ * - Insert and remove are serialized by a spinlock. Removed entries are
+ *   freed once every thread has left the epoch they were removed in, so a
+ *   reader never sees freed memory.
+ * - Each source has a single writer, e.g. the shard that owns its SSRC.
+ *   Updates are wrapped in rtp_source_map_write_begin() and
+ *   rtp_source_map_write_end(), a sequence lock that readers retry on
+ *   rather than wait for.
+ * - Report state (the interval counters and the last SR time) belongs to
+ *   the reporting thread, see rtp_source_map_report().
+ *
+ * Packet receipt therefore never blocks on report generation.
+ */
+typedef struct rtp_source_map rtp_source_map;
+
+/**
+ * @brief A source in a map, see rtp_source_map_find().
+ */
+typedef struct rtp_source_map_entry rtp_source_map_entry;
+
+/**
+ * @brief Allocate a new source map.
+ *
+ * The bucket count is fixed, sized for the expected number of sources so
+ * chains stay short.
+ *
+ * @param [in] buckets - number of hash buckets, rounded up to a power of two.
+ * @return rtp_source_map*
+ */
+rtp_source_map *rtp_source_map_create(size_t buckets);
+
+/**
+ * @brief Allocate a new source map using a specific allocator.
+ *
+ * The allocator must be thread-safe.
+ *
+ * @param [in] buckets - number of hash buckets, rounded up to a power of two.
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return rtp_source_map*
+ */
+rtp_source_map *rtp_source_map_create_with_allocator(
+    size_t buckets, const rtp_allocator *allocator);
+
+/**
+ * @brief Free a source map and every source in it.
+ *
+ * No other thread may be using the map.
+ *
+ * @param [out] m - map to free.
+ */
+void rtp_source_map_free(rtp_source_map *m);
+
+/**
+ * @brief Register the calling thread as a reader.
+ *
+ * @param [in,out] m - map.
+ * @return reader id or -1 if LIBRTP_SOURCE_MAP_THREADS are registered.
+ */
+int rtp_source_map_join(rtp_source_map *m);
+
+/**
+ * @brief Release a reader id from rtp_source_map_join().
+ *
+ * @param [in,out] m - map.
+ * @param [in] reader - reader id, must not be in a read section.
+ */
+void rtp_source_map_leave(rtp_source_map *m, int reader);
+
+/**
+ * @brief Enter a read section.
+ *
+ * Entries found inside the section stay valid until it ends, even if they
+ * are removed meanwhile. Sections should be short, e.g. one receive batch,
+ * since they hold back reclamation.
+ *
+ * @param [in,out] m - map.
+ * @param [in] reader - reader id.
+ */
+void rtp_source_map_read_lock(rtp_source_map *m, int reader);
+
+/**
+ * @brief Leave a read section.
+ *
+ * @param [in,out] m - map.
+ * @param [in] reader - reader id.
+ */
+void rtp_source_map_read_unlock(rtp_source_map *m, int reader);
+
+/**
+ * @brief Returns the number of sources.
+ *
+ * @param [in] m - map.
+ * @return number of sources.
+ */
+size_t rtp_source_map_size(const rtp_source_map *m);
+
+/**
+ * @brief Find a source, inside a read section.
+ *
+ * @param [in] m - map to search.
+ * @param [in] ssrc - synchronization source.
+ * @return rtp_source_map_entry* or NULL if not found.
+ */
+rtp_source_map_entry *rtp_source_map_find(rtp_source_map *m, uint32_t ssrc);
+
+/**
+ * @brief Iterate over the sources, inside a read section.
+ *
+ * Sources added or removed during iteration may or may not be visited.
+ *
+ * @param [in] m - map.
+ * @param [in] entry - previous entry or NULL to start.
+ * @return next entry or NULL when done.
+ */
+rtp_source_map_entry *rtp_source_map_next(
+    rtp_source_map *m, rtp_source_map_entry *entry);
+
+/**
+ * @brief Add a source, or find it if already present, inside a read section.
+ *
+ * New sources are initialized with rtp_source_init().
+ *
+ * @param [in,out] m - map to update.
+ * @param [in] ssrc - synchronization source.
+ * @param [in] seq - first sequence number.
+ * @return rtp_source_map_entry* or NULL if out of memory.
+ */
+rtp_source_map_entry *rtp_source_map_insert(
+    rtp_source_map *m, uint32_t ssrc, uint16_t seq);
+
+/**
+ * @brief Remove a source.
+ *
+ * The entry is freed once no read section can still reference it.
+ *
+ * @param [in,out] m - map to update.
+ * @param [in] ssrc - synchronization source.
+ * @return 0 on success or -1 if not found.
+ */
+int rtp_source_map_remove(rtp_source_map *m, uint32_t ssrc);
+
+/**
+ * @brief Free removed entries that no reader can reference.
+ *
+ * Called by insert and remove, so this is only needed to release memory
+ * promptly after the last removal.
+ *
+ * @param [in,out] m - map.
+ */
+void rtp_source_map_reclaim(rtp_source_map *m);
+
+/**
+ * @brief Begin updating a source.
+ *
+ * Only the source's writer may call this. Pass the result to
+ * rtp_source_update_seq() and friends, then call rtp_source_map_write_end().
+ *
+ * @param [in,out] entry - entry to update.
+ * @return the writer's source state.
+ */
+rtp_source *rtp_source_map_write_begin(rtp_source_map_entry *entry);
+
+/**
+ * @brief Publish an update started with rtp_source_map_write_begin().
+ *
+ * @param [in,out] entry - entry that was updated.
+ */
+void rtp_source_map_write_end(rtp_source_map_entry *entry);
+
+/**
+ * @brief Read a consistent copy of a source from any thread.
+ *
+ * Never waits on the writer, a copy torn by a concurrent update is retried.
+ *
+ * @param [in] entry - entry to read.
+ * @param [out] s - copy of the source.
+ */
+void rtp_source_map_read(const rtp_source_map_entry *entry, rtp_source *s);
+
+/**
+ * @brief Record the arrival of a sender report, on the reporting thread.
+ *
+ * @param [in,out] entry - entry that sent the report.
+ * @param [in] lsr - arrival time of the report.
+ */
+void rtp_source_map_update_lsr(rtp_source_map_entry *entry, ntp_tv lsr);
+
+/**
+ * @brief Build a reception report block, on the reporting thread.
+ *
+ * Takes a snapshot of the source, applies rtp_source_update_lost() against
+ * the reporting thread's interval counters and passes the result to
+ * rtcp_report_init().
+ *
+ * @param [in,out] entry - entry to report on.
+ * @param [out] report - report block to initialize.
+ * @param [in] tc - current time.
+ */
+void rtp_source_map_report(
+    rtp_source_map_entry *entry, rtcp_report *report, ntp_tv tc);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_SOURCE_MAP_H_
@@ -0,0 +1,204 @@
+/**
+ * @file rtp_source_table.h
+ * @brief Hash-indexed table of RTP sources.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_SOURCE_TABLE_H_
+#define LIBRTP_RTP_SOURCE_TABLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rtp_alloc.h"
+#include "rtp_source.h"
+#include "rtp_timer_wheel.h"
+
+/**
+ * @brief Status returned by rtp_source_table_receive().
+ */
+typedef enum rtp_source_status {
+    RTP_SOURCE_COLLISION = -3,  /**< Packet uses the local SSRC (§8.2). */
+    RTP_SOURCE_CONFLICT = -2,   /**< Known SSRC from a new address (§8.2). */
+    RTP_SOURCE_NO_MEMORY = -1,  /**< New source could not be stored. */
+    RTP_SOURCE_FOUND = 0,       /**< Existing source. */
+    RTP_SOURCE_NEW = 1,         /**< Source was added. */
+} rtp_source_status;
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Called when a source times out, just before it is removed.
+ *
+ * The handler must not add or remove sources.
+ *
+ * @param [in] ctx - user context from rtp_source_table_set_timeout().
+ * @param [in] source - source that timed out.
+ */
+typedef void (*rtp_source_timeout_handler)(void *ctx, rtp_source *source);
+
+/**
+ * @brief Table of sources keyed by SSRC.
+ *
+ * Sources are stored inline in a dense array, so iterating with
+ * rtp_source_table_at() walks contiguous memory, e.g. when building RTCP
+ * reports. A robin-hood hash index maps each SSRC to its array position.
+ * Adding or removing sources moves them, invalidating earlier pointers.
+ */
+typedef struct rtp_source_table rtp_source_table;
+
+/**
+ * @brief Allocate a new source table.
+ *
+ * @param [in] capacity - number of sources to reserve space for.
+ * @return rtp_source_table*
+ */
+rtp_source_table *rtp_source_table_create(size_t capacity);
+
+/**
+ * @brief Allocate a new source table using a specific allocator.
+ *
+ * @param [in] capacity - number of sources to reserve space for.
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return rtp_source_table*
+ */
+rtp_source_table *rtp_source_table_create_with_allocator(
+    size_t capacity, const rtp_allocator *allocator);
+
+/**
+ * @brief Free a source table.
+ *
+ * @param [out] t - table to free.
+ */
+void rtp_source_table_free(rtp_source_table *t);
+
+/**
+ * @brief Set the local SSRC for collision detection.
+ *
+ * @param [out] t - table to update.
+ * @param [in] ssrc - our own synchronization source.
+ */
+void rtp_source_table_set_local(rtp_source_table *t, uint32_t ssrc);
+
+/**
+ * @brief Returns the number of sources.
+ *
+ * @param [in] t - table.
+ * @return number of sources.
+ */
+size_t rtp_source_table_size(const rtp_source_table *t);
+
+/**
+ * @brief Returns the source at a position, for iteration.
+ *
+ * @param [in] t - table.
+ * @param [in] index - position less than rtp_source_table_size().
+ * @return rtp_source*
+ */
+rtp_source *rtp_source_table_at(rtp_source_table *t, size_t index);
+
+/**
+ * @brief Find a source.
+ *
+ * @param [in] t - table to search.
+ * @param [in] ssrc - synchronization source.
+ * @return rtp_source* or NULL if not found.
+ */
+rtp_source *rtp_source_table_find(rtp_source_table *t, uint32_t ssrc);
+
+/**
+ * @brief Add a source, or find it if already present.
+ *
+ * New sources are initialized with rtp_source_init().
+ *
+ * @param [in,out] t - table to update.
+ * @param [in] ssrc - synchronization source.
+ * @param [in] seq - first sequence number.
+ * @return rtp_source* or NULL if out of memory.
+ */
+rtp_source *rtp_source_table_insert(
+    rtp_source_table *t, uint32_t ssrc, uint16_t seq);
+
+/**
+ * @brief Remove a source.
+ *
+ * The last source moves into the freed position.
+ *
+ * @param [in,out] t - table to update.
+ * @param [in] ssrc - synchronization source.
+ * @return 0 on success or -1 if not found.
+ */
+int rtp_source_table_remove(rtp_source_table *t, uint32_t ssrc);
+
+/**
+ * @brief Expire sources that stay silent, using a timer wheel.
+ *
+ * Each source gets a timer, armed when it is added. Received packets only
+ * record the current tick, the timer checks it on expiry and is re-armed
+ * if the source was heard from since, so the receive path never touches
+ * the wheel. Sources last heard timeout ticks ago are passed to the
+ * handler and removed when the wheel is advanced.
+ *
+ * @see IETF RFC3550 "Maintaining the Number of Session Members" (§6.3.5)
+ *
+ * @param [in,out] t - table to update.
+ * @param [in,out] w - wheel to keep the timers in, or NULL to stop.
+ * @param [in] timeout - ticks of silence before a source is removed.
+ * @param [in] handler - timeout handler, or NULL.
+ * @param [in] ctx - handler context.
+ * @return 0 on success or -1 if out of memory.
+ */
+int rtp_source_table_set_timeout(
+    rtp_source_table *t,
+    rtp_timer_wheel *w,
+    uint64_t timeout,
+    rtp_source_timeout_handler handler,
+    void *ctx);
+
+/**
+ * @brief Record that a source was heard from, for the timeout.
+ *
+ * Done by rtp_source_table_receive(), call this for sources that were
+ * found by other means, e.g. the sender of an RTCP report.
+ *
+ * @param [in,out] t - table to update.
+ * @param [in] source - source from this table.
+ */
+void rtp_source_table_touch(rtp_source_table *t, const rtp_source *source);
+
+/**
+ * @brief Look up the source of a received packet.
+ *
+ * Adds unknown sources and records the transport address each source was
+ * first seen from. A packet from a different address with a known SSRC is
+ * reported as a conflict, and one carrying the local SSRC as a collision,
+ * so the caller can apply the loop and collision rules.
+ *
+ * @see IETF RFC3550 "Collision Resolution and Loop Detection" (§8.2)
+ *
+ * @param [in,out] t - table to update.
+ * @param [in] ssrc - synchronization source from the packet.
+ * @param [in] seq - sequence number from the packet.
+ * @param [in] from - sender address, e.g. a struct sockaddr, or NULL to
+ *  skip the address check.
+ * @param [in] len - sender address length in bytes.
+ * @param [out] source - the source, set for FOUND, NEW and CONFLICT.
+ * @return rtp_source_status
+ */
+rtp_source_status rtp_source_table_receive(
+    rtp_source_table *t,
+    uint32_t ssrc,
+    uint16_t seq,
+    const void *from,
+    size_t len,
+    rtp_source **source);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_SOURCE_TABLE_H_
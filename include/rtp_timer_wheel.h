@@ -0,0 +1,176 @@
+/**
+ * @file rtp_timer_wheel.h
+ * @brief Hierarchical timer wheel.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_TIMER_WHEEL_H_
+#define LIBRTP_RTP_TIMER_WHEEL_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rtp_alloc.h"
+
+/**
+ * @brief log2 of the number of slots per level, at least 6.
+ */
+#ifndef LIBRTP_TIMER_WHEEL_BITS
+#define LIBRTP_TIMER_WHEEL_BITS (8)
+#endif
+
+/**
+ * @brief Number of levels.
+ *
+ * Timers up to 2^(LIBRTP_TIMER_WHEEL_BITS * LIBRTP_TIMER_WHEEL_LEVELS)
+ * ticks ahead are placed directly, later ones are parked in the last
+ * level until they come within range.
+ */
+#ifndef LIBRTP_TIMER_WHEEL_LEVELS
+#define LIBRTP_TIMER_WHEEL_LEVELS (4)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+typedef struct rtp_timer rtp_timer;
+
+/**
+ * @brief Called from rtp_timer_wheel_advance() when a timer expires.
+ *
+ * The handler may add or cancel any timer, including this one.
+ *
+ * @param [in] ctx - user context from rtp_timer_init().
+ * @param [in] timer - timer that expired, no longer pending.
+ */
+typedef void (*rtp_timer_handler)(void *ctx, rtp_timer *timer);
+
+/**
+ * @brief Timer, owned by the caller and linked into a wheel while pending.
+ */
+struct rtp_timer {
+    rtp_timer *next;            /**< Next timer in the slot. */
+    rtp_timer **pprev;          /**< Link to this timer, NULL if idle. */
+    uint64_t expires;           /**< Expiry tick. */
+    rtp_timer_handler handler;  /**< Expiry handler. */
+    void *ctx;                  /**< Handler context. */
+};
+
+/**
+ * @brief Hashed hierarchical timer wheel.
+ *
+ * Each level has 2^LIBRTP_TIMER_WHEEL_BITS slots, a slot of level n
+ * spanning 2^(LIBRTP_TIMER_WHEEL_BITS * n) ticks. Adding and cancelling
+ * are constant time. Advancing fires the whole first-level slot of each
+ * tick as a batch, skipping empty slots, and cascades a slot of the next
+ * level down each time a level wraps.
+ *
+ * @see Varghese & Lauck "Hashed and Hierarchical Timing Wheels" (1987)
+ */
+typedef struct rtp_timer_wheel rtp_timer_wheel;
+
+/**
+ * @brief Initialize a timer.
+ *
+ * @param [out] timer - timer to initialize.
+ * @param [in] handler - expiry handler.
+ * @param [in] ctx - handler context.
+ */
+void rtp_timer_init(rtp_timer *timer, rtp_timer_handler handler, void *ctx);
+
+/**
+ * @brief Returns non-zero if a timer is in a wheel.
+ *
+ * @param [in] timer - timer to check.
+ */
+int rtp_timer_pending(const rtp_timer *timer);
+
+/**
+ * @brief Move a timer to new memory, keeping its place in the wheel.
+ *
+ * For timers stored in arrays that compact. The source is left idle.
+ *
+ * @param [out] dst - destination, not pending.
+ * @param [in,out] src - timer to move.
+ */
+void rtp_timer_move(rtp_timer *dst, rtp_timer *src);
+
+/**
+ * @brief Allocate a new timer wheel.
+ *
+ * @param [in] now - current tick.
+ * @return rtp_timer_wheel*
+ */
+rtp_timer_wheel *rtp_timer_wheel_create(uint64_t now);
+
+/**
+ * @brief Allocate a new timer wheel using a specific allocator.
+ *
+ * @param [in] now - current tick.
+ * @param [in] allocator - allocator to use, or NULL for the global one.
+ * @return rtp_timer_wheel*
+ */
+rtp_timer_wheel *rtp_timer_wheel_create_with_allocator(
+    uint64_t now, const rtp_allocator *allocator);
+
+/**
+ * @brief Free a timer wheel.
+ *
+ * Pending timers are left linked to freed memory and must not be used
+ * with rtp_timer_pending() or cancelled afterwards.
+ *
+ * @param [out] w - wheel to free.
+ */
+void rtp_timer_wheel_free(rtp_timer_wheel *w);
+
+/**
+ * @brief Returns the tick the wheel was last advanced to.
+ *
+ * @param [in] w - wheel.
+ */
+uint64_t rtp_timer_wheel_now(const rtp_timer_wheel *w);
+
+/**
+ * @brief Returns the number of pending timers.
+ *
+ * @param [in] w - wheel.
+ */
+size_t rtp_timer_wheel_size(const rtp_timer_wheel *w);
+
+/**
+ * @brief Add a timer, or move it if it is already pending.
+ *
+ * A timer that is already due fires on the next advance.
+ *
+ * @param [in,out] w - wheel to add to.
+ * @param [in,out] timer - initialized timer.
+ * @param [in] expires - expiry tick.
+ */
+void rtp_timer_wheel_add(
+    rtp_timer_wheel *w, rtp_timer *timer, uint64_t expires);
+
+/**
+ * @brief Cancel a timer, does nothing if it is not pending.
+ *
+ * @param [in,out] w - wheel the timer was added to.
+ * @param [in,out] timer - timer to cancel.
+ */
+void rtp_timer_wheel_cancel(rtp_timer_wheel *w, rtp_timer *timer);
+
+/**
+ * @brief Advance the wheel and fire every timer due by now.
+ *
+ * @param [in,out] w - wheel to advance.
+ * @param [in] now - current tick, earlier ticks are ignored.
+ * @return number of timers fired.
+ */
+size_t rtp_timer_wheel_advance(rtp_timer_wheel *w, uint64_t now);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_TIMER_WHEEL_H_
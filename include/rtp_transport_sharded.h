@@ -0,0 +1,141 @@
+/**
+ * @file rtp_transport_sharded.h
+ * @brief Multi-threaded SO_REUSEPORT receive engine.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_TRANSPORT_SHARDED_H_
+#define LIBRTP_RTP_TRANSPORT_SHARDED_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/socket.h>
+
+#include "rtp_transport_udp.h"
+
+/**
+ * @brief The most shards, and so receive threads, per engine.
+ */
+#ifndef LIBRTP_MAX_SHARDS
+#define LIBRTP_MAX_SHARDS (64)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Sharded receive engine.
+ */
+typedef struct rtp_transport_sharded rtp_transport_sharded;
+
+/**
+ * @brief Called on a shard's thread with each batch of received packets.
+ *
+ * @param [in] ctx - user context from the config.
+ * @param [in] shard - shard that received the packets.
+ * @param [in] packets - received packets, valid until the handler returns.
+ * @param [in] n - number of packets.
+ */
+typedef void (*rtp_transport_sharded_handler)(
+    void *ctx, unsigned int shard, rtp_transport_udp_packet *packets, size_t n);
+
+/**
+ * @brief Sharded receive engine settings.
+ */
+typedef struct rtp_transport_sharded_config {
+    size_t shards;              /**< Sockets and threads, 0 for one per CPU. */
+    int ssrc_affinity;          /**< Steer each SSRC to a fixed shard. */
+    int pin;                    /**< Pin shard i's thread to CPU i. */
+    rtp_transport_udp_config udp; /**< Settings for every shard's socket. */
+    rtp_transport_sharded_handler handler; /**< Packet handler. */
+    void *ctx;                  /**< Handler context. */
+} rtp_transport_sharded_config;
+
+/**
+ * @brief Returns the shard that receives a given SSRC with ssrc_affinity.
+ *
+ * This matches the classic BPF program attached to the socket group, so
+ * per-source state can be placed on the right shard before any packets
+ * arrive.
+ *
+ * @param [in] ssrc - synchronization source.
+ * @param [in] shards - number of shards.
+ * @return shard index.
+ */
+static inline unsigned int rtp_transport_sharded_shard_of(
+    uint32_t ssrc, size_t shards)
+{
+    // Fibonacci hashing spreads sequential SSRCs across shards
+    return (unsigned int)(((ssrc * 0x9e3779b1u) >> 16) % (uint32_t)shards);
+}
+
+/**
+ * @brief Create a sharded receive engine.
+ *
+ * Opens one rtp_transport_udp per shard, all bound to addr with
+ * SO_REUSEPORT so that the kernel spreads datagrams across them. With
+ * ssrc_affinity set, a classic BPF program (SO_ATTACH_REUSEPORT_CBPF) picks
+ * the socket from the SSRC at UDP payload offset 8. Every packet of a
+ * source is then handled by the same thread, so per-source state needs no
+ * locking.
+ *
+ * @param [in] family - AF_INET or AF_INET6.
+ * @param [in] addr - local address.
+ * @param [in] len - address length.
+ * @param [in] config - settings, handler is required.
+ * @return engine or NULL on failure.
+ */
+rtp_transport_sharded *rtp_transport_sharded_create(
+    int family,
+    const struct sockaddr *addr,
+    socklen_t len,
+    const rtp_transport_sharded_config *config);
+
+/**
+ * @brief Stop the engine if running and free it.
+ *
+ * @param [out] t - engine to free.
+ */
+void rtp_transport_sharded_free(rtp_transport_sharded *t);
+
+/**
+ * @brief Start one receive thread per shard.
+ *
+ * @param [in,out] t - engine to start.
+ * @return 0 on success or -1 on failure.
+ */
+int rtp_transport_sharded_start(rtp_transport_sharded *t);
+
+/**
+ * @brief Stop and join the receive threads.
+ *
+ * @param [in,out] t - engine to stop.
+ */
+void rtp_transport_sharded_stop(rtp_transport_sharded *t);
+
+/**
+ * @brief Returns the number of shards.
+ *
+ * @param [in] t - engine.
+ * @return number of shards.
+ */
+size_t rtp_transport_sharded_count(const rtp_transport_sharded *t);
+
+/**
+ * @brief Returns a shard's transport, e.g. to read its counters.
+ *
+ * @param [in] t - engine.
+ * @param [in] shard - shard index.
+ * @return transport.
+ */
+rtp_transport_udp *rtp_transport_sharded_get(
+    rtp_transport_sharded *t, size_t shard);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_TRANSPORT_SHARDED_H_
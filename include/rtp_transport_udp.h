@@ -0,0 +1,216 @@
+/**
+ * @file rtp_transport_udp.h
+ * @brief Batched UDP transport.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_TRANSPORT_UDP_H_
+#define LIBRTP_RTP_TRANSPORT_UDP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "rtp_alloc.h"
+#include "rtp_iovec.h"
+#include "rtp_packet.h"
+#include "rtp_packet_view.h"
+
+/**
+ * @brief Default number of datagrams moved per system call.
+ */
+#ifndef LIBRTP_UDP_BATCH
+#define LIBRTP_UDP_BATCH (32)
+#endif
+
+/**
+ * @brief Default receive buffer size per datagram in bytes.
+ */
+#ifndef LIBRTP_UDP_MTU
+#define LIBRTP_UDP_MTU (2048)
+#endif
+
+/**
+ * @brief The most segments sent with one UDP_SEGMENT system call.
+ */
+#ifndef LIBRTP_UDP_GSO_SEGMENTS
+#define LIBRTP_UDP_GSO_SEGMENTS (64)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief UDP transport.
+ */
+typedef struct rtp_transport_udp rtp_transport_udp;
+
+/**
+ * @brief UDP transport settings, zero fields select the defaults.
+ *
+ * With gro set the kernel may deliver a run of same-size datagrams as one
+ * super-datagram, so the default mtu grows to 64 KiB and the default ring to
+ * two batches. With timestamps set each packet carries the CLOCK_REALTIME
+ * time the kernel received it (SO_TIMESTAMPNS), which can be passed to
+ * rtp_source_update_arrival() without reading the clock again.
+ */
+typedef struct rtp_transport_udp_config {
+    size_t batch;               /**< Datagrams per system call. */
+    size_t slots;               /**< Receive ring size, at least batch. */
+    size_t mtu;                 /**< Receive buffer size per datagram. */
+    int nonblocking;            /**< Return 0 rather than wait for data. */
+    int gro;                    /**< Accept coalesced datagrams (UDP_GRO). */
+    int timestamps;             /**< Record kernel receive times. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
+} rtp_transport_udp_config;
+
+/**
+ * @brief UDP transport counters.
+ */
+typedef struct rtp_transport_udp_stats {
+    uint64_t rx_syscalls;       /**< Receive system calls. */
+    uint64_t rx_packets;        /**< Datagrams received. */
+    uint64_t rx_invalid;        /**< Datagrams dropped as invalid RTP. */
+    uint64_t rx_truncated;      /**< Datagrams larger than the mtu. */
+    uint64_t rx_coalesced;      /**< Super-datagrams split after GRO. */
+    uint64_t tx_syscalls;       /**< Send system calls. */
+    uint64_t tx_packets;        /**< Datagrams sent. */
+    uint64_t tx_segmented;      /**< Bursts sent with UDP_SEGMENT. */
+    uint32_t rx_last_batch;     /**< Datagrams read by the last syscall. */
+    uint32_t tx_last_batch;     /**< Datagrams written by the last send. */
+} rtp_transport_udp_stats;
+
+/**
+ * @brief A received RTP packet.
+ */
+typedef struct rtp_transport_udp_packet {
+    rtp_packet_view view;           /**< Parsed packet. */
+    struct sockaddr_storage from;   /**< Sender address. */
+    socklen_t from_len;             /**< Sender address length. */
+    struct timespec arrival;        /**< Kernel receive time, or zero. */
+} rtp_transport_udp_packet;
+
+/**
+ * @brief Create a UDP transport.
+ *
+ * The socket and every receive buffer are allocated here so that sending
+ * and receiving never touch the heap.
+ *
+ * @param [in] family - AF_INET or AF_INET6.
+ * @param [in] config - settings, or NULL for the defaults.
+ * @return transport or NULL on failure.
+ */
+rtp_transport_udp *rtp_transport_udp_create(
+    int family, const rtp_transport_udp_config *config);
+
+/**
+ * @brief Close the socket and free a UDP transport.
+ *
+ * @param [out] t - transport to free.
+ */
+void rtp_transport_udp_free(rtp_transport_udp *t);
+
+/**
+ * @brief Bind the transport to a local address.
+ *
+ * @param [in,out] t - transport to bind.
+ * @param [in] addr - local address.
+ * @param [in] len - address length.
+ * @return 0 on success or -1 with errno set.
+ */
+int rtp_transport_udp_bind(
+    rtp_transport_udp *t, const struct sockaddr *addr, socklen_t len);
+
+/**
+ * @brief Set the destination for rtp_transport_udp_send().
+ *
+ * @param [in,out] t - transport to connect.
+ * @param [in] addr - remote address.
+ * @param [in] len - address length.
+ * @return 0 on success or -1 with errno set.
+ */
+int rtp_transport_udp_connect(
+    rtp_transport_udp *t, const struct sockaddr *addr, socklen_t len);
+
+/**
+ * @brief Returns the transport's socket, e.g. for poll() or epoll.
+ *
+ * @param [in] t - transport.
+ * @return socket file descriptor.
+ */
+int rtp_transport_udp_fd(const rtp_transport_udp *t);
+
+/**
+ * @brief Receive a batch of RTP packets.
+ *
+ * Reads up to the configured batch size with a single recvmmsg() call into
+ * the receive ring and parses each datagram in place. Coalesced GRO
+ * super-datagrams are split into their segments without copying, and any
+ * segments that do not fit in out are returned by the next call before the
+ * socket is read again. Invalid datagrams are counted and dropped. The
+ * returned views point into the ring and remain valid until another slots
+ * datagrams have been read from the socket.
+ *
+ * @param [in,out] t - transport to receive on.
+ * @param [out] out - packets.
+ * @param [in] n - size of out.
+ * @return number of packets, 0 if none are ready, or -1 with errno set.
+ */
+int rtp_transport_udp_recv(
+    rtp_transport_udp *t, rtp_transport_udp_packet *out, size_t n);
+
+/**
+ * @brief Send datagrams to the connected destination.
+ *
+ * Each iovec is one datagram. Datagrams are sent with one sendmmsg() call
+ * per batch.
+ *
+ * @param [in,out] t - transport to send on.
+ * @param [in] datagrams - datagrams to send.
+ * @param [in] n - number of datagrams.
+ * @return number of datagrams sent or -1 with errno set.
+ */
+int rtp_transport_udp_send(
+    rtp_transport_udp *t, const struct iovec *datagrams, size_t n);
+
+/**
+ * @brief Send a burst of same-size packets with segmentation offload.
+ *
+ * The packets are serialized back-to-back into buffer and handed to the
+ * kernel as one UDP_SEGMENT super-datagram per LIBRTP_UDP_GSO_SEGMENTS
+ * packets, which splits them into individual datagrams. Every packet must
+ * be the same size, except the last which may be shorter. If the kernel
+ * does not support segmentation offload the burst is sent with sendmmsg().
+ *
+ * @param [in,out] t - transport to send on.
+ * @param [in] packets - packets to send.
+ * @param [in] n - number of packets.
+ * @param [out] buffer - buffer to serialize the burst into.
+ * @param [in] size - buffer size.
+ * @return number of packets sent or -1 on failure.
+ */
+int rtp_transport_udp_send_burst(
+    rtp_transport_udp *t,
+    rtp_packet *const *packets,
+    size_t n,
+    uint8_t *buffer,
+    size_t size);
+
+/**
+ * @brief Read the transport counters.
+ *
+ * @param [in] t - transport to read.
+ * @param [out] stats - counters.
+ */
+void rtp_transport_udp_get_stats(
+    const rtp_transport_udp *t, rtp_transport_udp_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_TRANSPORT_UDP_H_
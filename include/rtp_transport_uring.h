@@ -0,0 +1,183 @@
+/**
+ * @file rtp_transport_uring.h
+ * @brief io_uring UDP transport.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#ifndef LIBRTP_RTP_TRANSPORT_URING_H_
+#define LIBRTP_RTP_TRANSPORT_URING_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "rtp_alloc.h"
+#include "rtp_iovec.h"
+#include "rtp_packet_view.h"
+
+/**
+ * @brief Default submission queue size.
+ */
+#ifndef LIBRTP_URING_ENTRIES
+#define LIBRTP_URING_ENTRIES (256)
+#endif
+
+/**
+ * @brief Default number of provided receive buffers, a power of two.
+ */
+#ifndef LIBRTP_URING_BUFFERS
+#define LIBRTP_URING_BUFFERS (512)
+#endif
+
+/**
+ * @brief Default size of each receive and send buffer in bytes.
+ */
+#ifndef LIBRTP_URING_BUFFER_SIZE
+#define LIBRTP_URING_BUFFER_SIZE (2048)
+#endif
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief io_uring transport serving any number of UDP sockets.
+ */
+typedef struct rtp_transport_uring rtp_transport_uring;
+
+/**
+ * @brief io_uring transport settings, zero fields select the defaults.
+ *
+ * With timestamps set, every added socket has SO_TIMESTAMPNS enabled and
+ * each packet carries the time the kernel received it.
+ */
+typedef struct rtp_transport_uring_config {
+    size_t entries;             /**< Submission queue size. */
+    size_t buffers;             /**< Provided receive buffers. */
+    size_t buffer_size;         /**< Size of each buffer. */
+    int nonblocking;            /**< Return 0 rather than wait for data. */
+    int timestamps;             /**< Record kernel receive times. */
+    const rtp_allocator *allocator; /**< Allocator, NULL for the global one. */
+} rtp_transport_uring_config;
+
+/**
+ * @brief io_uring transport counters.
+ */
+typedef struct rtp_transport_uring_stats {
+    uint64_t syscalls;          /**< io_uring_enter() calls. */
+    uint64_t rx_packets;        /**< Datagrams received. */
+    uint64_t rx_invalid;        /**< Datagrams dropped as invalid RTP. */
+    uint64_t rx_truncated;      /**< Datagrams larger than a buffer. */
+    uint64_t rx_rearmed;        /**< Multishot receives restarted. */
+    uint64_t tx_packets;        /**< Datagrams sent. */
+    uint64_t tx_errors;         /**< Sends that failed. */
+} rtp_transport_uring_stats;
+
+/**
+ * @brief A received RTP packet.
+ */
+typedef struct rtp_transport_uring_packet {
+    rtp_packet_view view;           /**< Parsed packet. */
+    struct sockaddr_storage from;   /**< Sender address. */
+    socklen_t from_len;             /**< Sender address length. */
+    int socket;                     /**< Socket index from add(). */
+    struct timespec arrival;        /**< Kernel receive time, or zero. */
+} rtp_transport_uring_packet;
+
+/**
+ * @brief Create an io_uring transport.
+ *
+ * The ring, the provided receive buffers and the send buffers are all
+ * allocated here. The io_uring interface is used through raw system calls,
+ * so no liburing is required.
+ *
+ * @param [in] config - settings, or NULL for the defaults.
+ * @return transport or NULL if io_uring is unavailable.
+ */
+rtp_transport_uring *rtp_transport_uring_create(
+    const rtp_transport_uring_config *config);
+
+/**
+ * @brief Free an io_uring transport.
+ *
+ * Sockets passed to rtp_transport_uring_add() are not closed.
+ *
+ * @param [out] t - transport to free.
+ */
+void rtp_transport_uring_free(rtp_transport_uring *t);
+
+/**
+ * @brief Add a bound UDP socket to the transport.
+ *
+ * Queues a multishot recvmsg() on the socket that keeps delivering
+ * datagrams into the provided buffers until the transport is freed. The
+ * socket remains owned by the caller and must stay open while the transport
+ * exists.
+ *
+ * @param [in,out] t - transport.
+ * @param [in] fd - UDP socket.
+ * @return socket index or -1 on failure.
+ */
+int rtp_transport_uring_add(rtp_transport_uring *t, int fd);
+
+/**
+ * @brief Receive RTP packets from every socket.
+ *
+ * Submits any queued sends, then reaps completions from the shared
+ * completion queue. Each packet's view points into the provided buffer the
+ * kernel received it into, and remains valid until the next call, which
+ * hands the buffers back to the kernel.
+ *
+ * @param [in,out] t - transport.
+ * @param [out] out - packets.
+ * @param [in] n - size of out.
+ * @return number of packets, 0 if none are ready, or -1 with errno set.
+ */
+int rtp_transport_uring_recv(
+    rtp_transport_uring *t, rtp_transport_uring_packet *out, size_t n);
+
+/**
+ * @brief Queue datagrams to a connected socket.
+ *
+ * Each iovec is copied into a send buffer and queued as one sendmsg()
+ * submission entry. Nothing is submitted until the next
+ * rtp_transport_uring_recv() or rtp_transport_uring_submit(), so sends to
+ * many sockets share a single system call.
+ *
+ * @param [in,out] t - transport.
+ * @param [in] socket - socket index from add().
+ * @param [in] datagrams - datagrams to send.
+ * @param [in] n - number of datagrams.
+ * @return number of datagrams queued or -1 with errno set.
+ */
+int rtp_transport_uring_send(
+    rtp_transport_uring *t,
+    int socket,
+    const struct iovec *datagrams,
+    size_t n);
+
+/**
+ * @brief Submit queued sends without waiting for completions.
+ *
+ * @param [in,out] t - transport.
+ * @return 0 on success or -1 with errno set.
+ */
+int rtp_transport_uring_submit(rtp_transport_uring *t);
+
+/**
+ * @brief Read the transport counters.
+ *
+ * @param [in] t - transport to read.
+ * @param [out] stats - counters.
+ */
+void rtp_transport_uring_get_stats(
+    const rtp_transport_uring *t, rtp_transport_uring_stats *stats);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_TRANSPORT_URING_H_
@@ -0,0 +1,87 @@
+/**
+ * @file alloc.h
+ * @brief Internal allocation helpers.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#ifndef LIBRTP_ALLOC_H_
+#define LIBRTP_ALLOC_H_
+
+#include "rtp_alloc.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Resolve an object's allocator.
+ *
+ * @param [in] a - allocator or NULL for the global allocator.
+ * @return allocator.
+ * @private
+ */
+static inline const rtp_allocator *rtp_allocator_or_default(
+    const rtp_allocator *a)
+{
+    return a ? a : rtp_get_allocator();
+}
+
+/**
+ * @brief Allocate memory.
+ *
+ * @param [in] a - allocator or NULL for the global allocator.
+ * @param [in] size - number of bytes.
+ * @return memory or NULL on failure.
+ * @private
+ */
+static inline void *rtp_malloc(const rtp_allocator *a, size_t size)
+{
+    a = rtp_allocator_or_default(a);
+    return a->alloc(a->ctx, size);
+}
+
+/**
+ * @brief Allocate zeroed memory for an array.
+ *
+ * @param [in] a - allocator or NULL for the global allocator.
+ * @param [in] nmemb - number of elements.
+ * @param [in] size - element size.
+ * @return memory or NULL on failure.
+ * @private
+ */
+void *rtp_calloc(const rtp_allocator *a, size_t nmemb, size_t size);
+
+/**
+ * @brief Resize memory.
+ *
+ * @param [in] a - allocator or NULL for the global allocator.
+ * @param [in] ptr - memory to resize, may be NULL.
+ * @param [in] size - new size in bytes.
+ * @return memory or NULL on failure.
+ * @private
+ */
+static inline void *rtp_realloc(const rtp_allocator *a, void *ptr, size_t size)
+{
+    a = rtp_allocator_or_default(a);
+    return a->resize(a->ctx, ptr, size);
+}
+
+/**
+ * @brief Release memory.
+ *
+ * @param [in] a - allocator or NULL for the global allocator.
+ * @param [in] ptr - memory to release, may be NULL.
+ * @private
+ */
+static inline void rtp_free(const rtp_allocator *a, void *ptr)
+{
+    a = rtp_allocator_or_default(a);
+    a->release(a->ctx, ptr);
+}
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_ALLOC_H_
@@ -58,8 +58,5 @@ uint32_t ntp_short(ntp_tv ntp)
 
 ntp_tv ntp_diff(ntp_tv a, ntp_tv b)
 {
-    double s1 = ntp_to_double(a);
-    double s2 = ntp_to_double(b);
-
-    return ntp_from_double(s1 - s2);
-}
\ No newline at end of file
+    return ntp64_to_tv(ntp64_sub(ntp64_from_tv(a), ntp64_from_tv(b)));
+}
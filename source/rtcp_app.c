@@ -10,13 +10,23 @@
 #include <assert.h>
 
 #include "rtcp_app.h"
+#include "alloc.h"
 #include "util.h"
 
 rtcp_app *rtcp_app_create()
 {
-    rtcp_app *packet = (rtcp_app*)malloc(sizeof(rtcp_app));
-    if(packet)
+    return rtcp_app_create_with_allocator(NULL);
+}
+
+rtcp_app *rtcp_app_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtcp_app *packet = (rtcp_app*)rtp_malloc(allocator, sizeof(rtcp_app));
+    if(packet) {
         memset(packet, 0, sizeof(rtcp_app));
+        packet->allocator = allocator;
+    }
 
     return packet;
 }
@@ -26,9 +36,9 @@ void rtcp_app_free(rtcp_app *packet)
     assert(packet != NULL);
 
     if(packet->app_data)
-        free(packet->app_data);
+        rtp_free(packet->allocator, packet->app_data);
 
-    free(packet);
+    rtp_free(packet->allocator, packet);
 }
 
 void rtcp_app_init(rtcp_app *packet, uint8_t subtype)
@@ -93,7 +103,7 @@ int rtcp_app_parse(rtcp_app *packet, const uint8_t *buffer, size_t size)
     const size_t length = (packet->header.common.length + 1) * 4U;
     if(length > 12) {
         packet->app_size = length - 12;
-        packet->app_data = malloc(packet->app_size);
+        packet->app_data = rtp_malloc(packet->allocator, packet->app_size);
         memcpy(packet->app_data, buffer + 12, packet->app_size);
     }
 
@@ -108,7 +118,7 @@ int rtcp_app_set_data(rtcp_app *packet, const void *data, size_t size)
     if(packet->app_data)
         return -1;
 
-    packet->app_data = malloc(size);
+    packet->app_data = rtp_malloc(packet->allocator, size);
     if(!packet->app_data)
         return -1;
 
@@ -126,7 +136,7 @@ void rtcp_app_clear_data(rtcp_app *packet)
     assert(packet != NULL);
 
     if(packet->app_data) {
-        free(packet->app_data);
+        rtp_free(packet->allocator, packet->app_data);
         packet->app_data = NULL;
         packet->app_size = 0;
     }
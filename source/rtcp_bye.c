@@ -11,13 +11,23 @@
 #include <assert.h>
 
 #include "rtcp_bye.h"
+#include "alloc.h"
 #include "util.h"
 
 rtcp_bye *rtcp_bye_create()
 {
-    rtcp_bye *packet = (rtcp_bye*)malloc(sizeof(rtcp_bye));
-    if(packet)
+    return rtcp_bye_create_with_allocator(NULL);
+}
+
+rtcp_bye *rtcp_bye_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtcp_bye *packet = (rtcp_bye*)rtp_malloc(allocator, sizeof(rtcp_bye));
+    if(packet) {
         memset(packet, 0, sizeof(rtcp_bye));
+        packet->allocator = allocator;
+    }
 
     return packet;
 }
@@ -26,13 +36,13 @@ void rtcp_bye_free(rtcp_bye *packet)
 {
     assert(packet != NULL);
 
-    if(!packet->src_ids)
-        free(packet->src_ids);
+    if(packet->src_ids)
+        rtp_free(packet->allocator, packet->src_ids);
 
-    if(!packet->message)
-        free(packet->message);
+    if(packet->message)
+        rtp_free(packet->allocator, packet->message);
 
-    free(packet);
+    rtp_free(packet->allocator, packet);
 }
 
 void rtcp_bye_init(rtcp_bye *packet)
@@ -84,6 +94,9 @@ int rtcp_bye_serialize(const rtcp_bye *packet, uint8_t *buffer, size_t size)
 
         memcpy(buffer + offset, packet->message, size);
         offset += size;
+
+        // Pad the reason to a 32-bit boundary with zeros
+        memset(buffer + offset, 0, packet_size - offset);
     }
 
     return (int)packet_size;
@@ -105,12 +118,10 @@ int rtcp_bye_parse(
     size_t offset = 4;
     if(packet->header.common.count) {
         // Parse sources
-        if(size < 4 + (4U * packet->header.common.count)) {
-            free(packet);
+        if(size < 4 + (4U * packet->header.common.count))
             return -1;
-        }
 
-        packet->src_ids = (uint32_t*)calloc(
+        packet->src_ids = (uint32_t*)rtp_calloc(packet->allocator,
             packet->header.common.count, sizeof(uint32_t));
 
         for(uint8_t i = 0; i < packet->header.common.count; ++i) {
@@ -125,9 +136,9 @@ int rtcp_bye_parse(
         if(length > size - offset)
             length = size - offset;
 
-        packet->message = (char *)malloc(length + 1);
+        packet->message = (char *)rtp_malloc(packet->allocator, length + 1);
         memcpy(packet->message, buffer + offset, length);
-        packet->message[length + 1] = '\0';
+        packet->message[length] = '\0';
     }
 
     return 0;
@@ -150,7 +161,8 @@ int rtcp_bye_add_source(rtcp_bye *packet, uint32_t src_id)
     assert(packet != NULL);
 
     if(!packet->header.common.count) {
-        packet->src_ids = (uint32_t*)malloc(sizeof(uint32_t));
+        packet->src_ids = (uint32_t*)rtp_malloc(
+            packet->allocator, sizeof(uint32_t));
         packet->header.common.count = 1;
     }
     else {
@@ -163,7 +175,8 @@ int rtcp_bye_add_source(rtcp_bye *packet, uint32_t src_id)
         packet->header.common.count += 1;
 
         const size_t nmemb = packet->header.common.count * sizeof(uint32_t);
-        packet->src_ids = (uint32_t*)realloc(packet->src_ids, nmemb);
+        packet->src_ids = (uint32_t*)rtp_realloc(
+            packet->allocator, packet->src_ids, nmemb);
     }
 
     packet->src_ids[packet->header.common.count - 1] = src_id;
@@ -182,7 +195,7 @@ void rtcp_bye_remove_source(rtcp_bye *packet, uint32_t src_id)
     if(index < 0)
         return;
 
-    const size_t size = (unsigned)(packet->header.common.count - index)
+    const size_t size = (unsigned)(packet->header.common.count - index - 1)
         * sizeof(uint32_t);
 
     if(size)
@@ -191,10 +204,11 @@ void rtcp_bye_remove_source(rtcp_bye *packet, uint32_t src_id)
     packet->header.common.count -= 1;
     if(packet->header.common.count > 0) {
         const size_t nmemb = packet->header.common.count * sizeof(uint32_t);
-        packet->src_ids = (uint32_t*)realloc(packet->src_ids, nmemb);
+        packet->src_ids = (uint32_t*)rtp_realloc(
+            packet->allocator, packet->src_ids, nmemb);
     }
     else {
-        free(packet->src_ids);
+        rtp_free(packet->allocator, packet->src_ids);
         packet->src_ids = NULL;
     }
 
@@ -211,7 +225,7 @@ int rtcp_bye_set_message(rtcp_bye *packet, const char *message)
         return -1;
 
     const size_t size = strlen(message);
-    packet->message = (char*)malloc(size + 1);
+    packet->message = (char*)rtp_malloc(packet->allocator, size + 1);
     if(!packet->message)
         return -1;
 
@@ -227,7 +241,7 @@ void rtcp_bye_clear_message(rtcp_bye *packet)
 {
     assert(packet != NULL);
 
-    free(packet->message);
+    rtp_free(packet->allocator, packet->message);
     packet->message = NULL;
 
     // Update header length
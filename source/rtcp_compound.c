@@ -0,0 +1,607 @@
+/**
+ * @file rtcp_compound.c
+ * @brief Compound RTCP packets.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtcp
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "rtcp_compound.h"
+#include "util.h"
+
+/**
+ * @brief Check the chunks of a SDES packet.
+ *
+ * @param [in] data - first chunk.
+ * @param [in] size - size of the chunks.
+ * @param [in] count - number of chunks.
+ * @return 0 if the chunks exactly fill size.
+ * @private
+ */
+static int check_sdes(const uint8_t *data, size_t size, uint8_t count)
+{
+    size_t offset = 0;
+    for(uint8_t i = 0; i < count; ++i) {
+        if(size - offset < 4)
+            return -1;
+
+        offset += 4;
+        for(;;) {
+            if(offset >= size)
+                return -1;
+
+            if(data[offset] == RTCP_SDES_END)
+                break;
+
+            if(size - offset < 2 || size - offset - 2 < data[offset + 1])
+                return -1;
+
+            offset += 2 + data[offset + 1];
+        }
+
+        // END item, then null octets up to the next 32-bit boundary
+        offset = (offset + 4) & ~(size_t)3;
+        if(offset > size)
+            return -1;
+    }
+
+    return (offset == size) ? 0 : -1;
+}
+
+/**
+ * @brief Decode one packet into a view.
+ *
+ * @param [out] view - view to fill.
+ * @param [in] data - packet, starting at the header.
+ * @param [in] size - packet size less padding.
+ * @return 0 on success or -1 if the contents do not fit.
+ * @private
+ */
+static int decode(rtcp_view *view, const uint8_t *data, size_t size)
+{
+    memset(view, 0, sizeof(rtcp_view));
+    view->pt = data[1];
+    view->count = data[0] & 0x1f;
+    view->data = data;
+    view->size = size;
+
+    const size_t blocks = 24U * view->count;
+    switch(view->pt) {
+        case RTCP_SR: {
+            rtcp_report_view *sr = &view->body.sr;
+            if(size < 28 + blocks)
+                return -1;
+
+            sr->ssrc = read_u32(data + 4);
+            sr->ntp_sec = read_u32(data + 8);
+            sr->ntp_frac = read_u32(data + 12);
+            sr->rtp_ts = read_u32(data + 16);
+            sr->pkt_count = read_u32(data + 20);
+            sr->byte_count = read_u32(data + 24);
+            sr->reports = data + 28;
+            sr->ext_size = size - 28 - blocks;
+            if(sr->ext_size)
+                sr->ext_data = data + 28 + blocks;
+            break;
+        }
+        case RTCP_RR: {
+            rtcp_report_view *rr = &view->body.rr;
+            if(size < 8 + blocks)
+                return -1;
+
+            rr->ssrc = read_u32(data + 4);
+            rr->reports = data + 8;
+            rr->ext_size = size - 8 - blocks;
+            if(rr->ext_size)
+                rr->ext_data = data + 8 + blocks;
+            break;
+        }
+        case RTCP_SDES:
+            if(check_sdes(data + 4, size - 4, view->count) < 0)
+                return -1;
+
+            view->body.sdes.chunks = data + 4;
+            view->body.sdes.size = size - 4;
+            break;
+        case RTCP_BYE: {
+            rtcp_bye_view *bye = &view->body.bye;
+            const size_t offset = 4 + (4U * view->count);
+            if(size < offset)
+                return -1;
+
+            bye->src_ids = data + 4;
+            if(size > offset) {
+                bye->reason_length = data[offset];
+                if(bye->reason_length > size - offset - 1)
+                    return -1;
+
+                bye->reason = (const char*)(data + offset + 1);
+            }
+            break;
+        }
+        case RTCP_APP: {
+            rtcp_app_view *app = &view->body.app;
+            if(size < 12)
+                return -1;
+
+            app->ssrc = read_u32(data + 4);
+            app->name = read_u32(data + 8);
+            app->app_size = size - 12;
+            if(app->app_size)
+                app->app_data = data + 12;
+            break;
+        }
+        default:
+            // Unknown types are passed through for the caller to ignore
+            break;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Find the size of the packet at an offset, less padding.
+ *
+ * @param [in] it - iterator.
+ * @param [in] offset - packet offset.
+ * @param [out] length - packet size including padding.
+ * @param [out] size - packet size less padding.
+ * @return rtcp_compound_status.
+ * @private
+ */
+static int measure(
+    const rtcp_compound_iter *it, size_t offset, size_t *length, size_t *size)
+{
+    const uint8_t *data = it->buffer + offset;
+    if(it->size - offset < 4)
+        return RTCP_COMPOUND_SHORT;
+
+    if((data[0] >> 6) != 2)
+        return RTCP_COMPOUND_VERSION;
+
+    *length = (read_u16(data + 2) + 1U) * 4U;
+    if(*length > it->size - offset)
+        return RTCP_COMPOUND_SHORT;
+
+    *size = *length;
+    if(data[0] & 0x20) {
+        // Only the last packet may be padded, the count includes itself
+        const uint8_t padding = data[*length - 1];
+        if(offset + *length != it->size
+            || padding == 0 || padding > *length - 4)
+            return RTCP_COMPOUND_PADDING;
+
+        *size -= padding;
+    }
+
+    return RTCP_COMPOUND_OK;
+}
+
+int rtcp_compound_iter_init(
+    rtcp_compound_iter *it, const uint8_t *buffer, size_t size)
+{
+    assert(it != NULL);
+    assert(buffer != NULL);
+
+    it->buffer = buffer;
+    it->size = size;
+    it->offset = 0;
+
+    int status = RTCP_COMPOUND_OK;
+    if(size < 4 || (size % 4) != 0)
+        status = RTCP_COMPOUND_SHORT;
+    else if(buffer[1] != RTCP_SR && buffer[1] != RTCP_RR)
+        status = RTCP_COMPOUND_FIRST;
+    else if(buffer[0] & 0x20)
+        status = RTCP_COMPOUND_PADDING;
+
+    size_t offset = 0;
+    while(status == RTCP_COMPOUND_OK && offset < size) {
+        size_t length, payload;
+        rtcp_view view;
+
+        status = measure(it, offset, &length, &payload);
+        if(status == RTCP_COMPOUND_OK
+            && decode(&view, buffer + offset, payload) < 0)
+            status = RTCP_COMPOUND_FORMAT;
+
+        offset += length;
+    }
+
+    if(status != RTCP_COMPOUND_OK)
+        it->size = 0;
+
+    return status;
+}
+
+int rtcp_compound_iter_next(rtcp_compound_iter *it, rtcp_view *view)
+{
+    assert(it != NULL);
+    assert(view != NULL);
+
+    if(it->offset >= it->size)
+        return 0;
+
+    // Already validated by rtcp_compound_iter_init()
+    size_t length = 0, size = 0;
+    measure(it, it->offset, &length, &size);
+    decode(view, it->buffer + it->offset, size);
+
+    it->offset += length;
+    return 1;
+}
+
+void rtcp_view_report(
+    const rtcp_view *view, uint8_t index, rtcp_report *report)
+{
+    assert(view != NULL);
+    assert(view->pt == RTCP_SR || view->pt == RTCP_RR);
+    assert(index < view->count);
+
+    // SR and RR share the layout of the report list
+    const uint8_t *block = view->body.sr.reports + (24 * index);
+    rtcp_report_parse(report, block, 24);
+}
+
+uint32_t rtcp_view_bye_src(const rtcp_view *view, uint8_t index)
+{
+    assert(view != NULL);
+    assert(view->pt == RTCP_BYE);
+    assert(index < view->count);
+
+    return read_u32(view->body.bye.src_ids + (4 * index));
+}
+
+int rtcp_view_next_chunk(
+    const rtcp_view *view, size_t *offset, rtcp_sdes_chunk_view *chunk)
+{
+    assert(view != NULL);
+    assert(view->pt == RTCP_SDES);
+    assert(offset != NULL);
+    assert(chunk != NULL);
+
+    const uint8_t *data = view->body.sdes.chunks;
+    const size_t size = view->body.sdes.size;
+    if(*offset >= size)
+        return 0;
+
+    chunk->src = read_u32(data + *offset);
+    chunk->items = data + *offset + 4;
+
+    // Chunks were checked, so the END item is always found
+    size_t end = *offset + 4;
+    while(data[end] != RTCP_SDES_END)
+        end += 2 + data[end + 1];
+
+    chunk->size = end - (*offset + 4);
+    *offset = (end + 4) & ~(size_t)3;
+    return 1;
+}
+
+int rtcp_sdes_chunk_next_item(
+    const rtcp_sdes_chunk_view *chunk,
+    size_t *offset,
+    rtcp_sdes_item_view *item)
+{
+    assert(chunk != NULL);
+    assert(offset != NULL);
+    assert(item != NULL);
+
+    if(*offset >= chunk->size)
+        return 0;
+
+    item->type = chunk->items[*offset];
+    item->length = chunk->items[*offset + 1];
+    item->data = (const char*)(chunk->items + *offset + 2);
+
+    *offset += 2 + item->length;
+    return 1;
+}
+
+/**
+ * @brief Start a packet at the end of the builder.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] count - count or subtype field.
+ * @param [in] pt - packet type.
+ * @return offset of the packet.
+ * @private
+ */
+static size_t begin_packet(rtcp_compound_builder *b, uint8_t count, uint8_t pt)
+{
+    const size_t start = b->offset;
+    uint8_t *data = b->buffer + start;
+    data[0] = (uint8_t)((2 << 6) | (count & 0x1f));
+    data[1] = pt;
+    write_u16(data + 2, 0);
+
+    b->offset += 4;
+    return start;
+}
+
+/**
+ * @brief Pad a packet to 32 bits and set its length field.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] start - offset of the packet, which must be the last one.
+ * @private
+ */
+static void end_packet(rtcp_compound_builder *b, size_t start)
+{
+    while(b->offset % 4)
+        b->buffer[b->offset++] = 0;
+
+    write_u16(b->buffer + start + 2, (uint16_t)((b->offset - start) / 4 - 1));
+}
+
+/**
+ * @brief Append a SR or RR.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] pt - RTCP_SR or RTCP_RR.
+ * @param [in] words - SSRC and, for a SR, the sender info.
+ * @param [in] reports - report blocks.
+ * @param [in] count - number of report blocks.
+ * @param [in] ext_data - extension data or NULL.
+ * @param [in] ext_size - extension size.
+ * @return number of report blocks written or -1 if the packet does not fit.
+ * @private
+ */
+static int add_report_packet(
+    rtcp_compound_builder *b,
+    uint8_t pt,
+    const uint32_t *words,
+    const rtcp_report *reports,
+    uint8_t count,
+    const void *ext_data,
+    size_t ext_size)
+{
+    const size_t word_count = (pt == RTCP_SR) ? 6 : 1;
+    if(ext_data == NULL)
+        ext_size = 0;
+
+    const size_t ext_padded = (ext_size + 3) & ~(size_t)3;
+    if(b->size - b->offset < 4 + (4 * word_count) + ext_padded)
+        return -1;
+
+    const size_t start = begin_packet(b, 0, pt);
+    for(size_t i = 0; i < word_count; ++i) {
+        write_u32(b->buffer + b->offset, words[i]);
+        b->offset += 4;
+    }
+
+    b->report_packet = start;
+    b->report_open = 1;
+    b->ssrc = words[0];
+
+    // The extension follows the blocks of this packet, keep room for it
+    b->reserved += ext_padded;
+    const size_t written = rtcp_compound_add_reports(b, reports, count);
+    b->reserved -= ext_padded;
+
+    if(ext_size) {
+        memcpy(b->buffer + b->offset, ext_data, ext_size);
+        b->offset += ext_size;
+        b->report_open = 0;
+    }
+
+    end_packet(b, start);
+    return (int)written;
+}
+
+/**
+ * @brief Write one SDES chunk.
+ *
+ * @param [in,out] b - builder.
+ * @param [in] entry - source to write.
+ * @return 0 on success or -1 if the chunk does not fit.
+ * @private
+ */
+static int write_chunk(rtcp_compound_builder *b, const rtcp_sdes_entry *entry)
+{
+    if(b->size - b->offset < 4)
+        return -1;
+
+    write_u32(b->buffer + b->offset, entry->id);
+    b->offset += 4;
+
+    for(uint8_t i = 0; i < entry->item_count; ++i) {
+        const rtcp_sdes_item *item = &entry->items[i];
+        if(b->size - b->offset < 2U + item->length)
+            return -1;
+
+        b->buffer[b->offset++] = (uint8_t)item->type;
+        b->buffer[b->offset++] = item->length;
+        memcpy(b->buffer + b->offset, item->data, item->length);
+        b->offset += item->length;
+    }
+
+    // END item, then null octets up to the next 32-bit boundary
+    do {
+        if(b->offset >= b->size)
+            return -1;
+
+        b->buffer[b->offset++] = RTCP_SDES_END;
+    } while(b->offset % 4);
+
+    return 0;
+}
+
+void rtcp_compound_builder_init(
+    rtcp_compound_builder *b, uint8_t *buffer, size_t size)
+{
+    assert(b != NULL);
+    assert(buffer != NULL);
+
+    b->buffer = buffer;
+    b->size = size & ~(size_t)3;
+    b->reserved = 0;
+    b->offset = 0;
+    b->report_packet = 0;
+    b->report_open = 0;
+    b->ssrc = 0;
+}
+
+void rtcp_compound_builder_reserve(rtcp_compound_builder *b, size_t bytes)
+{
+    assert(b != NULL);
+
+    b->reserved = bytes;
+}
+
+int rtcp_compound_add_sr(rtcp_compound_builder *b, const rtcp_sr *packet)
+{
+    assert(b != NULL);
+    assert(packet != NULL);
+
+    const uint32_t words[6] = {
+        packet->ssrc,
+        packet->ntp_sec,
+        packet->ntp_frac,
+        packet->rtp_ts,
+        packet->pkt_count,
+        packet->byte_count
+    };
+
+    return add_report_packet(b, RTCP_SR, words, packet->reports,
+        (uint8_t)packet->header.common.count,
+        packet->ext_data, packet->ext_size);
+}
+
+int rtcp_compound_add_rr(rtcp_compound_builder *b, const rtcp_rr *packet)
+{
+    assert(b != NULL);
+    assert(packet != NULL);
+
+    return add_report_packet(b, RTCP_RR, &packet->ssrc, packet->reports,
+        (uint8_t)packet->header.common.count,
+        packet->ext_data, packet->ext_size);
+}
+
+size_t rtcp_compound_add_reports(
+    rtcp_compound_builder *b, const rtcp_report *reports, size_t count)
+{
+    assert(b != NULL);
+    assert(reports != NULL || count == 0);
+    assert(b->offset > 0);
+
+    const size_t limit = (b->reserved < b->size) ? b->size - b->reserved : 0;
+
+    size_t written = 0;
+    while(written < count) {
+        uint8_t *header = b->buffer + b->report_packet;
+        if(!b->report_open || (header[0] & 0x1f) == 31) {
+            // Continue in another RR from the same reporter
+            if(b->offset + 8 + 24 > limit)
+                break;
+
+            if(b->report_open)
+                end_packet(b, b->report_packet);
+
+            b->report_packet = begin_packet(b, 0, RTCP_RR);
+            b->report_open = 1;
+            write_u32(b->buffer + b->offset, b->ssrc);
+            b->offset += 4;
+            header = b->buffer + b->report_packet;
+        }
+
+        if(b->offset + 24 > limit)
+            break;
+
+        rtcp_report_serialize(&reports[written], b->buffer + b->offset, 24);
+        b->offset += 24;
+        header[0] += 1;
+        written += 1;
+    }
+
+    if(b->report_open)
+        end_packet(b, b->report_packet);
+
+    return written;
+}
+
+int rtcp_compound_add_sdes(rtcp_compound_builder *b, const rtcp_sdes *packet)
+{
+    assert(b != NULL);
+    assert(packet != NULL);
+
+    const uint8_t count = (uint8_t)packet->header.common.count;
+    if(b->size - b->offset < 4)
+        return -1;
+
+    const size_t start = begin_packet(b, count, RTCP_SDES);
+    for(uint8_t i = 0; i < count; ++i) {
+        if(write_chunk(b, &packet->srcs[i]) < 0) {
+            b->offset = start;
+            return -1;
+        }
+    }
+
+    end_packet(b, start);
+    b->report_open = 0;
+    return (int)(b->offset - start);
+}
+
+int rtcp_compound_add_bye(rtcp_compound_builder *b, const rtcp_bye *packet)
+{
+    assert(b != NULL);
+    assert(packet != NULL);
+
+    const uint8_t count = (uint8_t)packet->header.common.count;
+    const size_t length = (packet->message) ? strlen(packet->message) : 0;
+    if(length > 0xff)
+        return -1;
+
+    size_t size = 4 + (4U * count);
+    if(packet->message)
+        size = (size + 1 + length + 3) & ~(size_t)3;
+
+    if(b->size - b->offset < size)
+        return -1;
+
+    const size_t start = begin_packet(b, count, RTCP_BYE);
+    for(uint8_t i = 0; i < count; ++i) {
+        write_u32(b->buffer + b->offset, packet->src_ids[i]);
+        b->offset += 4;
+    }
+
+    if(packet->message) {
+        b->buffer[b->offset++] = (uint8_t)length;
+        memcpy(b->buffer + b->offset, packet->message, length);
+        b->offset += length;
+    }
+
+    end_packet(b, start);
+    b->report_open = 0;
+    return (int)size;
+}
+
+int rtcp_compound_add_app(rtcp_compound_builder *b, const rtcp_app *packet)
+{
+    assert(b != NULL);
+    assert(packet != NULL);
+
+    const size_t app_size = (packet->app_data) ? packet->app_size : 0;
+    const size_t size = 12 + ((app_size + 3) & ~(size_t)3);
+    if(b->size - b->offset < size)
+        return -1;
+
+    const size_t start = begin_packet(
+        b, (uint8_t)packet->header.app.subtype, RTCP_APP);
+
+    write_u32(b->buffer + b->offset, packet->ssrc);
+    write_u32(b->buffer + b->offset + 4, packet->name);
+    b->offset += 8;
+
+    if(app_size) {
+        memcpy(b->buffer + b->offset, packet->app_data, app_size);
+        b->offset += app_size;
+    }
+
+    end_packet(b, start);
+    b->report_open = 0;
+    return (int)size;
+}
@@ -22,10 +22,13 @@ void rtcp_report_init(rtcp_report *report, rtp_source *s, ntp_tv tc)
     report->fraction = s->fraction;
     report->lost = s->lost;
     report->last_seq = s->max_seq;
-    report->jitter = (uint32_t)s->jitter;
-    report->lsr = ntp_short(s->lsr);
-    if(report->lsr && (tc.sec || tc.frac))
-        report->dlsr = ntp_short(ntp_diff(tc, s->lsr));
+    report->jitter = rtp_source_jitter(s);
+    const ntp64 lsr = ntp64_from_tv(s->lsr);
+    const ntp64 now = ntp64_from_tv(tc);
+
+    report->lsr = ntp64_short(lsr);
+    if(report->lsr && now)
+        report->dlsr = ntp64_short(ntp64_sub(now, lsr));
 }
 
 int rtcp_report_serialize(
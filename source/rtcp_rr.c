@@ -10,13 +10,23 @@
 #include <assert.h>
 
 #include "rtcp_rr.h"
+#include "alloc.h"
 #include "util.h"
 
 rtcp_rr *rtcp_rr_create()
 {
-    rtcp_rr *packet = (rtcp_rr*)malloc(sizeof(rtcp_rr));
-    if(packet)
+    return rtcp_rr_create_with_allocator(NULL);
+}
+
+rtcp_rr *rtcp_rr_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtcp_rr *packet = (rtcp_rr*)rtp_malloc(allocator, sizeof(rtcp_rr));
+    if(packet) {
         memset(packet, 0, sizeof(rtcp_rr));
+        packet->allocator = allocator;
+    }
 
     return packet;
 }
@@ -25,10 +35,13 @@ void rtcp_rr_free(rtcp_rr *packet)
 {
     assert(packet != NULL);
 
+    if(packet->reports)
+        rtp_free(packet->allocator, packet->reports);
+
     if(packet->ext_data)
-        free(packet->ext_data);
+        rtp_free(packet->allocator, packet->ext_data);
 
-    free(packet);
+    rtp_free(packet->allocator, packet);
 }
 
 void rtcp_rr_init(rtcp_rr *packet)
@@ -98,7 +111,7 @@ int rtcp_rr_parse(rtcp_rr *packet, const uint8_t *buffer, size_t size)
 
     size_t offset = 8;
     if(packet->header.common.count) {
-        packet->reports = (rtcp_report*)calloc(
+        packet->reports = (rtcp_report*)rtp_calloc(packet->allocator,
             packet->header.common.count, sizeof(rtcp_report));
 
         for(uint8_t i = 0; i < packet->header.common.count; ++i) {
@@ -114,7 +127,7 @@ int rtcp_rr_parse(rtcp_rr *packet, const uint8_t *buffer, size_t size)
     packet->ext_size = length - offset;
 
     if(packet->ext_size) {
-        packet->ext_data = malloc(packet->ext_size);
+        packet->ext_data = rtp_malloc(packet->allocator, packet->ext_size);
         memcpy(packet->ext_data, buffer + offset, packet->ext_size);
     }
 
@@ -140,7 +153,8 @@ int rtcp_rr_add_report(rtcp_rr *packet, const rtcp_report *report)
     assert(report != NULL);
 
     if(!packet->header.common.count) {
-        packet->reports = (rtcp_report*)malloc(sizeof(rtcp_report));
+        packet->reports = (rtcp_report*)rtp_malloc(
+            packet->allocator, sizeof(rtcp_report));
         packet->header.common.count = 1;
     }
     else {
@@ -153,7 +167,8 @@ int rtcp_rr_add_report(rtcp_rr *packet, const rtcp_report *report)
         packet->header.common.count += 1;
 
         const size_t nmemb = packet->header.common.count * sizeof(rtcp_report);
-        packet->reports = (rtcp_report*)realloc(packet->reports, nmemb);
+        packet->reports = (rtcp_report*)rtp_realloc(
+            packet->allocator, packet->reports, nmemb);
     }
 
     rtcp_report *dest = &packet->reports[packet->header.common.count - 1];
@@ -177,18 +192,20 @@ void rtcp_rr_remove_report(rtcp_rr *packet, uint32_t src_id)
     const ptrdiff_t offset = report - packet->reports;
     assert(offset >= 0);
 
-    const size_t index = (size_t)offset / sizeof(rtcp_report);
-    const size_t size = (packet->header.common.count - index) * sizeof(uint32_t);
+    const size_t index = (size_t)offset;
+    const size_t size = (packet->header.common.count - index - 1)
+        * sizeof(rtcp_report);
     if(size)
         memmove(report, report + 1, size);
 
     packet->header.common.count -= 1;
     if(packet->header.common.count > 0) {
         const size_t nmemb = packet->header.common.count * sizeof(rtcp_report);
-        packet->reports = (rtcp_report*)realloc(packet->reports, nmemb);
+        packet->reports = (rtcp_report*)rtp_realloc(
+            packet->allocator, packet->reports, nmemb);
     }
     else {
-        free(packet->reports);
+        rtp_free(packet->allocator, packet->reports);
         packet->reports = NULL;
     }
 
@@ -206,7 +223,7 @@ int rtcp_rr_set_ext(rtcp_rr *packet, const void *data, size_t size)
     if(packet->ext_data)
         return -1;
 
-    packet->ext_data = malloc(size);
+    packet->ext_data = rtp_malloc(packet->allocator, size);
     if(packet->ext_data == NULL)
         return -1;
 
@@ -224,7 +241,7 @@ void rtcp_rr_clear_ext(rtcp_rr *packet)
     assert(packet != NULL);
 
     if(packet->ext_data) {
-        free(packet->ext_data);
+        rtp_free(packet->allocator, packet->ext_data);
         packet->ext_data = NULL;
         packet->ext_size = 0;
     }
@@ -0,0 +1,228 @@
+/**
+ * @file rtcp_scheduler.c
+ * @brief RTCP transmission scheduling.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtcp
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "rtcp_scheduler.h"
+#include "rtcp_util.h"
+#include "alloc.h"
+
+/**
+ * @brief Draw a transmission interval from the current state.
+ * @private
+ */
+static double interval(const rtcp_scheduler *s)
+{
+    return rtcp_interval(s->members, s->senders, s->rtcp_bw, s->we_sent,
+        s->avg_rtcp_size, s->initial);
+}
+
+/**
+ * @brief Fold a packet size into the average RTCP packet size.
+ * @private
+ */
+static void update_avg_size(rtcp_scheduler *s, size_t size)
+{
+    s->avg_rtcp_size = (1.0 / 16.0) * (double)size
+        + (15.0 / 16.0) * s->avg_rtcp_size;
+}
+
+/**
+ * @brief Move the wheel timer, if any, to tn.
+ * @private
+ */
+static void rearm(rtcp_scheduler *s)
+{
+    if(!s->wheel)
+        return;
+
+    const double t = s->tn / s->tick;
+    uint64_t ticks = (t > 0) ? (uint64_t)t : 0;
+    if((double)ticks < t)
+        ticks += 1;
+
+    rtp_timer_wheel_add(s->wheel, &s->timer, ticks);
+}
+
+rtcp_scheduler *rtcp_scheduler_create()
+{
+    return rtcp_scheduler_create_with_allocator(NULL);
+}
+
+rtcp_scheduler *rtcp_scheduler_create_with_allocator(
+    const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtcp_scheduler *s = (rtcp_scheduler*)rtp_malloc(
+        allocator, sizeof(rtcp_scheduler));
+
+    if(s) {
+        memset(s, 0, sizeof(rtcp_scheduler));
+        s->allocator = allocator;
+    }
+
+    return s;
+}
+
+void rtcp_scheduler_free(rtcp_scheduler *s)
+{
+    assert(s != NULL);
+
+    if(s->wheel)
+        rtp_timer_wheel_cancel(s->wheel, &s->timer);
+
+    rtp_free(s->allocator, s);
+}
+
+void rtcp_scheduler_init(
+    rtcp_scheduler *s, double tc, double rtcp_bw, double rtcp_size)
+{
+    assert(s != NULL);
+
+    // Everything but the allocator, which is the last member
+    memset(s, 0, offsetof(rtcp_scheduler, allocator));
+    s->tp = tc;
+    s->pmembers = 1;
+    s->members = 1;
+    s->rtcp_bw = rtcp_bw;
+    s->avg_rtcp_size = rtcp_size;
+    s->initial = true;
+    s->tn = tc + interval(s);
+}
+
+void rtcp_scheduler_attach(
+    rtcp_scheduler *s,
+    rtp_timer_wheel *w,
+    double tick,
+    rtp_timer_handler handler,
+    void *ctx)
+{
+    assert(s != NULL);
+    assert(w == NULL || tick > 0);
+
+    if(s->wheel)
+        rtp_timer_wheel_cancel(s->wheel, &s->timer);
+
+    rtp_timer_init(&s->timer, handler, ctx);
+    s->wheel = w;
+    s->tick = tick;
+    rearm(s);
+}
+
+double rtcp_scheduler_next_deadline(const rtcp_scheduler *s)
+{
+    assert(s != NULL);
+
+    return s->tn;
+}
+
+void rtcp_scheduler_on_rtp_sent(rtcp_scheduler *s)
+{
+    assert(s != NULL);
+
+    if(!s->we_sent) {
+        s->we_sent = true;
+        s->senders += 1;
+    }
+
+    s->reports_since_rtp = 0;
+}
+
+void rtcp_scheduler_on_rtcp_received(
+    rtcp_scheduler *s, size_t size, bool bye)
+{
+    assert(s != NULL);
+
+    update_avg_size(s, size);
+
+    // During BYE backoff only the members leaving with us are counted
+    if(bye && s->leaving)
+        s->members += 1;
+}
+
+void rtcp_scheduler_set_members(
+    rtcp_scheduler *s, double tc, int members, int senders)
+{
+    assert(s != NULL);
+    assert(members >= 0 && senders >= 0);
+
+    if(s->leaving)
+        return;
+
+    s->members = members + 1;
+    s->senders = senders + (s->we_sent ? 1 : 0);
+
+    if(s->members < s->pmembers) {
+        rtcp_reverse_reconsider(&s->tp, &s->tn, tc, s->pmembers, s->members);
+        s->pmembers = s->members;
+        rearm(s);
+    }
+}
+
+bool rtcp_scheduler_on_expire(rtcp_scheduler *s, double tc)
+{
+    assert(s != NULL);
+
+    s->tn = s->tp + interval(s);
+    if(s->tn <= tc)
+        return true;
+
+    rearm(s);
+    return false;
+}
+
+void rtcp_scheduler_on_rtcp_sent(rtcp_scheduler *s, double tc, size_t size)
+{
+    assert(s != NULL);
+
+    update_avg_size(s, size);
+    s->tp = tc;
+
+    // No RTP since the 2nd previous report, we are no longer a sender
+    s->reports_since_rtp += 1;
+    if(s->we_sent && s->reports_since_rtp >= 2) {
+        s->we_sent = false;
+        s->senders -= 1;
+    }
+
+    // Redraw, the interval that expired is biased towards short ones
+    s->tn = tc + interval(s);
+    s->pmembers = s->members;
+    s->initial = false;
+    rearm(s);
+}
+
+int rtcp_scheduler_leave(rtcp_scheduler *s, double tc, size_t size)
+{
+    assert(s != NULL);
+
+    if(s->initial && !s->we_sent)
+        return -1;
+
+    s->leaving = true;
+    if(s->members <= LIBRTP_RTCP_BYE_BACKOFF_MEMBERS) {
+        if(s->wheel)
+            rtp_timer_wheel_cancel(s->wheel, &s->timer);
+
+        return 1;
+    }
+
+    s->tp = tc;
+    s->members = 1;
+    s->pmembers = 1;
+    s->senders = 0;
+    s->we_sent = false;
+    s->initial = true;
+    s->avg_rtcp_size = (double)size;
+    s->tn = tc + interval(s);
+    rearm(s);
+    return 0;
+}
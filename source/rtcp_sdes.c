@@ -10,6 +10,7 @@
 #include <assert.h>
 
 #include "rtcp_sdes.h"
+#include "alloc.h"
 #include "util.h"
 
 /**
@@ -74,6 +75,7 @@ static rtcp_sdes_item *get_item(
 /**
  * @brief Add an item to a source entry.
  *
+ * @param [in] a - allocator.
  * @param [out] source - source to add to.
  * @param [in] type - item type to add.
  * @param [in] data - item data.
@@ -82,6 +84,7 @@ static rtcp_sdes_item *get_item(
  * @private
  */
 static rtcp_sdes_item *create_item(
+    const rtp_allocator *a,
     rtcp_sdes_entry *source,
     rtcp_sdes_type type,
     const void *data,
@@ -94,7 +97,8 @@ static rtcp_sdes_item *create_item(
         return NULL;
 
     if(source->item_count == 0) {
-        source->items = (rtcp_sdes_item*)malloc(sizeof(rtcp_sdes_item));
+        source->items = (rtcp_sdes_item*)rtp_malloc(
+            a, sizeof(rtcp_sdes_item));
         source->item_count = 1;
     }
     else {
@@ -104,13 +108,13 @@ static rtcp_sdes_item *create_item(
         source->item_count += 1;
 
         const size_t nmemb = source->item_count * sizeof(rtcp_sdes_item);
-        source->items = (rtcp_sdes_item*)realloc(source->items, nmemb);
+        source->items = (rtcp_sdes_item*)rtp_realloc(a, source->items, nmemb);
     }
 
     rtcp_sdes_item *item = &source->items[source->item_count - 1];
     item->type = type;
     item->length = length;
-    item->data = malloc(length);
+    item->data = rtp_malloc(a, length);
     memcpy(item->data, data, length);
 
     return item;
@@ -119,11 +123,13 @@ static rtcp_sdes_item *create_item(
 /**
  * @brief Remove an item from a source entry.
  *
+ * @param [in] a - allocator.
  * @param [out] source - source to remove from.
  * @param [in] type - item type to remove.
  * @private
  */
-static void free_item(rtcp_sdes_entry *source, rtcp_sdes_type type)
+static void free_item(
+    const rtp_allocator *a, rtcp_sdes_entry *source, rtcp_sdes_type type)
 {
     assert(source != NULL);
 
@@ -131,23 +137,24 @@ static void free_item(rtcp_sdes_entry *source, rtcp_sdes_type type)
     if(item == NULL)
         return;
 
-    free(item->data);
+    rtp_free(a, item->data);
 
     const ptrdiff_t offset = item - source->items;
     assert(offset >= 0);
 
-    const size_t index = (size_t)offset / sizeof(rtcp_sdes_item);
-    const size_t size = (source->item_count - index) * sizeof(rtcp_sdes_item);
+    const size_t index = (size_t)offset;
+    const size_t size = (source->item_count - index - 1)
+        * sizeof(rtcp_sdes_item);
     if(size)
         memmove(item, item + 1, size);
 
     source->item_count -= 1;
     if(source->item_count > 0) {
         const size_t nmemb = source->item_count * sizeof(rtcp_sdes_item);
-        source->items = (rtcp_sdes_item*)realloc(source->items, nmemb);
+        source->items = (rtcp_sdes_item*)rtp_realloc(a, source->items, nmemb);
     }
     else {
-        free(source->items);
+        rtp_free(a, source->items);
         source->items = NULL;
     }
 }
@@ -190,9 +197,18 @@ static int serialize_entry(
 
 rtcp_sdes *rtcp_sdes_create()
 {
-    rtcp_sdes *packet = (rtcp_sdes*)malloc(sizeof(rtcp_sdes));
-    if(packet)
+    return rtcp_sdes_create_with_allocator(NULL);
+}
+
+rtcp_sdes *rtcp_sdes_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtcp_sdes *packet = (rtcp_sdes*)rtp_malloc(allocator, sizeof(rtcp_sdes));
+    if(packet) {
         memset(packet, 0, sizeof(rtcp_sdes));
+        packet->allocator = allocator;
+    }
 
     return packet;
 }
@@ -210,16 +226,16 @@ void rtcp_sdes_free(rtcp_sdes *packet)
             for(uint8_t j = 0; j < source->item_count; ++j) {
                 rtcp_sdes_item *item = &source->items[j];
                 if(item->data)
-                    free(item->data);
+                    rtp_free(packet->allocator, item->data);
             }
 
-            free(source->items);
+            rtp_free(packet->allocator, source->items);
         }
 
-        free(packet->srcs);
+        rtp_free(packet->allocator, packet->srcs);
     }
 
-    free(packet);
+    rtp_free(packet->allocator, packet);
 }
 
 void rtcp_sdes_init(rtcp_sdes *packet)
@@ -282,7 +298,7 @@ int rtcp_sdes_parse(
 
     // Parse sources
     if(packet->header.common.count) {
-        packet->srcs = (rtcp_sdes_entry*)calloc(
+        packet->srcs = (rtcp_sdes_entry*)rtp_calloc(packet->allocator,
             packet->header.common.count, sizeof(rtcp_sdes_entry));
 
         size_t offset = 4;
@@ -306,7 +322,7 @@ int rtcp_sdes_parse(
 
                 const uint8_t length = data[1];
                 rtcp_sdes_item *item = create_item(
-                    source, type, data + 2, length);
+                    packet->allocator, source, type, data + 2, length);
 
                 if(!item)
                     return -1;
@@ -337,7 +353,8 @@ int rtcp_sdes_add_entry(rtcp_sdes *packet, uint32_t id)
     assert(packet != NULL);
 
     if(!packet->header.common.count) {
-        packet->srcs = (rtcp_sdes_entry*)malloc(sizeof(rtcp_sdes_entry));
+        packet->srcs = (rtcp_sdes_entry*)rtp_malloc(
+            packet->allocator, sizeof(rtcp_sdes_entry));
         packet->header.common.count = 1;
     }
     else {
@@ -349,8 +366,10 @@ int rtcp_sdes_add_entry(rtcp_sdes *packet, uint32_t id)
 
         packet->header.common.count += 1;
 
-        const size_t nmemb = packet->header.common.count * sizeof(rtcp_sdes_entry);
-        packet->srcs = (rtcp_sdes_entry*)realloc(packet->srcs, nmemb);
+        const size_t nmemb = packet->header.common.count
+            * sizeof(rtcp_sdes_entry);
+        packet->srcs = (rtcp_sdes_entry*)rtp_realloc(
+            packet->allocator, packet->srcs, nmemb);
     }
 
     rtcp_sdes_entry *source = &packet->srcs[packet->header.common.count - 1];
@@ -374,12 +393,12 @@ void rtcp_sdes_remove_entry(rtcp_sdes *packet, uint32_t id)
     for(uint8_t i = 0; i < source->item_count; ++i) {
         rtcp_sdes_item *item = &source->items[i];
         if(item->data)
-            free(item->data);
-
-        free(item);
+            rtp_free(packet->allocator, item->data);
     }
 
-    const size_t size = (unsigned)(packet->header.common.count - index)
+    rtp_free(packet->allocator, source->items);
+
+    const size_t size = (unsigned)(packet->header.common.count - index - 1)
         * sizeof(rtcp_sdes_entry);
 
     if(size)
@@ -387,11 +406,13 @@ void rtcp_sdes_remove_entry(rtcp_sdes *packet, uint32_t id)
 
     packet->header.common.count -= 1;
     if(packet->header.common.count > 0) {
-        const size_t nmemb = packet->header.common.count * sizeof(rtcp_sdes_entry);
-        packet->srcs = (rtcp_sdes_entry*)realloc(packet->srcs, nmemb);
+        const size_t nmemb = packet->header.common.count
+            * sizeof(rtcp_sdes_entry);
+        packet->srcs = (rtcp_sdes_entry*)rtp_realloc(
+            packet->allocator, packet->srcs, nmemb);
     }
     else {
-        free(packet->srcs);
+        rtp_free(packet->allocator, packet->srcs);
         packet->srcs = NULL;
     }
 }
@@ -433,13 +454,14 @@ int rtcp_sdes_set_item(
 
     rtcp_sdes_entry *source = &packet->srcs[index];
     if(get_item(source, type))
-        free_item(source, type);
+        free_item(packet->allocator, source, type);
 
     size_t length = strlen(data);
     if(length > 0xFF)
         return -1;
 
-    if(create_item(source, type, data, (uint8_t)length) == NULL)
+    if(create_item(packet->allocator, source, type, data, (uint8_t)length)
+        == NULL)
         return -1;
 
     // Update header length
@@ -457,7 +479,7 @@ void rtcp_sdes_clear_item(rtcp_sdes *packet, uint32_t src, rtcp_sdes_type type)
         return;
 
     rtcp_sdes_entry *source = &packet->srcs[index];
-    free_item(source, type);
+    free_item(packet->allocator, source, type);
 
     // Update header length
     packet->header.common.length = (uint16_t)((rtcp_sdes_size(packet) / 4) - 1);
@@ -10,13 +10,23 @@
 #include <assert.h>
 
 #include "rtcp_sr.h"
+#include "alloc.h"
 #include "util.h"
 
 rtcp_sr *rtcp_sr_create()
 {
-    rtcp_sr *packet = (rtcp_sr*)malloc(sizeof(rtcp_sr));
-    if(packet)
+    return rtcp_sr_create_with_allocator(NULL);
+}
+
+rtcp_sr *rtcp_sr_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtcp_sr *packet = (rtcp_sr*)rtp_malloc(allocator, sizeof(rtcp_sr));
+    if(packet) {
         memset(packet, 0, sizeof(rtcp_sr));
+        packet->allocator = allocator;
+    }
 
     return packet;
 }
@@ -25,10 +35,13 @@ void rtcp_sr_free(rtcp_sr *packet)
 {
     assert(packet != NULL);
 
+    if(packet->reports)
+        rtp_free(packet->allocator, packet->reports);
+
     if(packet->ext_data)
-        free(packet->ext_data);
+        rtp_free(packet->allocator, packet->ext_data);
 
-    free(packet);
+    rtp_free(packet->allocator, packet);
 }
 
 void rtcp_sr_init(rtcp_sr *packet)
@@ -109,7 +122,7 @@ int rtcp_sr_parse(rtcp_sr *packet, const uint8_t *buffer, size_t size)
 
     size_t offset = 28;
     if(packet->header.common.count) {
-        packet->reports = (rtcp_report*)calloc(
+        packet->reports = (rtcp_report*)rtp_calloc(packet->allocator,
             packet->header.common.count, sizeof(rtcp_report));
 
         for(uint8_t i = 0; i < packet->header.common.count; ++i) {
@@ -125,13 +138,28 @@ int rtcp_sr_parse(rtcp_sr *packet, const uint8_t *buffer, size_t size)
     packet->ext_size = length - offset;
 
     if(packet->ext_size) {
-        packet->ext_data = malloc(packet->ext_size);
+        packet->ext_data = rtp_malloc(packet->allocator, packet->ext_size);
         memcpy(packet->ext_data, buffer + offset, packet->ext_size);
     }
 
     return 0;
 }
 
+void rtcp_sr_set_ntp(rtcp_sr *packet, ntp64 t)
+{
+    assert(packet != NULL);
+
+    packet->ntp_sec = (uint32_t)(t >> 32);
+    packet->ntp_frac = (uint32_t)t;
+}
+
+ntp64 rtcp_sr_ntp(const rtcp_sr *packet)
+{
+    assert(packet != NULL);
+
+    return ((ntp64)packet->ntp_sec << 32) | packet->ntp_frac;
+}
+
 rtcp_report *rtcp_sr_find_report(rtcp_sr *packet, uint32_t src_id)
 {
     assert(packet != NULL);
@@ -151,7 +179,8 @@ int rtcp_sr_add_report(rtcp_sr *packet, const rtcp_report *report)
     assert(report != NULL);
 
     if(!packet->header.common.count) {
-        packet->reports = (rtcp_report*)malloc(sizeof(rtcp_report));
+        packet->reports = (rtcp_report*)rtp_malloc(
+            packet->allocator, sizeof(rtcp_report));
         packet->header.common.count = 1;
     }
     else {
@@ -164,7 +193,8 @@ int rtcp_sr_add_report(rtcp_sr *packet, const rtcp_report *report)
         packet->header.common.count += 1;
 
         const size_t nmemb = packet->header.common.count * sizeof(rtcp_report);
-        packet->reports = (rtcp_report*)realloc(packet->reports, nmemb);
+        packet->reports = (rtcp_report*)rtp_realloc(
+            packet->allocator, packet->reports, nmemb);
     }
 
     rtcp_report *dest = &packet->reports[packet->header.common.count - 1];
@@ -187,18 +217,20 @@ void rtcp_sr_remove_report(rtcp_sr *packet, uint32_t src_id)
     const ptrdiff_t offset = report - packet->reports;
     assert(offset >= 0);
 
-    const size_t index = (size_t)offset / sizeof(rtcp_report);
-    const size_t size = (packet->header.common.count - index) * sizeof(uint32_t);
+    const size_t index = (size_t)offset;
+    const size_t size = (packet->header.common.count - index - 1)
+        * sizeof(rtcp_report);
     if(size)
         memmove(report, report + 1, size);
 
     packet->header.common.count -= 1;
     if(packet->header.common.count > 0) {
         const size_t nmemb = packet->header.common.count * sizeof(rtcp_report);
-        packet->reports = (rtcp_report*)realloc(packet->reports, nmemb);
+        packet->reports = (rtcp_report*)rtp_realloc(
+            packet->allocator, packet->reports, nmemb);
     }
     else {
-        free(packet->reports);
+        rtp_free(packet->allocator, packet->reports);
         packet->reports = NULL;
     }
 
@@ -217,7 +249,7 @@ int rtcp_sr_set_ext(rtcp_sr *packet, const void *data, size_t size)
     if(packet->ext_data)
         return -1;
 
-    packet->ext_data = malloc(size);
+    packet->ext_data = rtp_malloc(packet->allocator, size);
     if(packet->ext_data == NULL)
         return -1;
 
@@ -235,7 +267,7 @@ void rtcp_sr_clear_ext(rtcp_sr *packet)
     assert(packet != NULL);
 
     if(packet->ext_data) {
-        free(packet->ext_data);
+        rtp_free(packet->allocator, packet->ext_data);
         packet->ext_data = NULL;
         packet->ext_size = 0;
     }
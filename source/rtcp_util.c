@@ -5,7 +5,6 @@
  * @copyright 2022 Daxbot
  */
 
-#include <stdlib.h>
 #include <assert.h>
 
 #include "rtcp_header.h"
@@ -33,6 +32,21 @@ double rtcp_interval(
     double avg_rtcp_size,
     bool initial)
 {
+    return rtcp_interval_with_random(members, senders, rtcp_bw, we_sent,
+        avg_rtcp_size, initial, rtp_random_thread());
+}
+
+double rtcp_interval_with_random(
+    int members,
+    int senders,
+    double rtcp_bw,
+    bool we_sent,
+    double avg_rtcp_size,
+    bool initial,
+    rtp_random *r)
+{
+    assert(r != NULL);
+
     const double MIN_TIME = LIBRTP_RTCP_MIN_TIME;
     const double SENDER_BW_FRACTION = LIBRTP_RTCP_SENDER_BW_FRACTION;
     const double RCVR_BW_FRACTION = (1.0 - SENDER_BW_FRACTION);
@@ -89,7 +103,7 @@ double rtcp_interval(
      * other sites, we then pick our actual next report interval as a
      * random number uniformly distributed between 0.5*t and 1.5*t.
      */
-    t *= ((double)(rand()) / RAND_MAX) + 0.5;
+    t *= rtp_random_double(r) + 0.5;
     t /= COMPENSATION;
 
     return t;
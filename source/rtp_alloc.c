@@ -0,0 +1,191 @@
+/**
+ * @file rtp_alloc.c
+ * @brief Pluggable memory allocation.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "alloc.h"
+
+/**
+ * @brief Arena block alignment, also the size of each block's header.
+ * @private
+ */
+#define ARENA_ALIGN (16)
+
+static void *std_alloc(void *ctx, size_t size)
+{
+    (void)ctx;
+    return malloc(size);
+}
+
+static void *std_resize(void *ctx, void *ptr, size_t size)
+{
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void std_release(void *ctx, void *ptr)
+{
+    (void)ctx;
+    free(ptr);
+}
+
+/**
+ * @brief Default allocator.
+ * @private
+ */
+static const rtp_allocator std_allocator = {
+    std_alloc,
+    std_resize,
+    std_release,
+    NULL
+};
+
+/**
+ * @brief Global allocator.
+ * @private
+ */
+static const rtp_allocator *global_allocator = &std_allocator;
+
+void rtp_set_allocator(const rtp_allocator *allocator)
+{
+    global_allocator = (allocator) ? allocator : &std_allocator;
+}
+
+const rtp_allocator *rtp_get_allocator(void)
+{
+    return global_allocator;
+}
+
+void *rtp_calloc(const rtp_allocator *a, size_t nmemb, size_t size)
+{
+    if(size && nmemb > SIZE_MAX / size)
+        return NULL;
+
+    void *ptr = rtp_malloc(a, nmemb * size);
+    if(ptr)
+        memset(ptr, 0, nmemb * size);
+
+    return ptr;
+}
+
+/**
+ * @brief Returns the size stored in front of an arena block.
+ * @private
+ */
+static inline size_t arena_block_size(const void *ptr)
+{
+    size_t size;
+    memcpy(&size, (const uint8_t*)ptr - ARENA_ALIGN, sizeof(size_t));
+    return size;
+}
+
+static void *arena_alloc(void *ctx, size_t size)
+{
+    rtp_arena *arena = (rtp_arena*)ctx;
+
+    const size_t rounded = (size + ARENA_ALIGN - 1)
+        & ~(size_t)(ARENA_ALIGN - 1);
+
+    // Compare against the space left so that a huge size cannot wrap
+    const size_t left = arena->size - arena->used;
+    if(rounded < size || left < ARENA_ALIGN || rounded > left - ARENA_ALIGN)
+        return NULL;
+
+    uint8_t *block = arena->buffer + arena->used;
+    memcpy(block, &size, sizeof(size_t));
+
+    arena->last = arena->used;
+    arena->used += rounded + ARENA_ALIGN;
+    if(arena->used > arena->high_water)
+        arena->high_water = arena->used;
+
+    return block + ARENA_ALIGN;
+}
+
+static void *arena_resize(void *ctx, void *ptr, size_t size)
+{
+    rtp_arena *arena = (rtp_arena*)ctx;
+
+    if(!ptr)
+        return arena_alloc(ctx, size);
+
+    const size_t old_size = arena_block_size(ptr);
+    const size_t offset = (size_t)((uint8_t*)ptr - arena->buffer) - ARENA_ALIGN;
+
+    if(offset == arena->last) {
+        // Most recent block, grow or shrink in place
+        const size_t rounded = (size + ARENA_ALIGN - 1)
+            & ~(size_t)(ARENA_ALIGN - 1);
+
+        // The block's own header always fits, so this cannot underflow
+        if(rounded < size || rounded > arena->size - offset - ARENA_ALIGN)
+            return NULL;
+
+        memcpy(arena->buffer + offset, &size, sizeof(size_t));
+        arena->used = offset + ARENA_ALIGN + rounded;
+        if(arena->used > arena->high_water)
+            arena->high_water = arena->used;
+
+        return ptr;
+    }
+
+    if(size <= old_size)
+        return ptr;
+
+    void *block = arena_alloc(ctx, size);
+    if(block)
+        memcpy(block, ptr, old_size);
+
+    return block;
+}
+
+static void arena_release(void *ctx, void *ptr)
+{
+    rtp_arena *arena = (rtp_arena*)ctx;
+
+    if(!ptr)
+        return;
+
+    // Only the most recent block can be given back before a reset
+    const size_t offset = (size_t)((uint8_t*)ptr - arena->buffer) - ARENA_ALIGN;
+    if(offset == arena->last) {
+        arena->used = offset;
+        arena->last = SIZE_MAX;
+    }
+}
+
+void rtp_arena_init(rtp_arena *arena, void *buffer, size_t size)
+{
+    assert(arena != NULL);
+    assert(buffer != NULL || size == 0);
+
+    // Align the start of the buffer so every block is aligned
+    const uintptr_t start = ((uintptr_t)buffer + ARENA_ALIGN - 1)
+        & ~(uintptr_t)(ARENA_ALIGN - 1);
+
+    const size_t skip = (size_t)(start - (uintptr_t)buffer);
+
+    arena->allocator.alloc = arena_alloc;
+    arena->allocator.resize = arena_resize;
+    arena->allocator.release = arena_release;
+    arena->allocator.ctx = arena;
+    arena->buffer = (uint8_t*)start;
+    arena->size = (size > skip) ? size - skip : 0;
+    arena->used = 0;
+    arena->last = SIZE_MAX;
+    arena->high_water = 0;
+}
+
+void rtp_arena_reset(rtp_arena *arena)
+{
+    assert(arena != NULL);
+
+    arena->used = 0;
+    arena->last = SIZE_MAX;
+}
@@ -0,0 +1,128 @@
+/**
+ * @file rtp_clock.c
+ * @brief Monotonic clock with NTP and RTP timestamp conversion.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+
+#include "rtp_clock.h"
+
+#if LIBRTP_CLOCK_TSC
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief 1970 - 1900 in seconds.
+ * @private
+ */
+#define UNIX_OFFSET (2208988800ull)
+
+/**
+ * @brief Read a POSIX clock in nanoseconds.
+ * @private
+ */
+static uint64_t read_ns(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+#if LIBRTP_CLOCK_TSC
+/**
+ * @brief Returns non-zero if the TSC runs at a constant rate in all states.
+ * @private
+ */
+static int invariant_tsc(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    if(!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+        return 0;
+
+    return (edx >> 8) & 1;
+}
+#endif
+
+void rtp_clock_init(rtp_clock *c)
+{
+    assert(c != NULL);
+
+    memset(c, 0, sizeof(rtp_clock));
+#if LIBRTP_CLOCK_TSC
+    c->tsc_start = __rdtsc();
+    c->mono_start = read_ns(CLOCK_MONOTONIC);
+#endif
+    rtp_clock_sync(c);
+}
+
+void rtp_clock_sync(rtp_clock *c)
+{
+    assert(c != NULL);
+
+    const uint64_t real = read_ns(CLOCK_REALTIME);
+    const uint64_t mono = read_ns(CLOCK_MONOTONIC);
+
+#if LIBRTP_CLOCK_TSC
+    const uint64_t tsc = __rdtsc();
+
+    // Calibrate over at least 10 ms, longer baselines average out noise
+    const uint64_t elapsed = mono - c->mono_start;
+    if(elapsed >= 10000000u && tsc > c->tsc_start && invariant_tsc()) {
+        __extension__ typedef unsigned __int128 u128;
+        c->tsc_mult = (uint64_t)(((u128)elapsed << 32) / (tsc - c->tsc_start));
+    }
+
+    c->tsc = tsc;
+#endif
+
+    c->mono = mono;
+    c->ntp = ntp64_from_ns(real) + (UNIX_OFFSET << 32);
+}
+
+uint64_t rtp_clock_now(const rtp_clock *c)
+{
+    assert(c != NULL);
+
+#if LIBRTP_CLOCK_TSC
+    if(c->tsc_mult) {
+        __extension__ typedef unsigned __int128 u128;
+        const uint64_t ticks = __rdtsc() - c->tsc;
+        return c->mono + (uint64_t)(((u128)ticks * c->tsc_mult) >> 32);
+    }
+#else
+    (void)c;
+#endif
+
+    return read_ns(CLOCK_MONOTONIC);
+}
+
+ntp64 rtp_clock_ntp(const rtp_clock *c, uint64_t now)
+{
+    assert(c != NULL);
+
+    if(now >= c->mono)
+        return ntp64_add(c->ntp, ntp64_from_ns(now - c->mono));
+
+    return ntp64_sub(c->ntp, ntp64_from_ns(c->mono - now));
+}
+
+void rtp_clock_rate_init(rtp_clock_rate *r, uint32_t clock_rate)
+{
+    assert(r != NULL);
+    assert(clock_rate < 1000000000u);
+
+    // 2^64 * rate / 10^9 by long division in 32-bit steps
+    const uint64_t ns = 1000000000u;
+    const uint64_t hi = ((uint64_t)clock_rate << 32) / ns;
+    const uint64_t rem = ((uint64_t)clock_rate << 32) % ns;
+    const uint64_t lo = (rem << 32) / ns;
+
+    r->mult = (hi << 32) + lo + (((rem << 32) % ns) ? 1 : 0);
+    r->clock_rate = clock_rate;
+}
@@ -0,0 +1,348 @@
+/**
+ * @file rtp_decode.c
+ * @brief Vectorized RTP fixed header decode.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "rtp_decode.h"
+#include "util.h"
+
+#if !defined(LIBRTP_NO_SIMD) && defined(__GNUC__) \
+    && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#if defined(__x86_64__) || defined(__i386__)
+#define LIBRTP_DECODE_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define LIBRTP_DECODE_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+/**
+ * @brief Stand-in header for runts, fails the version check.
+ * @private
+ */
+static const uint8_t runt[12] = { 0 };
+
+/**
+ * @brief Returns the header bytes of a datagram, or a runt stand-in.
+ *
+ * @param [in] iov - datagram.
+ * @return pointer to at least 12 readable bytes.
+ * @private
+ */
+static inline const uint8_t *header_bytes(const struct iovec *iov)
+{
+    if(iov->iov_len < 12)
+        return runt;
+
+    return (const uint8_t*)iov->iov_base;
+}
+
+/**
+ * @brief Decode a single fixed header.
+ *
+ * @param [out] out - decoded header.
+ * @param [in] buffer - 12 header bytes.
+ * @return 1 if the header is valid.
+ * @private
+ */
+static inline uint64_t decode_one(rtp_fixed *out, const uint8_t *buffer)
+{
+    out->ts = read_u32(buffer + 4);
+    out->ssrc = read_u32(buffer + 8);
+    out->seq = read_u16(buffer + 2);
+    out->b0 = buffer[0];
+    out->b1 = buffer[1];
+    out->reserved = 0;
+
+    const uint8_t pt = buffer[1] & 0x7f;
+    return ((buffer[0] >> 6) == 2) && !(pt < 96 && pt > 71);
+}
+
+/**
+ * @brief Portable decoder.
+ * @private
+ */
+static uint64_t decode_scalar(
+    const struct iovec *in, size_t n, rtp_fixed *out)
+{
+    uint64_t mask = 0;
+    for(size_t i = 0; i < n; ++i)
+        mask |= decode_one(&out[i], header_bytes(&in[i])) << i;
+
+    return mask;
+}
+
+#if defined(LIBRTP_DECODE_X86)
+
+/**
+ * @brief Load exactly 12 header bytes into a vector.
+ * @private
+ */
+__attribute__((target("sse4.1")))
+static inline __m128i load_header(const uint8_t *buffer)
+{
+    int32_t ssrc;
+    memcpy(&ssrc, buffer + 8, 4);
+
+    const __m128i v = _mm_loadl_epi64((const __m128i*)buffer);
+    return _mm_insert_epi32(v, ssrc, 2);
+}
+
+/**
+ * @brief Byte-swap ts, ssrc and seq into the rtp_fixed layout.
+ * @private
+ */
+#define LIBRTP_DECODE_SHUFFLE \
+    7, 6, 5, 4, 11, 10, 9, 8, 3, 2, 0, 1, -1, -1, -1, -1
+
+/**
+ * @brief Validate four packed (seq | b0 << 16 | b1 << 24) words.
+ *
+ * @param [in] d - packed words.
+ * @return 4-bit validity mask.
+ * @private
+ */
+__attribute__((target("sse4.1")))
+static inline uint64_t validate_sse41(__m128i d)
+{
+    const __m128i version = _mm_cmpeq_epi32(
+        _mm_and_si128(d, _mm_set1_epi32(0x00c00000)),
+        _mm_set1_epi32(0x00800000));
+
+    const __m128i pt = _mm_and_si128(
+        _mm_srli_epi32(d, 24), _mm_set1_epi32(0x7f));
+
+    const __m128i rtcp = _mm_and_si128(
+        _mm_cmpgt_epi32(pt, _mm_set1_epi32(71)),
+        _mm_cmpgt_epi32(_mm_set1_epi32(96), pt));
+
+    const __m128i valid = _mm_andnot_si128(rtcp, version);
+    return (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(valid));
+}
+
+/**
+ * @brief SSE4.1 decoder, four packets per iteration.
+ * @private
+ */
+__attribute__((target("sse4.1")))
+static uint64_t decode_sse41(
+    const struct iovec *in, size_t n, rtp_fixed *out)
+{
+    const __m128i shuffle = _mm_setr_epi8(LIBRTP_DECODE_SHUFFLE);
+
+    uint64_t mask = 0;
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        const __m128i v0 = _mm_shuffle_epi8(
+            load_header(header_bytes(&in[i + 0])), shuffle);
+        const __m128i v1 = _mm_shuffle_epi8(
+            load_header(header_bytes(&in[i + 1])), shuffle);
+        const __m128i v2 = _mm_shuffle_epi8(
+            load_header(header_bytes(&in[i + 2])), shuffle);
+        const __m128i v3 = _mm_shuffle_epi8(
+            load_header(header_bytes(&in[i + 3])), shuffle);
+
+        _mm_storeu_si128((__m128i*)&out[i + 0], v0);
+        _mm_storeu_si128((__m128i*)&out[i + 1], v1);
+        _mm_storeu_si128((__m128i*)&out[i + 2], v2);
+        _mm_storeu_si128((__m128i*)&out[i + 3], v3);
+
+        // Gather the third word of each packet into one vector
+        const __m128i t01 = _mm_unpackhi_epi32(v0, v1);
+        const __m128i t23 = _mm_unpackhi_epi32(v2, v3);
+        const __m128i d = _mm_unpacklo_epi64(t01, t23);
+
+        mask |= validate_sse41(d) << i;
+    }
+
+    if(i < n)
+        mask |= decode_scalar(in + i, n - i, out + i) << i;
+
+    return mask;
+}
+
+/**
+ * @brief AVX2 decoder, eight packets per iteration.
+ * @private
+ */
+__attribute__((target("avx2")))
+static uint64_t decode_avx2(
+    const struct iovec *in, size_t n, rtp_fixed *out)
+{
+    const __m256i shuffle = _mm256_setr_epi8(
+        LIBRTP_DECODE_SHUFFLE, LIBRTP_DECODE_SHUFFLE);
+
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+    uint64_t mask = 0;
+    size_t i = 0;
+    for(; i + 8 <= n; i += 8) {
+        __m256i y[4];
+        for(int j = 0; j < 4; ++j) {
+            const __m128i lo = load_header(header_bytes(&in[i + 2*j]));
+            const __m128i hi = load_header(header_bytes(&in[i + 2*j + 1]));
+            y[j] = _mm256_shuffle_epi8(
+                _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1),
+                shuffle);
+
+            _mm256_storeu_si256((__m256i*)&out[i + 2*j], y[j]);
+        }
+
+        // Lane 0 holds even packets and lane 1 odd packets, restore order
+        const __m256i t01 = _mm256_unpackhi_epi32(y[0], y[1]);
+        const __m256i t23 = _mm256_unpackhi_epi32(y[2], y[3]);
+        const __m256i d = _mm256_permutevar8x32_epi32(
+            _mm256_unpacklo_epi64(t01, t23), order);
+
+        const __m256i version = _mm256_cmpeq_epi32(
+            _mm256_and_si256(d, _mm256_set1_epi32(0x00c00000)),
+            _mm256_set1_epi32(0x00800000));
+
+        const __m256i pt = _mm256_and_si256(
+            _mm256_srli_epi32(d, 24), _mm256_set1_epi32(0x7f));
+
+        const __m256i rtcp = _mm256_and_si256(
+            _mm256_cmpgt_epi32(pt, _mm256_set1_epi32(71)),
+            _mm256_cmpgt_epi32(_mm256_set1_epi32(96), pt));
+
+        const __m256i valid = _mm256_andnot_si256(rtcp, version);
+        mask |= (uint64_t)_mm256_movemask_ps(_mm256_castsi256_ps(valid)) << i;
+    }
+
+    if(i < n)
+        mask |= decode_sse41(in + i, n - i, out + i) << i;
+
+    return mask;
+}
+
+#endif // LIBRTP_DECODE_X86
+
+#if defined(LIBRTP_DECODE_NEON)
+
+/**
+ * @brief NEON decoder, four packets per iteration.
+ * @private
+ */
+static uint64_t decode_neon(
+    const struct iovec *in, size_t n, rtp_fixed *out)
+{
+    static const uint8_t shuffle_bytes[16] = {
+        7, 6, 5, 4, 11, 10, 9, 8, 3, 2, 0, 1, 0xff, 0xff, 0xff, 0xff
+    };
+    static const uint32_t bits[4] = { 1, 2, 4, 8 };
+
+    const uint8x16_t shuffle = vld1q_u8(shuffle_bytes);
+    const uint32x4_t bit = vld1q_u32(bits);
+
+    uint64_t mask = 0;
+    size_t i = 0;
+    for(; i + 4 <= n; i += 4) {
+        uint32_t words[4];
+        for(int j = 0; j < 4; ++j) {
+            const uint8_t *buffer = header_bytes(&in[i + j]);
+
+            uint32_t ssrc;
+            memcpy(&ssrc, buffer + 8, 4);
+
+            const uint8x16_t v = vqtbl1q_u8(
+                vcombine_u8(vld1_u8(buffer),
+                    vreinterpret_u8_u32(vdup_n_u32(ssrc))),
+                shuffle);
+
+            vst1q_u8((uint8_t*)&out[i + j], v);
+            words[j] = vgetq_lane_u32(vreinterpretq_u32_u8(v), 2);
+        }
+
+        const uint32x4_t d = vld1q_u32(words);
+
+        const uint32x4_t version = vceqq_u32(
+            vandq_u32(d, vdupq_n_u32(0x00c00000)), vdupq_n_u32(0x00800000));
+
+        const uint32x4_t pt = vandq_u32(
+            vshrq_n_u32(d, 24), vdupq_n_u32(0x7f));
+
+        const uint32x4_t rtcp = vandq_u32(
+            vcgtq_u32(pt, vdupq_n_u32(71)), vcltq_u32(pt, vdupq_n_u32(96)));
+
+        const uint32x4_t valid = vbicq_u32(version, rtcp);
+        mask |= (uint64_t)vaddvq_u32(vandq_u32(valid, bit)) << i;
+    }
+
+    if(i < n)
+        mask |= decode_scalar(in + i, n - i, out + i) << i;
+
+    return mask;
+}
+
+#endif // LIBRTP_DECODE_NEON
+
+rtp_decoder rtp_decoder_get(rtp_decode_kernel kernel)
+{
+    switch(kernel) {
+        case RTP_DECODE_SCALAR:
+            return decode_scalar;
+
+#if defined(LIBRTP_DECODE_X86)
+        case RTP_DECODE_SSE41:
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("sse4.1"))
+                return decode_sse41;
+            break;
+
+        case RTP_DECODE_AVX2:
+            __builtin_cpu_init();
+            if(__builtin_cpu_supports("avx2"))
+                return decode_avx2;
+            break;
+#endif
+
+#if defined(LIBRTP_DECODE_NEON)
+        case RTP_DECODE_NEON:
+            return decode_neon;
+#endif
+
+        default:
+            break;
+    }
+
+    return NULL;
+}
+
+rtp_decode_kernel rtp_decoder_best(void)
+{
+    static const rtp_decode_kernel preference[] = {
+        RTP_DECODE_AVX2,
+        RTP_DECODE_SSE41,
+        RTP_DECODE_NEON
+    };
+
+    const size_t count = sizeof(preference) / sizeof(preference[0]);
+    for(size_t i = 0; i < count; ++i) {
+        if(rtp_decoder_get(preference[i]))
+            return preference[i];
+    }
+
+    return RTP_DECODE_SCALAR;
+}
+
+uint64_t rtp_decode_fixed(const struct iovec *in, size_t n, rtp_fixed *out)
+{
+    // Every thread resolves the same value, so relaxed ordering suffices
+    static rtp_decoder decoder = NULL;
+
+    assert(n <= LIBRTP_DECODE_MAX);
+
+    rtp_decoder d = __atomic_load_n(&decoder, __ATOMIC_RELAXED);
+    if(!d) {
+        d = rtp_decoder_get(rtp_decoder_best());
+        __atomic_store_n(&decoder, d, __ATOMIC_RELAXED);
+    }
+
+    return d(in, n, out);
+}
@@ -0,0 +1,102 @@
+/**
+ * @file rtp_decode.h
+ * @brief Vectorized RTP fixed header decode.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ */
+
+#ifndef LIBRTP_RTP_DECODE_H_
+#define LIBRTP_RTP_DECODE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "rtp_iovec.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif // __cplusplus
+
+/**
+ * @brief Maximum number of packets handled by one decoder call.
+ */
+#define LIBRTP_DECODE_MAX (64)
+
+/**
+ * @brief Decoded RTP fixed header.
+ *
+ * The layout matches a byte-swapped 12-byte header in a 16-byte vector
+ * register so that the SIMD kernels can decode a packet with one shuffle and
+ * one store.
+ *
+ * @private
+ */
+typedef struct rtp_fixed {
+    uint32_t ts;                /**< Timestamp. */
+    uint32_t ssrc;              /**< Synchronization source. */
+    uint16_t seq;               /**< Sequence number. */
+    uint8_t b0;                 /**< V, P, X and CC octet. */
+    uint8_t b1;                 /**< M and PT octet. */
+    uint32_t reserved;          /**< Zero. */
+} rtp_fixed;
+
+/**
+ * @brief Available decoder kernels.
+ * @private
+ */
+typedef enum rtp_decode_kernel {
+    RTP_DECODE_SCALAR   = 0,
+    RTP_DECODE_SSE41    = 1,
+    RTP_DECODE_AVX2     = 2,
+    RTP_DECODE_NEON     = 3
+} rtp_decode_kernel;
+
+/**
+ * @brief Fixed header decoder.
+ *
+ * Decodes the fixed headers of up to LIBRTP_DECODE_MAX datagrams. Bit i of the
+ * returned mask is set when datagram i is at least 12 bytes long, has version
+ * 2 and a payload type outside of the RTCP range [72-95]. Entries for runts
+ * are zeroed.
+ *
+ * @param [in] in - datagrams to decode.
+ * @param [in] n - number of datagrams, at most LIBRTP_DECODE_MAX.
+ * @param [out] out - array of n decoded headers.
+ * @return validity mask.
+ * @private
+ */
+typedef uint64_t (*rtp_decoder)(
+    const struct iovec *in, size_t n, rtp_fixed *out);
+
+/**
+ * @brief Returns a specific decoder kernel.
+ *
+ * @param [in] kernel - kernel to get.
+ * @return decoder or NULL if the kernel is not supported by this CPU.
+ * @private
+ */
+rtp_decoder rtp_decoder_get(rtp_decode_kernel kernel);
+
+/**
+ * @brief Returns the fastest decoder kernel supported by this CPU.
+ *
+ * @return kernel.
+ * @private
+ */
+rtp_decode_kernel rtp_decoder_best(void);
+
+/**
+ * @brief Decode using the fastest kernel supported by this CPU.
+ *
+ * The kernel is selected on the first call.
+ *
+ * @see rtp_decoder
+ * @private
+ */
+uint64_t rtp_decode_fixed(const struct iovec *in, size_t n, rtp_fixed *out);
+
+#if defined(__cplusplus)
+}
+#endif // __cplusplus
+
+#endif // LIBRTP_RTP_DECODE_H_
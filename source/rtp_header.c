@@ -10,13 +10,25 @@
 #include <assert.h>
 
 #include "rtp_header.h"
+#include "alloc.h"
 #include "util.h"
 
 rtp_header *rtp_header_create()
 {
-    rtp_header *header = (rtp_header*)malloc(sizeof(rtp_header));
-    if(header)
+    return rtp_header_create_with_allocator(NULL);
+}
+
+rtp_header *rtp_header_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtp_header *header = (rtp_header*)rtp_malloc(
+        allocator, sizeof(rtp_header));
+
+    if(header) {
         memset(header, 0, sizeof(rtp_header));
+        header->allocator = allocator;
+    }
 
     return header;
 }
@@ -25,13 +37,8 @@ void rtp_header_free(rtp_header *header)
 {
     assert(header != NULL);
 
-    if(header->csrc)
-        free(header->csrc);
-
-    if(header->ext_data)
-        free(header->ext_data);
-
-    free(header);
+    rtp_header_clear_ext(header);
+    rtp_free(header->allocator, header);
 }
 
 void rtp_header_init(
@@ -52,10 +59,9 @@ size_t rtp_header_size(const rtp_header *header)
 
     size_t size = 12;
 
-    if(header->csrc && header->cc)
-        size += 4U * header->cc;
+    size += 4U * header->cc;
 
-    if(header->x && header->ext_count && header->ext_data)
+    if(header->x && header->ext_data)
         size += 4U * (1 + header->ext_count);
 
     return size;
@@ -80,8 +86,8 @@ int rtp_header_serialize(const rtp_header *header, uint8_t *buffer, size_t size)
     write_u32(buffer + 4, header->ts);
     write_u32(buffer + 8, header->ssrc);
 
-    if(header->cc && header->csrc) {
-        buffer[0] = (uint8_t)(buffer[0] | (header->cc & 0x7));
+    if(header->cc) {
+        buffer[0] = (uint8_t)(buffer[0] | (header->cc & 0xf));
 
         uint8_t *csrc_start = buffer + 12;
         for(uint8_t i = 0; i < header->cc; i++)
@@ -89,7 +95,7 @@ int rtp_header_serialize(const rtp_header *header, uint8_t *buffer, size_t size)
     }
 
     // Add extension header
-    if(header->x && header->ext_count && header->ext_data) {
+    if(header->x && header->ext_data) {
         buffer[0] |= (1 << 4);
 
         uint8_t *ext_hdr = buffer + (12 + (4 * header->cc));
@@ -125,31 +131,47 @@ int rtp_header_parse(rtp_header *header, const uint8_t *buffer, size_t size)
         return -1;
 
     header->x = (unsigned)((buffer[0] >> 4) & 0x1);
-    header->cc = (unsigned)(buffer[0] & 0x7);
+    header->cc = (unsigned)(buffer[0] & 0xf);
     header->m = (unsigned)((buffer[1] >> 7) & 0x1);
     header->seq = read_u16(buffer + 2);
     header->ts = read_u32(buffer + 4);
     header->ssrc = read_u32(buffer + 8);
+    rtp_header_clear_ext(header);
 
     // Recheck size
     if(size < rtp_header_size(header))
         return -1;
 
     // Contributing source IDs
-    if(header->cc) {
-        header->csrc = (uint32_t*)malloc(4 * header->cc);
-
-        const uint8_t *csrc_start = buffer + 12;
-        for(uint8_t i = 0; i < header->cc; i++)
-            header->csrc[i] = read_u32(csrc_start + (4 * i));
-    }
+    const uint8_t *csrc_start = buffer + 12;
+    for(uint8_t i = 0; i < header->cc; i++)
+        header->csrc[i] = read_u32(csrc_start + (4 * i));
 
     // Extension header
     if(header->x) {
+        // The size check above could not see the extension at all
+        if(size < 16U + (4U * header->cc))
+            return -1;
+
         const uint8_t *ext_hdr = buffer + (12 + (4 * header->cc));
+        const uint16_t ext_count = read_u16(ext_hdr + 2);
+
+        if(size < 16U + (4U * header->cc) + (4U * ext_count))
+            return -1;
+
+        if(ext_count <= LIBRTP_HEADER_EXT_INLINE) {
+            header->ext_data = header->ext_inline;
+        }
+        else {
+            header->ext_data = (uint32_t*)rtp_malloc(
+                header->allocator, 4U * ext_count);
+
+            if(!header->ext_data)
+                return -1;
+        }
+
         header->ext_id = read_u16(ext_hdr);
-        header->ext_count = read_u16(ext_hdr + 2);
-        header->ext_data = (uint32_t*)malloc(4 * header->ext_count);
+        header->ext_count = ext_count;
 
         const uint8_t *ext_data = ext_hdr + 4;
         for(uint16_t i = 0; i < header->ext_count; ++i)
@@ -175,24 +197,14 @@ int rtp_header_add_csrc(rtp_header *header, uint32_t csrc)
 {
     assert(header != NULL);
 
-    if(!header->cc) {
-        header->csrc = (uint32_t*)malloc(sizeof(uint32_t));
-        header->cc = 1;
-    }
-    else {
-        if(header->cc == 0xff)
-            return -1;
-
-        if(rtp_header_find_csrc(header, csrc) != -1)
-            return -1;
-
-        header->cc += 1;
+    if(header->cc >= RTP_MAX_CSRC)
+        return -1;
 
-        const size_t nmemb = header->cc * sizeof(uint32_t);
-        header->csrc = (uint32_t*)realloc(header->csrc, nmemb);
-    }
+    if(rtp_header_find_csrc(header, csrc) != -1)
+        return -1;
 
-    header->csrc[header->cc - 1] = csrc;
+    header->csrc[header->cc] = csrc;
+    header->cc += 1;
 
     return 0;
 }
@@ -205,19 +217,11 @@ void rtp_header_remove_csrc(rtp_header *header, uint32_t csrc)
     if(index < 0)
         return;
 
-    const size_t size = (unsigned)(header->cc - index) * sizeof(uint32_t);
+    const size_t size = (unsigned)(header->cc - index - 1) * sizeof(uint32_t);
     if(size)
         memmove(&header->csrc[index], &header->csrc[index + 1], size);
 
     header->cc -= 1;
-    if(header->cc > 0) {
-        const size_t nmemb = header->cc * sizeof(uint32_t);
-        header->csrc = (uint32_t*)realloc(header->csrc, nmemb);
-    }
-    else {
-        free(header->csrc);
-        header->csrc = NULL;
-    }
 }
 
 int rtp_header_set_ext(
@@ -229,10 +233,15 @@ int rtp_header_set_ext(
     if(header->ext_data)
         return -1;
 
-    const size_t size = 4 * count;
-    header->ext_data = (uint32_t*)malloc(size);
-    if(!header->ext_data)
-        return -1;
+    const size_t size = 4U * count;
+    if(count <= LIBRTP_HEADER_EXT_INLINE) {
+        header->ext_data = header->ext_inline;
+    }
+    else {
+        header->ext_data = (uint32_t*)rtp_malloc(header->allocator, size);
+        if(!header->ext_data)
+            return -1;
+    }
 
     header->ext_id = id;
     header->ext_count = count;
@@ -246,7 +255,10 @@ void rtp_header_clear_ext(rtp_header *header)
     assert(header != NULL);
 
     if(header->ext_data) {
-        free(header->ext_data);
+        if(header->ext_data != header->ext_inline)
+            rtp_free(header->allocator, header->ext_data);
+
+        header->ext_data = NULL;
         header->ext_id = 0;
         header->ext_count = 0;
     }
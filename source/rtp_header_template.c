@@ -0,0 +1,48 @@
+/**
+ * @file rtp_header_template.c
+ * @brief Pre-rendered RTP header for the send path.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "rtp_header_template.h"
+#include "util.h"
+
+int rtp_header_template_init(
+    rtp_header_template *tmpl, const rtp_header *header)
+{
+    assert(tmpl != NULL);
+    assert(header != NULL);
+
+    memset(tmpl, 0, sizeof(rtp_header_template));
+
+    const int size = rtp_header_serialize(
+        header, tmpl->data, sizeof(tmpl->data));
+
+    if(size < 0)
+        return -1;
+
+    tmpl->size = (size_t)size;
+    if(header->x && header->ext_data) {
+        tmpl->ext_offset = 16U + (4U * header->cc);
+        tmpl->ext_count = header->ext_count;
+    }
+
+    return 0;
+}
+
+int rtp_header_template_set_ext(
+    rtp_header_template *tmpl, uint16_t index, uint32_t value)
+{
+    assert(tmpl != NULL);
+
+    if(index >= tmpl->ext_count)
+        return -1;
+
+    write_u32(tmpl->data + tmpl->ext_offset + (4U * index), value);
+    return 0;
+}
@@ -0,0 +1,228 @@
+/**
+ * @file rtp_loss.c
+ * @brief RTP per-source loss, duplicate and reordering statistics.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "rtp_loss.h"
+#include "alloc.h"
+
+#if LIBRTP_LOSS_WINDOW < 64 || (LIBRTP_LOSS_WINDOW % 64) != 0
+#error "LIBRTP_LOSS_WINDOW must be a multiple of 64"
+#endif
+
+/**
+ * @brief Finish the open loss cluster.
+ *
+ * A cluster with a single loss is an isolated loss within a gap, anything
+ * longer is a burst.
+ *
+ * @private
+ */
+static void close_cluster(rtp_loss *l)
+{
+    if(l->cluster_lost == 1) {
+        l->gap_packets += 1;
+        l->gap_lost += 1;
+    }
+    else if(l->cluster_lost > 1) {
+        l->bursts += 1;
+        l->burst_packets += l->cluster_packets;
+        l->burst_lost += l->cluster_lost;
+    }
+
+    l->cluster_packets = 0;
+    l->cluster_lost = 0;
+}
+
+/**
+ * @brief Classify a run of consecutive lost packets.
+ * @private
+ */
+static void on_lost(rtp_loss *l, uint32_t count)
+{
+    if(l->cluster_lost == 0 || l->run >= l->gmin) {
+        // Gmin packets in a row ended the previous cluster
+        close_cluster(l);
+        l->gap_packets += l->run;
+        l->cluster_packets = count;
+    }
+    else {
+        l->cluster_packets += l->run + count;
+    }
+
+    l->cluster_lost += count;
+    l->run = 0;
+}
+
+/**
+ * @brief Retire the oldest count sequence numbers from the window, in
+ * order, and clear their bits.
+ * @private
+ */
+static void retire(rtp_loss *l, uint32_t first, uint32_t count)
+{
+    while(count > 0) {
+        const uint32_t pos = first % LIBRTP_LOSS_WINDOW;
+        const uint32_t bit = pos % 64;
+        const uint32_t n = (count < 64 - bit) ? count : 64 - bit;
+        const uint64_t mask = (n == 64) ? ~0ull : ((1ull << n) - 1);
+
+        uint64_t *word = &l->window[pos / 64];
+        uint64_t missing = ~(*word >> bit) & mask;
+        *word &= ~(mask << bit);
+
+        // Walk the zero bits, everything between them was received
+        uint32_t done = 0;
+        while(missing) {
+            const uint32_t at = (uint32_t)__builtin_ctzll(missing);
+            l->run += at - done;
+            on_lost(l, 1);
+            done = at + 1;
+            missing &= missing - 1;
+        }
+
+        l->run += n - done;
+        first += n;
+        count -= n;
+    }
+}
+
+/**
+ * @brief Returns lost / packets as a fraction of 256, saturated to 255.
+ * @private
+ */
+static uint8_t density(uint32_t lost, uint32_t packets)
+{
+    const uint64_t value = ((uint64_t)lost << 8) / packets;
+    return (uint8_t)((value > 255) ? 255 : value);
+}
+
+rtp_loss *rtp_loss_create()
+{
+    return rtp_loss_create_with_allocator(NULL);
+}
+
+rtp_loss *rtp_loss_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtp_loss *l = (rtp_loss*)rtp_malloc(allocator, sizeof(rtp_loss));
+    if(l) {
+        l->allocator = allocator;
+        rtp_loss_init(l);
+    }
+
+    return l;
+}
+
+void rtp_loss_free(rtp_loss *l)
+{
+    assert(l != NULL);
+
+    rtp_free(l->allocator, l);
+}
+
+void rtp_loss_init(rtp_loss *l)
+{
+    assert(l != NULL);
+
+    // Everything but the allocator, which is the last member
+    memset(l, 0, offsetof(rtp_loss, allocator));
+    l->gmin = LIBRTP_LOSS_GMIN;
+}
+
+int rtp_loss_update(rtp_loss *l, uint32_t seq)
+{
+    assert(l != NULL);
+
+    // The first packet starts the window
+    if(l->filled == 0)
+        l->highest = seq - 1;
+
+    const uint32_t ahead = seq - l->highest;
+    if(ahead != 0 && ahead < 0x80000000u) {
+        // Slide the window forward, the oldest bits fall out in order
+        const uint32_t first = l->highest - l->filled + 1;
+        const uint64_t span = (uint64_t)l->filled + ahead;
+
+        if(span > LIBRTP_LOSS_WINDOW) {
+            const uint64_t leaving = span - LIBRTP_LOSS_WINDOW;
+            if(leaving <= l->filled) {
+                retire(l, first, (uint32_t)leaving);
+            }
+            else {
+                // Jumped past the whole window
+                retire(l, first, l->filled);
+                on_lost(l, (uint32_t)(leaving - l->filled));
+            }
+
+            l->filled = LIBRTP_LOSS_WINDOW;
+        }
+        else {
+            l->filled = (uint32_t)span;
+        }
+
+        l->highest = seq;
+    }
+    else {
+        const uint32_t distance = l->highest - seq;
+        if(distance >= l->filled) {
+            l->late += 1;
+            return -1;
+        }
+
+        const uint32_t pos = seq % LIBRTP_LOSS_WINDOW;
+        if(l->window[pos / 64] & (1ull << (pos % 64))) {
+            l->duplicates += 1;
+            return 1;
+        }
+
+        l->reordered += 1;
+        if(distance > l->max_reorder)
+            l->max_reorder = distance;
+    }
+
+    const uint32_t pos = seq % LIBRTP_LOSS_WINDOW;
+    l->window[pos / 64] |= 1ull << (pos % 64);
+    l->received += 1;
+    return 0;
+}
+
+void rtp_loss_get_stats(const rtp_loss *l, rtp_loss_stats *stats)
+{
+    assert(l != NULL);
+    assert(stats != NULL);
+
+    // Count the open cluster and trailing run as if the stream ended here
+    rtp_loss tmp = *l;
+    close_cluster(&tmp);
+    tmp.gap_packets += tmp.run;
+
+    memset(stats, 0, sizeof(rtp_loss_stats));
+    stats->received = l->received;
+    stats->lost = tmp.burst_lost + tmp.gap_lost;
+    stats->duplicates = l->duplicates;
+    stats->reordered = l->reordered;
+    stats->max_reorder = l->max_reorder;
+    stats->late = l->late;
+    stats->bursts = tmp.bursts;
+
+    if(tmp.burst_packets) {
+        stats->burst_density = density(tmp.burst_lost, tmp.burst_packets);
+        stats->burst_length = tmp.burst_packets / tmp.bursts;
+    }
+
+    if(tmp.gap_packets) {
+        stats->gap_density = density(tmp.gap_lost, tmp.gap_packets);
+
+        // Gaps come before, between and after the bursts
+        stats->gap_length = tmp.gap_packets / (tmp.bursts + 1);
+    }
+}
@@ -11,16 +11,27 @@
 #include <assert.h>
 
 #include "rtp_packet.h"
+#include "alloc.h"
 
 rtp_packet *rtp_packet_create()
 {
-    rtp_packet *packet = (rtp_packet*)malloc(sizeof(rtp_packet));
+    return rtp_packet_create_with_allocator(NULL);
+}
+
+rtp_packet *rtp_packet_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtp_packet *packet = (rtp_packet*)rtp_malloc(
+        allocator, sizeof(rtp_packet));
+
     if(packet) {
         memset(packet, 0, sizeof(rtp_packet));
-        packet->header = rtp_header_create();
+        packet->allocator = allocator;
+        packet->header = rtp_header_create_with_allocator(allocator);
 
         if(!packet->header) {
-            free(packet);
+            rtp_free(allocator, packet);
             packet = NULL;
         }
     }
@@ -35,10 +46,10 @@ void rtp_packet_free(rtp_packet *packet)
     if(packet->header)
         rtp_header_free(packet->header);
 
-    if(packet->payload_data)
-        free(packet->payload_data);
+    if(packet->payload_data && !packet->payload_capacity)
+        rtp_free(packet->allocator, packet->payload_data);
 
-    free(packet);
+    rtp_free(packet->allocator, packet);
 }
 
 void rtp_packet_init(
@@ -76,6 +87,48 @@ int rtp_packet_serialize(const rtp_packet *packet, uint8_t *buffer, size_t size)
     return (int)packet_size;
 }
 
+int rtp_packet_serialize_iov(
+    const rtp_packet *packet,
+    uint8_t *buffer,
+    size_t size,
+    uint8_t padding,
+    struct iovec *iov,
+    size_t iovcnt)
+{
+    assert(packet != NULL);
+    assert(buffer != NULL);
+    assert(iov != NULL);
+
+    const size_t count = (padding) ? 3 : 2;
+    if(iovcnt < count)
+        return -1;
+
+    const size_t header_size = rtp_header_size(packet->header);
+    if(size < header_size + padding)
+        return -1;
+
+    if(rtp_header_serialize(packet->header, buffer, size) < 0)
+        return -1;
+
+    iov[0].iov_base = buffer;
+    iov[0].iov_len = header_size;
+    iov[1].iov_base = packet->payload_data;
+    iov[1].iov_len = packet->payload_size;
+
+    if(padding) {
+        // The last padding byte holds the count, including itself
+        uint8_t *pad = buffer + header_size;
+        memset(pad, 0, padding - 1U);
+        pad[padding - 1] = padding;
+
+        buffer[0] |= (1 << 5);
+        iov[2].iov_base = pad;
+        iov[2].iov_len = padding;
+    }
+
+    return (int)count;
+}
+
 int rtp_packet_parse(rtp_packet *packet, const uint8_t *buffer, size_t size)
 {
     assert(packet != NULL);
@@ -85,9 +138,8 @@ int rtp_packet_parse(rtp_packet *packet, const uint8_t *buffer, size_t size)
         return -1;
 
     const size_t header_size = rtp_header_size(packet->header);
-    rtp_packet_set_payload(packet, buffer + header_size, size - header_size);
-
-    return 0;
+    return rtp_packet_set_payload(
+        packet, buffer + header_size, size - header_size);
 }
 
 int rtp_packet_set_payload(rtp_packet *packet, const void *data, size_t size)
@@ -95,10 +147,19 @@ int rtp_packet_set_payload(rtp_packet *packet, const void *data, size_t size)
     assert(packet != NULL);
     assert(data != NULL);
 
+    if(packet->payload_capacity) {
+        if(packet->payload_size || size > packet->payload_capacity)
+            return -1;
+
+        packet->payload_size = size;
+        memcpy(packet->payload_data, data, size);
+        return 0;
+    }
+
     if(packet->payload_data)
         return -1;
 
-    packet->payload_data = malloc(size);
+    packet->payload_data = rtp_malloc(packet->allocator, size);
     if(!packet->payload_data)
         return -1;
 
@@ -112,8 +173,13 @@ void rtp_packet_clear_payload(rtp_packet *packet)
 {
     assert(packet != NULL);
 
+    if(packet->payload_capacity) {
+        packet->payload_size = 0;
+        return;
+    }
+
     if(packet->payload_data) {
-        free(packet->payload_data);
+        rtp_free(packet->allocator, packet->payload_data);
         packet->payload_data = NULL;
         packet->payload_size = 0;
     }
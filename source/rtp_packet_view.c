@@ -0,0 +1,218 @@
+/**
+ * @file rtp_packet_view.c
+ * @brief Non-owning RTP packet view.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <assert.h>
+
+#include "rtp_packet_view.h"
+#include "rtp_decode.h"
+#include "util.h"
+
+/**
+ * @brief Classify the fixed header octets of a packet.
+ *
+ * @param [in] b0 - first header octet.
+ * @param [in] b1 - second header octet.
+ * @return rtp_parse_status.
+ * @private
+ */
+static inline uint8_t check_fixed(uint8_t b0, uint8_t b1)
+{
+    // Version must be 2
+    const uint8_t version = (uint8_t)(b0 >> 6);
+
+    // Payload type must not be in the range [72-95]
+    const uint8_t pt = (uint8_t)(b1 & 0x7f);
+
+    if(version != 2)
+        return RTP_PARSE_VERSION;
+
+    if(pt < 96 && pt > 71)
+        return RTP_PARSE_PT;
+
+    return RTP_PARSE_OK;
+}
+
+/**
+ * @brief Decode the fixed header fields of a validated packet.
+ *
+ * @param [out] view - view to fill.
+ * @param [in] buffer - buffer of at least 12 bytes.
+ * @private
+ */
+static inline void decode_fixed(rtp_packet_view *view, const uint8_t *buffer)
+{
+    view->version = (unsigned)((buffer[0] >> 6) & 0x3);
+    view->p = (unsigned)((buffer[0] >> 5) & 0x1);
+    view->x = (unsigned)((buffer[0] >> 4) & 0x1);
+    view->cc = (unsigned)(buffer[0] & 0xf);
+    view->m = (unsigned)((buffer[1] >> 7) & 0x1);
+    view->pt = (unsigned)(buffer[1] & 0x7f);
+    view->seq = read_u16(buffer + 2);
+    view->ts = read_u32(buffer + 4);
+    view->ssrc = read_u32(buffer + 8);
+}
+
+/**
+ * @brief Locate the CSRC list, extension and payload of a packet.
+ *
+ * The fixed header fields must already be decoded into the view.
+ *
+ * @param [in,out] view - view to fill.
+ * @param [in] buffer - buffer to read from.
+ * @param [in] size - buffer size.
+ * @return rtp_parse_status.
+ * @private
+ */
+static uint8_t decode_variable(
+    rtp_packet_view *view, const uint8_t *buffer, size_t size)
+{
+    size_t offset = 12;
+
+    // Contributing source IDs
+    view->csrc = NULL;
+    if(view->cc) {
+        if(size < offset + (4U * view->cc))
+            return RTP_PARSE_LENGTH;
+
+        view->csrc = buffer + offset;
+        offset += 4U * view->cc;
+    }
+
+    // Extension header
+    view->ext_id = 0;
+    view->ext_count = 0;
+    view->ext_data = NULL;
+    if(view->x) {
+        if(size < offset + 4)
+            return RTP_PARSE_LENGTH;
+
+        view->ext_id = read_u16(buffer + offset);
+        view->ext_count = read_u16(buffer + offset + 2);
+        offset += 4;
+
+        if(size < offset + (4U * view->ext_count))
+            return RTP_PARSE_LENGTH;
+
+        view->ext_data = buffer + offset;
+        offset += 4U * view->ext_count;
+    }
+
+    // Padding - the last octet holds the number of octets to ignore
+    size_t padding = 0;
+    if(view->p) {
+        if(size == offset)
+            return RTP_PARSE_LENGTH;
+
+        padding = buffer[size - 1];
+        if(padding == 0 || padding > size - offset)
+            return RTP_PARSE_LENGTH;
+    }
+
+    view->payload_data = buffer + offset;
+    view->payload_size = size - offset - padding;
+
+    return RTP_PARSE_OK;
+}
+
+int rtp_packet_view_parse(
+    rtp_packet_view *view, const uint8_t *buffer, size_t size)
+{
+    assert(view != NULL);
+    assert(buffer != NULL);
+
+    // Check initial size
+    if(size < 12)
+        return -1;
+
+    if(check_fixed(buffer[0], buffer[1]) != RTP_PARSE_OK)
+        return -1;
+
+    decode_fixed(view, buffer);
+    if(decode_variable(view, buffer, size) != RTP_PARSE_OK)
+        return -1;
+
+    return 0;
+}
+
+size_t rtp_parse_batch(
+    const struct iovec *in, size_t n, rtp_packet_view *out, uint8_t *status)
+{
+    assert(in != NULL || n == 0);
+    assert(out != NULL || n == 0);
+    assert(status != NULL || n == 0);
+
+    size_t valid = 0;
+    for(size_t base = 0; base < n; base += LIBRTP_DECODE_MAX) {
+        size_t count = n - base;
+        if(count > LIBRTP_DECODE_MAX)
+            count = LIBRTP_DECODE_MAX;
+
+        const struct iovec *iov = in + base;
+        uint8_t *st = status + base;
+
+        // Decode and validate the fixed headers of the whole block at once
+        rtp_fixed fixed[LIBRTP_DECODE_MAX];
+        const uint64_t mask = rtp_decode_fixed(iov, count, fixed);
+
+        for(size_t i = 0; i < count; ++i) {
+            if(!((mask >> i) & 1)) {
+                st[i] = (iov[i].iov_len < 12)
+                    ? RTP_PARSE_SHORT : check_fixed(fixed[i].b0, fixed[i].b1);
+                continue;
+            }
+
+            rtp_packet_view *view = &out[base + i];
+            const rtp_fixed *f = &fixed[i];
+
+            view->version = 2;
+            view->p = (unsigned)((f->b0 >> 5) & 0x1);
+            view->x = (unsigned)((f->b0 >> 4) & 0x1);
+            view->cc = (unsigned)(f->b0 & 0xf);
+            view->m = (unsigned)((f->b1 >> 7) & 0x1);
+            view->pt = (unsigned)(f->b1 & 0x7f);
+            view->seq = f->seq;
+            view->ts = f->ts;
+            view->ssrc = f->ssrc;
+
+            st[i] = decode_variable(
+                view, (const uint8_t*)iov[i].iov_base, iov[i].iov_len);
+
+            if(st[i] == RTP_PARSE_OK)
+                valid++;
+        }
+    }
+
+    return valid;
+}
+
+size_t rtp_packet_view_header_size(const rtp_packet_view *view)
+{
+    assert(view != NULL);
+
+    size_t size = 12 + (4U * view->cc);
+    if(view->x)
+        size += 4U * (1 + view->ext_count);
+
+    return size;
+}
+
+uint32_t rtp_packet_view_csrc(const rtp_packet_view *view, uint8_t index)
+{
+    assert(view != NULL);
+    assert(index < view->cc);
+
+    return read_u32(view->csrc + (4 * index));
+}
+
+uint32_t rtp_packet_view_ext(const rtp_packet_view *view, uint16_t index)
+{
+    assert(view != NULL);
+    assert(index < view->ext_count);
+
+    return read_u32(view->ext_data + (4 * index));
+}
@@ -0,0 +1,293 @@
+/**
+ * @file rtp_pool.c
+ * @brief Fixed-capacity RTP packet pool.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "rtp_pool.h"
+#include "alloc.h"
+#include "util.h"
+
+#if (LIBRTP_POOL_SHARDS & (LIBRTP_POOL_SHARDS - 1)) != 0
+#error "LIBRTP_POOL_SHARDS must be a power of two"
+#endif
+
+/**
+ * @brief Pool packet storage, followed by the payload.
+ * @private
+ */
+typedef struct pool_slot {
+    rtp_packet packet;          /**< Must be first. */
+    rtp_header header;          /**< Inline header. */
+    uint32_t next;              /**< Free list link (index + 1). */
+} pool_slot;
+
+/**
+ * @brief Lock-free free list head.
+ *
+ * The low 32 bits hold the index + 1 of the first free slot and the high 32
+ * bits an ABA tag that is bumped by every update.
+ *
+ * @private
+ */
+typedef struct pool_shard {
+    uint64_t head;
+    uint8_t pad[LIBRTP_CACHE_LINE - sizeof(uint64_t)];
+} pool_shard;
+
+struct rtp_pool {
+    pool_shard shards[LIBRTP_POOL_SHARDS];  /**< Free lists. */
+    size_t in_use;                          /**< Packets acquired. */
+    size_t high_water;                      /**< Peak of in_use. */
+    uint64_t exhausted;                     /**< Failed acquires. */
+    size_t capacity;                        /**< Number of slots. */
+    size_t payload_capacity;                /**< Payload bytes per slot. */
+    size_t stride;                          /**< Bytes between slots. */
+    uint8_t *slab;                          /**< First slot. */
+    void *slab_base;                        /**< Unaligned slab allocation. */
+    void *base;                             /**< Unaligned pool allocation. */
+    const rtp_allocator *allocator;         /**< Allocator. */
+};
+
+/**
+ * @brief Free list each thread pushes to and pops from first (index + 1).
+ * @private
+ */
+static LIBRTP_THREAD_LOCAL unsigned int thread_shard;
+
+/**
+ * @brief Round-robin counter used to spread threads over shards.
+ * @private
+ */
+static unsigned int next_shard;
+
+/**
+ * @brief Returns the calling thread's shard.
+ * @private
+ */
+static unsigned int get_shard(void)
+{
+    if(!thread_shard) {
+        const unsigned int n = __atomic_fetch_add(
+            &next_shard, 1, __ATOMIC_RELAXED);
+
+        thread_shard = (n & (LIBRTP_POOL_SHARDS - 1)) + 1;
+    }
+
+    return thread_shard - 1;
+}
+
+/**
+ * @brief Returns a slot by index.
+ * @private
+ */
+static inline pool_slot *get_slot(const rtp_pool *pool, uint32_t index)
+{
+    return (pool_slot*)(pool->slab + ((size_t)index * pool->stride));
+}
+
+/**
+ * @brief Push a slot onto a free list.
+ * @private
+ */
+static void push(rtp_pool *pool, pool_shard *shard, uint32_t index)
+{
+    pool_slot *slot = get_slot(pool, index);
+    uint64_t head = __atomic_load_n(&shard->head, __ATOMIC_RELAXED);
+    uint64_t next;
+
+    do {
+        __atomic_store_n(&slot->next, (uint32_t)head, __ATOMIC_RELAXED);
+        next = ((head >> 32) + 1) << 32 | (uint64_t)(index + 1);
+    } while(!__atomic_compare_exchange_n(&shard->head, &head, next, 1,
+        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/**
+ * @brief Pop a slot from a free list.
+ * @return slot or NULL if the list is empty.
+ * @private
+ */
+static pool_slot *pop(rtp_pool *pool, pool_shard *shard)
+{
+    uint64_t head = __atomic_load_n(&shard->head, __ATOMIC_ACQUIRE);
+    pool_slot *slot;
+    uint64_t next;
+
+    do {
+        const uint32_t index = (uint32_t)head;
+        if(!index)
+            return NULL;
+
+        // May read a stale link, in which case the tag check fails below
+        slot = get_slot(pool, index - 1);
+        next = ((head >> 32) + 1) << 32
+            | __atomic_load_n(&slot->next, __ATOMIC_RELAXED);
+    } while(!__atomic_compare_exchange_n(&shard->head, &head, next, 1,
+        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    return slot;
+}
+
+/**
+ * @brief Reset a slot's packet to its empty state.
+ * @private
+ */
+static void reset_slot(rtp_pool *pool, pool_slot *slot)
+{
+    rtp_header *header = &slot->header;
+    rtp_header_clear_ext(header);
+
+    memset(header, 0, sizeof(rtp_header));
+    header->allocator = pool->allocator;
+
+    slot->packet.header = header;
+    slot->packet.payload_size = 0;
+    slot->packet.payload_data = (uint8_t*)slot + sizeof(pool_slot);
+    slot->packet.payload_capacity = pool->payload_capacity;
+    slot->packet.allocator = pool->allocator;
+}
+
+rtp_pool *rtp_pool_create(size_t capacity, size_t payload_capacity)
+{
+    return rtp_pool_create_with_allocator(capacity, payload_capacity, NULL);
+}
+
+rtp_pool *rtp_pool_create_with_allocator(
+    size_t capacity, size_t payload_capacity, const rtp_allocator *allocator)
+{
+    if(capacity == 0 || capacity >= UINT32_MAX || payload_capacity == 0)
+        return NULL;
+
+    // The slab holds capacity strides plus its alignment slack
+    if(payload_capacity > SIZE_MAX - sizeof(pool_slot) - (2 * LIBRTP_CACHE_LINE))
+        return NULL;
+
+    const size_t stride = (sizeof(pool_slot) + payload_capacity
+        + LIBRTP_CACHE_LINE - 1) & ~(size_t)(LIBRTP_CACHE_LINE - 1);
+
+    if(capacity > (SIZE_MAX - LIBRTP_CACHE_LINE) / stride)
+        return NULL;
+
+    allocator = rtp_allocator_or_default(allocator);
+
+    void *base = rtp_malloc(allocator, sizeof(rtp_pool) + LIBRTP_CACHE_LINE);
+    if(!base)
+        return NULL;
+
+    // Keep the shard heads on their own cache lines
+    const uintptr_t aligned = ((uintptr_t)base + LIBRTP_CACHE_LINE - 1)
+        & ~(uintptr_t)(LIBRTP_CACHE_LINE - 1);
+
+    rtp_pool *pool = (rtp_pool*)aligned;
+    memset(pool, 0, sizeof(rtp_pool));
+
+    pool->allocator = allocator;
+    pool->capacity = capacity;
+    pool->payload_capacity = payload_capacity;
+    pool->stride = stride;
+
+    uint8_t *slab = (uint8_t*)rtp_malloc(
+        allocator, (capacity * pool->stride) + LIBRTP_CACHE_LINE);
+
+    if(!slab) {
+        rtp_free(allocator, base);
+        return NULL;
+    }
+
+    pool->base = base;
+    pool->slab_base = slab;
+    pool->slab = (uint8_t*)(((uintptr_t)slab + LIBRTP_CACHE_LINE - 1)
+        & ~(uintptr_t)(LIBRTP_CACHE_LINE - 1));
+
+    // Deal the slots out over the free lists
+    for(size_t i = capacity; i > 0; --i) {
+        const uint32_t index = (uint32_t)(i - 1);
+        pool_slot *slot = get_slot(pool, index);
+        memset(slot, 0, sizeof(pool_slot));
+        reset_slot(pool, slot);
+
+        push(pool, &pool->shards[index & (LIBRTP_POOL_SHARDS - 1)], index);
+    }
+
+    return pool;
+}
+
+void rtp_pool_free(rtp_pool *pool)
+{
+    assert(pool != NULL);
+
+    for(size_t i = 0; i < pool->capacity; ++i)
+        rtp_header_clear_ext(&get_slot(pool, (uint32_t)i)->header);
+
+    const rtp_allocator *allocator = pool->allocator;
+    rtp_free(allocator, pool->slab_base);
+    rtp_free(allocator, pool->base);
+}
+
+rtp_packet *rtp_pool_acquire(rtp_pool *pool)
+{
+    assert(pool != NULL);
+
+    const unsigned int home = get_shard();
+
+    pool_slot *slot = NULL;
+    for(unsigned int i = 0; i < LIBRTP_POOL_SHARDS && !slot; ++i) {
+        const unsigned int shard = (home + i) & (LIBRTP_POOL_SHARDS - 1);
+        slot = pop(pool, &pool->shards[shard]);
+    }
+
+    if(!slot) {
+        __atomic_fetch_add(&pool->exhausted, 1, __ATOMIC_RELAXED);
+        return NULL;
+    }
+
+    const size_t in_use = __atomic_add_fetch(
+        &pool->in_use, 1, __ATOMIC_RELAXED);
+
+    size_t high = __atomic_load_n(&pool->high_water, __ATOMIC_RELAXED);
+    while(in_use > high) {
+        if(__atomic_compare_exchange_n(&pool->high_water, &high, in_use, 1,
+            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            break;
+    }
+
+    return &slot->packet;
+}
+
+void rtp_pool_release(rtp_pool *pool, rtp_packet *packet)
+{
+    assert(pool != NULL);
+    assert(packet != NULL);
+
+    const uint8_t *ptr = (const uint8_t*)packet;
+    assert(ptr >= pool->slab);
+
+    const size_t index = (size_t)(ptr - pool->slab) / pool->stride;
+    assert(index < pool->capacity);
+
+    pool_slot *slot = get_slot(pool, (uint32_t)index);
+    assert(&slot->packet == packet);
+
+    reset_slot(pool, slot);
+
+    __atomic_fetch_sub(&pool->in_use, 1, __ATOMIC_RELAXED);
+    push(pool, &pool->shards[get_shard()], (uint32_t)index);
+}
+
+void rtp_pool_get_stats(const rtp_pool *pool, rtp_pool_stats *stats)
+{
+    assert(pool != NULL);
+    assert(stats != NULL);
+
+    stats->capacity = pool->capacity;
+    stats->in_use = __atomic_load_n(&pool->in_use, __ATOMIC_RELAXED);
+    stats->high_water = __atomic_load_n(&pool->high_water, __ATOMIC_RELAXED);
+    stats->exhausted = __atomic_load_n(&pool->exhausted, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,121 @@
+/**
+ * @file rtp_random.c
+ * @brief Pseudo-random number generation.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <assert.h>
+
+#include "rtp_random.h"
+#include "util.h"
+
+/**
+ * @brief The calling thread's generator, all zero until seeded.
+ * @private
+ */
+static LIBRTP_THREAD_LOCAL rtp_random thread_random;
+
+/**
+ * @brief Advance a splitmix64 state and return its next output.
+ * @private
+ */
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ull);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Rotate left.
+ * @private
+ */
+static inline uint64_t rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+void rtp_random_seed(rtp_random *r, uint64_t seed)
+{
+    assert(r != NULL);
+
+    // splitmix64 never yields four zero words in a row
+    for(int i = 0; i < 4; ++i)
+        r->s[i] = splitmix64(&seed);
+}
+
+void rtp_random_init(rtp_random *r)
+{
+    assert(r != NULL);
+
+    uint64_t seed = 0;
+    FILE *f = fopen("/dev/urandom", "rb");
+    if(f) {
+        if(fread(&seed, sizeof(seed), 1, f) != 1)
+            seed = 0;
+
+        fclose(f);
+    }
+
+    // Distinct per generator even when the clock is coarse
+    if(seed == 0) {
+        seed = (uint64_t)time(NULL);
+        seed = seed * 0x100000001b3ull ^ (uint64_t)clock();
+        seed = seed * 0x100000001b3ull ^ (uint64_t)(uintptr_t)r;
+    }
+
+    rtp_random_seed(r, seed);
+}
+
+rtp_random *rtp_random_thread(void)
+{
+    rtp_random *r = &thread_random;
+    if((r->s[0] | r->s[1] | r->s[2] | r->s[3]) == 0)
+        rtp_random_init(r);
+
+    return r;
+}
+
+uint64_t rtp_random_next(rtp_random *r)
+{
+    assert(r != NULL);
+
+    uint64_t *s = r->s;
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    return result;
+}
+
+double rtp_random_double(rtp_random *r)
+{
+    // The top 53 bits fill the mantissa exactly
+    return (double)(rtp_random_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+uint32_t rtp_random_ssrc(rtp_random *r)
+{
+    return (uint32_t)(rtp_random_next(r) >> 32);
+}
+
+uint16_t rtp_random_seq(rtp_random *r)
+{
+    return (uint16_t)(rtp_random_next(r) >> 48);
+}
+
+uint32_t rtp_random_ts(rtp_random *r)
+{
+    return (uint32_t)(rtp_random_next(r) >> 32);
+}
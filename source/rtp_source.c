@@ -11,6 +11,17 @@
 #include <assert.h>
 
 #include "rtp_source.h"
+#include "alloc.h"
+
+#if !defined(LIBRTP_NO_SIMD) && defined(__GNUC__)
+#if defined(__SSE2__)
+#define LIBRTP_SEQ_SSE2
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define LIBRTP_SEQ_NEON
+#include <arm_neon.h>
+#endif
+#endif
 
 /**
  * @brief RTP sequence number rollover value.
@@ -18,11 +29,26 @@
  */
 #define LIBRTP_SEQ_MOD (1 << 16)
 
+/**
+ * @brief Packets per pass of rtp_source_update_jitter_batch().
+ * @private
+ */
+#define JITTER_CHUNK (64)
+
 rtp_source *rtp_source_create()
 {
-    rtp_source *s = (rtp_source*)malloc(sizeof(rtp_source));
-    if(s)
+    return rtp_source_create_with_allocator(NULL);
+}
+
+rtp_source *rtp_source_create_with_allocator(const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtp_source *s = (rtp_source*)rtp_malloc(allocator, sizeof(rtp_source));
+    if(s) {
         memset(s, 0, sizeof(rtp_source));
+        s->allocator = allocator;
+    }
 
     return s;
 }
@@ -31,7 +57,7 @@ void rtp_source_free(rtp_source *s)
 {
     assert(s != NULL);
 
-    free(s);
+    rtp_free(s->allocator, s);
 }
 
 void rtp_source_init(rtp_source *s, uint32_t id, uint16_t seq)
@@ -113,6 +139,111 @@ int rtp_source_update_seq(rtp_source *s, uint16_t seq)
     return 0;
 }
 
+/**
+ * @brief Returns a mask with bit i set where seqs[i] == next + i.
+ * @private
+ */
+static uint64_t in_order_mask(const uint16_t *seqs, size_t n, uint16_t next)
+{
+    uint64_t mask = 0;
+    size_t i = 0;
+
+#if defined(LIBRTP_SEQ_SSE2)
+    const __m128i step = _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7);
+    for(; i + 8 <= n; i += 8) {
+        const __m128i expected = _mm_add_epi16(
+            _mm_set1_epi16((short)(uint16_t)(next + i)), step);
+
+        const __m128i eq = _mm_cmpeq_epi16(
+            _mm_loadu_si128((const __m128i*)(seqs + i)), expected);
+
+        const int bits = _mm_movemask_epi8(_mm_packs_epi16(eq, eq)) & 0xff;
+        mask |= (uint64_t)bits << i;
+    }
+#elif defined(LIBRTP_SEQ_NEON)
+    static const uint16_t steps[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+    static const uint16_t weights[8] = { 1, 2, 4, 8, 16, 32, 64, 128 };
+
+    const uint16x8_t step = vld1q_u16(steps);
+    const uint16x8_t weight = vld1q_u16(weights);
+    for(; i + 8 <= n; i += 8) {
+        const uint16x8_t expected = vaddq_u16(
+            vdupq_n_u16((uint16_t)(next + i)), step);
+
+        const uint16x8_t eq = vceqq_u16(vld1q_u16(seqs + i), expected);
+        mask |= (uint64_t)vaddvq_u16(vandq_u16(eq, weight)) << i;
+    }
+#endif
+
+    for(; i < n; ++i)
+        mask |= (uint64_t)(seqs[i] == (uint16_t)(next + i)) << i;
+
+    return mask;
+}
+
+uint64_t rtp_source_update_seq_batch(
+    rtp_source *s, const uint16_t *seqs, size_t n)
+{
+    assert(s != NULL);
+    assert(seqs != NULL || n == 0);
+    assert(n <= 64);
+
+    uint64_t accepted = 0;
+    size_t i = 0;
+    while(i < n) {
+        size_t run = 0;
+
+#if LIBRTP_MIN_SEQUENTIAL > 0
+        if(s->probation == 0)
+#endif
+        {
+            // Leading packets that continue max_seq
+            const uint64_t mask = in_order_mask(
+                seqs + i, n - i, (uint16_t)(s->max_seq + 1));
+
+            run = (~mask) ? (size_t)__builtin_ctzll(~mask) : 64;
+            if(run > n - i)
+                run = n - i;
+
+            // Leave the wrap to the scalar path so it counts the cycle
+            const size_t room = (size_t)(LIBRTP_SEQ_MOD - 1 - s->max_seq);
+            if(run > room)
+                run = room;
+        }
+
+        if(run > 0) {
+            s->max_seq = (uint16_t)(s->max_seq + run);
+            s->received += (int)run;
+
+            const uint64_t bits = (run == 64) ? ~0ull : ((1ull << run) - 1);
+            accepted |= bits << i;
+            i += run;
+            continue;
+        }
+
+        if(rtp_source_update_seq(s, seqs[i]) == 0)
+            accepted |= 1ull << i;
+
+        i += 1;
+    }
+
+    return accepted;
+}
+
+uint32_t rtp_source_extended_seq(const rtp_source *s, uint16_t seq)
+{
+    assert(s != NULL);
+
+    uint32_t ext = s->cycles + seq;
+
+    // Numerically higher but behind max_seq, so sent before the wrap
+    const uint16_t behind = s->max_seq - seq;
+    if(seq > s->max_seq && behind < LIBRTP_SEQ_MOD / 2)
+        ext -= LIBRTP_SEQ_MOD;
+
+    return ext;
+}
+
 void rtp_source_update_lost(rtp_source *s)
 {
     assert(s != NULL);
@@ -142,7 +273,72 @@ void rtp_source_update_jitter(rtp_source *s, uint32_t ts, uint32_t arrival)
     int d = abs(transit - s->transit);
 
     s->transit = transit;
+#if LIBRTP_JITTER_FIXED
+    s->jitter += (uint32_t)d - ((s->jitter + 8) >> 4);
+#else
     s->jitter += (1./16.) * ((double)d - s->jitter);
+#endif
+}
+
+void rtp_source_update_jitter_batch(
+    rtp_source *s, const uint32_t *ts, const uint32_t *arrival, size_t n)
+{
+    assert(s != NULL);
+    assert((ts != NULL && arrival != NULL) || n == 0);
+
+    uint32_t transit[JITTER_CHUNK];
+    uint32_t d[JITTER_CHUNK];
+
+    while(n > 0) {
+        const size_t count = (n < JITTER_CHUNK) ? n : JITTER_CHUNK;
+
+        // Independent per packet, these loops vectorize
+        for(size_t i = 0; i < count; ++i)
+            transit[i] = arrival[i] - ts[i];
+
+        d[0] = (uint32_t)abs((int)(transit[0] - (uint32_t)s->transit));
+        for(size_t i = 1; i < count; ++i)
+            d[i] = (uint32_t)abs((int)(transit[i] - transit[i - 1]));
+
+#if LIBRTP_JITTER_FIXED
+        uint32_t jitter = s->jitter;
+        for(size_t i = 0; i < count; ++i)
+            jitter += d[i] - ((jitter + 8) >> 4);
+#else
+        double jitter = s->jitter;
+        for(size_t i = 0; i < count; ++i)
+            jitter += (1./16.) * ((double)d[i] - jitter);
+#endif
+
+        s->jitter = jitter;
+        s->transit = (int)transit[count - 1];
+
+        ts += count;
+        arrival += count;
+        n -= count;
+    }
+}
+
+uint32_t rtp_timespec_to_rtp(const struct timespec *t, uint32_t clock_rate)
+{
+    assert(t != NULL);
+
+    const uint64_t sec = (uint64_t)t->tv_sec * clock_rate;
+    const uint64_t frac = ((uint64_t)t->tv_nsec * clock_rate) / 1000000000u;
+
+    return (uint32_t)(sec + frac);
+}
+
+void rtp_source_update_arrival(
+    rtp_source *s,
+    uint32_t ts,
+    const struct timespec *arrival,
+    uint32_t clock_rate)
+{
+    assert(s != NULL);
+    assert(arrival != NULL);
+
+    rtp_source_update_jitter(s, ts, rtp_timespec_to_rtp(arrival, clock_rate));
 }
 
 void rtp_source_update_lsr(rtp_source *s, ntp_tv tc)
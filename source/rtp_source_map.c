@@ -0,0 +1,447 @@
+/**
+ * @file rtp_source_map.c
+ * @brief Concurrent table of RTP sources.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "rtp_source_map.h"
+#include "alloc.h"
+#include "util.h"
+
+struct rtp_source_map_entry {
+    rtp_source_map_entry *next;     /**< Bucket chain, read without locks. */
+    rtp_source_map_entry *retired;  /**< Removed entries awaiting free. */
+    uint64_t epoch;                 /**< Epoch the entry was removed in. */
+    uint32_t ssrc;                  /**< Key, immutable. */
+    uint32_t sequence;              /**< Sequence lock, odd while writing. */
+    rtp_source source;              /**< Writer's state. */
+    uint32_t base_seq;              /**< Reporter's view of source.base_seq. */
+    int expected_prior;             /**< Reporter's interval counter. */
+    int received_prior;             /**< Reporter's interval counter. */
+    ntp_tv lsr;                     /**< Reporter's last SR time. */
+};
+
+/**
+ * @brief Per-thread epoch announcement.
+ *
+ * The state is 0 outside of read sections and (epoch << 1) | 1 inside.
+ *
+ * @private
+ */
+typedef struct reader_slot {
+    uint64_t state;
+    uint32_t joined;
+    uint8_t pad[LIBRTP_CACHE_LINE - sizeof(uint64_t) - sizeof(uint32_t)];
+} reader_slot;
+
+struct rtp_source_map {
+    reader_slot readers[LIBRTP_SOURCE_MAP_THREADS]; /**< Reader epochs. */
+    uint64_t epoch;                 /**< Global epoch. */
+    uint32_t lock;                  /**< Serializes insert and remove. */
+    size_t count;                   /**< Number of sources. */
+    rtp_source_map_entry **buckets; /**< Hash chains. */
+    unsigned int shift;             /**< 64 - log2(bucket count). */
+    rtp_source_map_entry *retired;  /**< Removed entries, newest first. */
+    void *base;                     /**< Unaligned map allocation. */
+    const rtp_allocator *allocator; /**< Allocator. */
+};
+
+/**
+ * @brief Returns an SSRC's bucket.
+ * @private
+ */
+static inline size_t bucket_of(const rtp_source_map *m, uint32_t ssrc)
+{
+    return (size_t)((ssrc * 0x9e3779b97f4a7c15ull) >> m->shift);
+}
+
+/**
+ * @brief Take the writer lock.
+ * @private
+ */
+static void lock(rtp_source_map *m)
+{
+    while(__atomic_exchange_n(&m->lock, 1, __ATOMIC_ACQUIRE)) {
+        while(__atomic_load_n(&m->lock, __ATOMIC_RELAXED))
+            continue;
+    }
+}
+
+/**
+ * @brief Release the writer lock.
+ * @private
+ */
+static void unlock(rtp_source_map *m)
+{
+    __atomic_store_n(&m->lock, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Find an entry in a bucket chain.
+ * @private
+ */
+static rtp_source_map_entry *find_entry(
+    rtp_source_map *m, size_t bucket, uint32_t ssrc)
+{
+    rtp_source_map_entry *e = __atomic_load_n(
+        &m->buckets[bucket], __ATOMIC_ACQUIRE);
+
+    while(e && e->ssrc != ssrc)
+        e = __atomic_load_n(&e->next, __ATOMIC_ACQUIRE);
+
+    return e;
+}
+
+/**
+ * @brief Advance the epoch if possible and free what is unreachable, with
+ * the writer lock held.
+ * @private
+ */
+static void reclaim(rtp_source_map *m)
+{
+    // Order earlier unlinks before reading the reader epochs
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    const uint64_t epoch = __atomic_load_n(&m->epoch, __ATOMIC_RELAXED);
+
+    int advance = 1;
+    for(size_t i = 0; i < LIBRTP_SOURCE_MAP_THREADS; ++i) {
+        const uint64_t state = __atomic_load_n(
+            &m->readers[i].state, __ATOMIC_ACQUIRE);
+
+        if((state & 1) && (state >> 1) != epoch) {
+            advance = 0;
+            break;
+        }
+    }
+
+    if(advance)
+        __atomic_store_n(&m->epoch, epoch + 1, __ATOMIC_SEQ_CST);
+
+    // Readers are at most one epoch behind the global epoch, so anything
+    // removed two epochs ago can no longer be referenced
+    const uint64_t safe = (advance) ? epoch + 1 : epoch;
+    rtp_source_map_entry **link = &m->retired;
+    while(*link && (*link)->epoch + 2 > safe)
+        link = &(*link)->retired;
+
+    rtp_source_map_entry *e = *link;
+    *link = NULL;
+
+    while(e) {
+        rtp_source_map_entry *next = e->retired;
+        rtp_free(m->allocator, e);
+        e = next;
+    }
+}
+
+rtp_source_map *rtp_source_map_create(size_t buckets)
+{
+    return rtp_source_map_create_with_allocator(buckets, NULL);
+}
+
+rtp_source_map *rtp_source_map_create_with_allocator(
+    size_t buckets, const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    unsigned int bits = 1;
+    while(((size_t)1 << bits) < buckets)
+        bits += 1;
+
+    // Keep reader slots on their own cache lines
+    void *base = rtp_malloc(
+        allocator, sizeof(rtp_source_map) + LIBRTP_CACHE_LINE);
+
+    if(!base)
+        return NULL;
+
+    const uintptr_t aligned = ((uintptr_t)base + LIBRTP_CACHE_LINE - 1)
+        & ~(uintptr_t)(LIBRTP_CACHE_LINE - 1);
+
+    rtp_source_map *m = (rtp_source_map*)aligned;
+    memset(m, 0, sizeof(rtp_source_map));
+    m->base = base;
+    m->allocator = allocator;
+    m->shift = 64 - bits;
+    m->buckets = (rtp_source_map_entry**)rtp_calloc(
+        allocator, (size_t)1 << bits, sizeof(rtp_source_map_entry*));
+
+    if(!m->buckets) {
+        rtp_free(allocator, base);
+        return NULL;
+    }
+
+    return m;
+}
+
+void rtp_source_map_free(rtp_source_map *m)
+{
+    assert(m != NULL);
+
+    const size_t buckets = (size_t)1 << (64 - m->shift);
+    for(size_t i = 0; i < buckets; ++i) {
+        rtp_source_map_entry *e = m->buckets[i];
+        while(e) {
+            rtp_source_map_entry *next = e->next;
+            rtp_free(m->allocator, e);
+            e = next;
+        }
+    }
+
+    rtp_source_map_entry *e = m->retired;
+    while(e) {
+        rtp_source_map_entry *next = e->retired;
+        rtp_free(m->allocator, e);
+        e = next;
+    }
+
+    rtp_free(m->allocator, m->buckets);
+    rtp_free(m->allocator, m->base);
+}
+
+int rtp_source_map_join(rtp_source_map *m)
+{
+    assert(m != NULL);
+
+    for(int i = 0; i < LIBRTP_SOURCE_MAP_THREADS; ++i) {
+        uint32_t expected = 0;
+        if(__atomic_compare_exchange_n(&m->readers[i].joined, &expected, 1,
+            0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+void rtp_source_map_leave(rtp_source_map *m, int reader)
+{
+    assert(m != NULL);
+    assert(reader >= 0 && reader < LIBRTP_SOURCE_MAP_THREADS);
+    assert(m->readers[reader].state == 0);
+
+    __atomic_store_n(&m->readers[reader].joined, 0, __ATOMIC_RELEASE);
+}
+
+void rtp_source_map_read_lock(rtp_source_map *m, int reader)
+{
+    assert(m != NULL);
+    assert(reader >= 0 && reader < LIBRTP_SOURCE_MAP_THREADS);
+
+    const uint64_t epoch = __atomic_load_n(&m->epoch, __ATOMIC_RELAXED);
+    __atomic_store_n(
+        &m->readers[reader].state, (epoch << 1) | 1, __ATOMIC_SEQ_CST);
+
+    // Publish the epoch before loading any entry pointers
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void rtp_source_map_read_unlock(rtp_source_map *m, int reader)
+{
+    assert(m != NULL);
+    assert(reader >= 0 && reader < LIBRTP_SOURCE_MAP_THREADS);
+
+    __atomic_store_n(&m->readers[reader].state, 0, __ATOMIC_RELEASE);
+}
+
+size_t rtp_source_map_size(const rtp_source_map *m)
+{
+    assert(m != NULL);
+
+    return __atomic_load_n(&m->count, __ATOMIC_RELAXED);
+}
+
+rtp_source_map_entry *rtp_source_map_find(rtp_source_map *m, uint32_t ssrc)
+{
+    assert(m != NULL);
+
+    return find_entry(m, bucket_of(m, ssrc), ssrc);
+}
+
+rtp_source_map_entry *rtp_source_map_next(
+    rtp_source_map *m, rtp_source_map_entry *entry)
+{
+    assert(m != NULL);
+
+    size_t bucket = 0;
+    if(entry) {
+        rtp_source_map_entry *next = __atomic_load_n(
+            &entry->next, __ATOMIC_ACQUIRE);
+
+        if(next)
+            return next;
+
+        bucket = bucket_of(m, entry->ssrc) + 1;
+    }
+
+    const size_t buckets = (size_t)1 << (64 - m->shift);
+    for(; bucket < buckets; ++bucket) {
+        rtp_source_map_entry *e = __atomic_load_n(
+            &m->buckets[bucket], __ATOMIC_ACQUIRE);
+
+        if(e)
+            return e;
+    }
+
+    return NULL;
+}
+
+rtp_source_map_entry *rtp_source_map_insert(
+    rtp_source_map *m, uint32_t ssrc, uint16_t seq)
+{
+    assert(m != NULL);
+
+    const size_t bucket = bucket_of(m, ssrc);
+    rtp_source_map_entry *e = find_entry(m, bucket, ssrc);
+    if(e)
+        return e;
+
+    lock(m);
+
+    // Another thread may have added it while we waited
+    e = find_entry(m, bucket, ssrc);
+    if(!e) {
+        e = (rtp_source_map_entry*)rtp_malloc(
+            m->allocator, sizeof(rtp_source_map_entry));
+
+        if(e) {
+            memset(e, 0, sizeof(rtp_source_map_entry));
+            e->ssrc = ssrc;
+            e->source.allocator = m->allocator;
+            rtp_source_init(&e->source, ssrc, seq);
+            e->base_seq = e->source.base_seq;
+            e->next = m->buckets[bucket];
+
+            // The entry is fully initialized before readers can reach it
+            __atomic_store_n(&m->buckets[bucket], e, __ATOMIC_RELEASE);
+            __atomic_store_n(&m->count, m->count + 1, __ATOMIC_RELAXED);
+        }
+
+        reclaim(m);
+    }
+
+    unlock(m);
+    return e;
+}
+
+int rtp_source_map_remove(rtp_source_map *m, uint32_t ssrc)
+{
+    assert(m != NULL);
+
+    lock(m);
+
+    rtp_source_map_entry **link = &m->buckets[bucket_of(m, ssrc)];
+    while(*link && (*link)->ssrc != ssrc)
+        link = &(*link)->next;
+
+    rtp_source_map_entry *e = *link;
+    if(e) {
+        // Readers standing on e can still follow its next pointer
+        __atomic_store_n(link, e->next, __ATOMIC_RELEASE);
+        __atomic_store_n(&m->count, m->count - 1, __ATOMIC_RELAXED);
+
+        e->epoch = __atomic_load_n(&m->epoch, __ATOMIC_RELAXED);
+        e->retired = m->retired;
+        m->retired = e;
+
+        reclaim(m);
+    }
+
+    unlock(m);
+    return (e) ? 0 : -1;
+}
+
+void rtp_source_map_reclaim(rtp_source_map *m)
+{
+    assert(m != NULL);
+
+    lock(m);
+    reclaim(m);
+    unlock(m);
+}
+
+rtp_source *rtp_source_map_write_begin(rtp_source_map_entry *entry)
+{
+    assert(entry != NULL);
+
+    const uint32_t sequence = __atomic_load_n(
+        &entry->sequence, __ATOMIC_RELAXED);
+
+    assert((sequence & 1) == 0);
+    __atomic_store_n(&entry->sequence, sequence + 1, __ATOMIC_RELAXED);
+
+    // Readers that see any of the new data also see the odd sequence
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    return &entry->source;
+}
+
+void rtp_source_map_write_end(rtp_source_map_entry *entry)
+{
+    assert(entry != NULL);
+
+    const uint32_t sequence = __atomic_load_n(
+        &entry->sequence, __ATOMIC_RELAXED);
+
+    assert((sequence & 1) == 1);
+    __atomic_store_n(&entry->sequence, sequence + 1, __ATOMIC_RELEASE);
+}
+
+void rtp_source_map_read(const rtp_source_map_entry *entry, rtp_source *s)
+{
+    assert(entry != NULL);
+    assert(s != NULL);
+
+    for(;;) {
+        const uint32_t before = __atomic_load_n(
+            &entry->sequence, __ATOMIC_ACQUIRE);
+
+        if(before & 1)
+            continue;
+
+        memcpy(s, &entry->source, sizeof(rtp_source));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        if(__atomic_load_n(&entry->sequence, __ATOMIC_RELAXED) == before)
+            return;
+    }
+}
+
+void rtp_source_map_update_lsr(rtp_source_map_entry *entry, ntp_tv lsr)
+{
+    assert(entry != NULL);
+
+    entry->lsr = lsr;
+}
+
+void rtp_source_map_report(
+    rtp_source_map_entry *entry, rtcp_report *report, ntp_tv tc)
+{
+    assert(entry != NULL);
+    assert(report != NULL);
+
+    rtp_source s;
+    rtp_source_map_read(entry, &s);
+
+    // The writer restarted the sequence, restart the intervals with it
+    if(s.base_seq != entry->base_seq) {
+        entry->base_seq = s.base_seq;
+        entry->expected_prior = 0;
+        entry->received_prior = 0;
+    }
+
+    s.expected_prior = entry->expected_prior;
+    s.received_prior = entry->received_prior;
+    s.lsr = entry->lsr;
+    rtp_source_update_lost(&s);
+
+    entry->expected_prior = s.expected_prior;
+    entry->received_prior = s.received_prior;
+    rtcp_report_init(report, &s, tc);
+}
@@ -0,0 +1,525 @@
+/**
+ * @file rtp_source_table.c
+ * @brief Hash-indexed table of RTP sources.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "rtp_source_table.h"
+#include "alloc.h"
+
+/**
+ * @brief Marks an unused index slot.
+ * @private
+ */
+#define SLOT_EMPTY (UINT32_MAX)
+
+/**
+ * @brief Index slot, maps an SSRC to its position in the source array.
+ * @private
+ */
+typedef struct slot {
+    uint32_t ssrc;          /**< Synchronization source. */
+    uint32_t index;         /**< Position in the source array. */
+} slot;
+
+struct rtp_source_table {
+    rtp_source *sources;    /**< Dense source array. */
+    uint64_t *origins;      /**< Sender address hash per source, 0 if unset. */
+    size_t count;           /**< Number of sources. */
+    size_t capacity;        /**< Capacity of the source array. */
+    slot *slots;            /**< Robin-hood index. */
+    size_t mask;            /**< Index size - 1, a power of two minus one. */
+    unsigned int shift;     /**< 64 - log2(index size). */
+    uint32_t local;         /**< Local SSRC. */
+    int has_local;          /**< Local SSRC is set. */
+    rtp_timer_wheel *wheel; /**< Timeout wheel, or NULL. */
+    rtp_timer *timers;      /**< Timeout timer per source. */
+    uint64_t *seen;         /**< Tick each source was last heard from. */
+    uint64_t timeout;       /**< Ticks of silence before removal. */
+    rtp_source_timeout_handler on_timeout; /**< Timeout handler. */
+    void *timeout_ctx;      /**< Timeout handler context. */
+    const rtp_allocator *allocator; /**< Allocator. */
+};
+
+/**
+ * @brief Returns an SSRC's home slot.
+ * @private
+ */
+static inline size_t home_slot(const rtp_source_table *t, uint32_t ssrc)
+{
+    // Fibonacci hashing, the top bits are well mixed
+    return (size_t)((ssrc * 0x9e3779b97f4a7c15ull) >> t->shift);
+}
+
+/**
+ * @brief Returns how far a slot's entry is from its home.
+ * @private
+ */
+static inline size_t probe_distance(const rtp_source_table *t, size_t pos)
+{
+    return (pos - home_slot(t, t->slots[pos].ssrc)) & t->mask;
+}
+
+/**
+ * @brief Returns the index slot holding an SSRC, or SIZE_MAX.
+ * @private
+ */
+static size_t find_slot(const rtp_source_table *t, uint32_t ssrc)
+{
+    size_t pos = home_slot(t, ssrc);
+    for(size_t dist = 0;; ++dist) {
+        const slot *s = &t->slots[pos];
+        if(s->index == SLOT_EMPTY)
+            return SIZE_MAX;
+
+        if(s->ssrc == ssrc)
+            return pos;
+
+        // Robin-hood order: a richer entry means ssrc would have been here
+        if(probe_distance(t, pos) < dist)
+            return SIZE_MAX;
+
+        pos = (pos + 1) & t->mask;
+    }
+}
+
+/**
+ * @brief Place an entry known to be absent into the index.
+ * @private
+ */
+static void place_slot(rtp_source_table *t, slot entry)
+{
+    size_t pos = home_slot(t, entry.ssrc);
+    for(size_t dist = 0;; ++dist) {
+        slot *s = &t->slots[pos];
+        if(s->index == SLOT_EMPTY) {
+            *s = entry;
+            return;
+        }
+
+        // Take from the rich, the displaced entry continues probing
+        const size_t existing = probe_distance(t, pos);
+        if(existing < dist) {
+            const slot tmp = *s;
+            *s = entry;
+            entry = tmp;
+            dist = existing;
+        }
+
+        pos = (pos + 1) & t->mask;
+    }
+}
+
+/**
+ * @brief Allocate an index of 2^bits slots and fill it from the sources.
+ * @private
+ */
+static int build_index(rtp_source_table *t, unsigned int bits)
+{
+    const size_t size = (size_t)1 << bits;
+    slot *slots = (slot*)rtp_malloc(t->allocator, size * sizeof(slot));
+    if(!slots)
+        return -1;
+
+    memset(slots, 0xff, size * sizeof(slot));
+    rtp_free(t->allocator, t->slots);
+
+    t->slots = slots;
+    t->mask = size - 1;
+    t->shift = 64 - bits;
+
+    for(size_t i = 0; i < t->count; ++i) {
+        slot entry = { t->sources[i].id, (uint32_t)i };
+        place_slot(t, entry);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Take every source's timer out of the wheel.
+ * @private
+ */
+static void cancel_timers(rtp_source_table *t)
+{
+    if(!t->wheel)
+        return;
+
+    for(size_t i = 0; i < t->count; ++i)
+        rtp_timer_wheel_cancel(t->wheel, &t->timers[i]);
+}
+
+/**
+ * @brief Put every source's timer back at its expiry.
+ * @private
+ */
+static void arm_timers(rtp_source_table *t)
+{
+    if(!t->wheel)
+        return;
+
+    for(size_t i = 0; i < t->count; ++i)
+        rtp_timer_wheel_add(t->wheel, &t->timers[i], t->timers[i].expires);
+}
+
+/**
+ * @brief Grow the timeout arrays.
+ * @private
+ */
+static int grow_timers(rtp_source_table *t, size_t capacity)
+{
+    uint64_t *seen = (uint64_t*)rtp_realloc(
+        t->allocator, t->seen, capacity * sizeof(uint64_t));
+    if(!seen)
+        return -1;
+
+    t->seen = seen;
+
+    // Pending timers point at each other, unlink them while the array moves
+    cancel_timers(t);
+    rtp_timer *timers = (rtp_timer*)rtp_realloc(
+        t->allocator, t->timers, capacity * sizeof(rtp_timer));
+    if(timers)
+        t->timers = timers;
+
+    arm_timers(t);
+    return (timers) ? 0 : -1;
+}
+
+/**
+ * @brief Timer handler, removes a source unless it was heard from since.
+ * @private
+ */
+static void expire_source(void *ctx, rtp_timer *timer)
+{
+    rtp_source_table *t = (rtp_source_table*)ctx;
+    const size_t index = (size_t)(timer - t->timers);
+    const uint64_t expires = t->seen[index] + t->timeout;
+
+    if(expires > rtp_timer_wheel_now(t->wheel)) {
+        rtp_timer_wheel_add(t->wheel, timer, expires);
+        return;
+    }
+
+    if(t->on_timeout)
+        t->on_timeout(t->timeout_ctx, &t->sources[index]);
+
+    rtp_source_table_remove(t, t->sources[index].id);
+}
+
+/**
+ * @brief Make room for one more source.
+ * @private
+ */
+static int reserve(rtp_source_table *t)
+{
+    if(t->count == t->capacity) {
+        const size_t capacity = 2 * t->capacity;
+
+        rtp_source *sources = (rtp_source*)rtp_realloc(
+            t->allocator, t->sources, capacity * sizeof(rtp_source));
+        if(!sources)
+            return -1;
+
+        t->sources = sources;
+
+        uint64_t *origins = (uint64_t*)rtp_realloc(
+            t->allocator, t->origins, capacity * sizeof(uint64_t));
+        if(!origins)
+            return -1;
+
+        t->origins = origins;
+
+        if(t->timers && grow_timers(t, capacity) < 0)
+            return -1;
+
+        t->capacity = capacity;
+    }
+
+    // Keep the index at most 7/8 full
+    if((t->count + 1) * 8 > (t->mask + 1) * 7)
+        return build_index(t, 64 - t->shift + 1);
+
+    return 0;
+}
+
+/**
+ * @brief Returns a non-zero hash of a sender address.
+ * @private
+ */
+static uint64_t hash_origin(const void *from, size_t len)
+{
+    // FNV-1a
+    const uint8_t *data = (const uint8_t*)from;
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for(size_t i = 0; i < len; ++i) {
+        hash ^= data[i];
+        hash *= 0x100000001b3ull;
+    }
+
+    return (hash) ? hash : 1;
+}
+
+rtp_source_table *rtp_source_table_create(size_t capacity)
+{
+    return rtp_source_table_create_with_allocator(capacity, NULL);
+}
+
+rtp_source_table *rtp_source_table_create_with_allocator(
+    size_t capacity, const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    if(capacity < 8)
+        capacity = 8;
+
+    if(capacity >= SLOT_EMPTY / 2)
+        return NULL;
+
+    rtp_source_table *t = (rtp_source_table*)rtp_malloc(
+        allocator, sizeof(rtp_source_table));
+
+    if(!t)
+        return NULL;
+
+    memset(t, 0, sizeof(rtp_source_table));
+    t->allocator = allocator;
+    t->capacity = capacity;
+    t->sources = (rtp_source*)rtp_malloc(
+        allocator, capacity * sizeof(rtp_source));
+    t->origins = (uint64_t*)rtp_malloc(allocator, capacity * sizeof(uint64_t));
+
+    // Smallest index that holds capacity sources at 7/8 load
+    unsigned int bits = 3;
+    while(((size_t)1 << bits) * 7 < capacity * 8)
+        bits += 1;
+
+    if(!t->sources || !t->origins || build_index(t, bits) < 0) {
+        rtp_source_table_free(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+void rtp_source_table_free(rtp_source_table *t)
+{
+    assert(t != NULL);
+
+    cancel_timers(t);
+    rtp_free(t->allocator, t->timers);
+    rtp_free(t->allocator, t->seen);
+    rtp_free(t->allocator, t->sources);
+    rtp_free(t->allocator, t->origins);
+    rtp_free(t->allocator, t->slots);
+    rtp_free(t->allocator, t);
+}
+
+void rtp_source_table_set_local(rtp_source_table *t, uint32_t ssrc)
+{
+    assert(t != NULL);
+
+    t->local = ssrc;
+    t->has_local = 1;
+}
+
+size_t rtp_source_table_size(const rtp_source_table *t)
+{
+    assert(t != NULL);
+
+    return t->count;
+}
+
+rtp_source *rtp_source_table_at(rtp_source_table *t, size_t index)
+{
+    assert(t != NULL);
+    assert(index < t->count);
+
+    return &t->sources[index];
+}
+
+rtp_source *rtp_source_table_find(rtp_source_table *t, uint32_t ssrc)
+{
+    assert(t != NULL);
+
+    const size_t pos = find_slot(t, ssrc);
+    if(pos == SIZE_MAX)
+        return NULL;
+
+    return &t->sources[t->slots[pos].index];
+}
+
+rtp_source *rtp_source_table_insert(
+    rtp_source_table *t, uint32_t ssrc, uint16_t seq)
+{
+    assert(t != NULL);
+
+    rtp_source *s = rtp_source_table_find(t, ssrc);
+    if(s)
+        return s;
+
+    if(reserve(t) < 0)
+        return NULL;
+
+    const size_t index = t->count;
+    s = &t->sources[index];
+    memset(s, 0, sizeof(rtp_source));
+    s->allocator = t->allocator;
+    rtp_source_init(s, ssrc, seq);
+
+    t->origins[index] = 0;
+    t->count += 1;
+
+    if(t->wheel) {
+        const uint64_t now = rtp_timer_wheel_now(t->wheel);
+        rtp_timer_init(&t->timers[index], expire_source, t);
+        t->seen[index] = now;
+        rtp_timer_wheel_add(t->wheel, &t->timers[index], now + t->timeout);
+    }
+
+    slot entry = { ssrc, (uint32_t)index };
+    place_slot(t, entry);
+
+    return s;
+}
+
+int rtp_source_table_remove(rtp_source_table *t, uint32_t ssrc)
+{
+    assert(t != NULL);
+
+    size_t pos = find_slot(t, ssrc);
+    if(pos == SIZE_MAX)
+        return -1;
+
+    const size_t index = t->slots[pos].index;
+
+    // Backward-shift deletion keeps probe sequences unbroken
+    size_t next = (pos + 1) & t->mask;
+    while(t->slots[next].index != SLOT_EMPTY && probe_distance(t, next) > 0) {
+        t->slots[pos] = t->slots[next];
+        pos = next;
+        next = (next + 1) & t->mask;
+    }
+    t->slots[pos].index = SLOT_EMPTY;
+
+    if(t->wheel)
+        rtp_timer_wheel_cancel(t->wheel, &t->timers[index]);
+
+    // Move the last source into the hole
+    t->count -= 1;
+    if(index != t->count) {
+        t->sources[index] = t->sources[t->count];
+        t->origins[index] = t->origins[t->count];
+        if(t->wheel) {
+            rtp_timer_move(&t->timers[index], &t->timers[t->count]);
+            t->seen[index] = t->seen[t->count];
+        }
+
+        t->slots[find_slot(t, t->sources[index].id)].index = (uint32_t)index;
+    }
+
+    return 0;
+}
+
+int rtp_source_table_set_timeout(
+    rtp_source_table *t,
+    rtp_timer_wheel *w,
+    uint64_t timeout,
+    rtp_source_timeout_handler handler,
+    void *ctx)
+{
+    assert(t != NULL);
+
+    cancel_timers(t);
+    t->wheel = NULL;
+    if(!w)
+        return 0;
+
+    if(!t->timers) {
+        t->timers = (rtp_timer*)rtp_malloc(
+            t->allocator, t->capacity * sizeof(rtp_timer));
+        t->seen = (uint64_t*)rtp_malloc(
+            t->allocator, t->capacity * sizeof(uint64_t));
+
+        if(!t->timers || !t->seen) {
+            rtp_free(t->allocator, t->timers);
+            rtp_free(t->allocator, t->seen);
+            t->timers = NULL;
+            t->seen = NULL;
+            return -1;
+        }
+    }
+
+    t->wheel = w;
+    t->timeout = timeout;
+    t->on_timeout = handler;
+    t->timeout_ctx = ctx;
+
+    const uint64_t now = rtp_timer_wheel_now(w);
+    for(size_t i = 0; i < t->count; ++i) {
+        rtp_timer_init(&t->timers[i], expire_source, t);
+        t->seen[i] = now;
+        rtp_timer_wheel_add(w, &t->timers[i], now + timeout);
+    }
+
+    return 0;
+}
+
+void rtp_source_table_touch(rtp_source_table *t, const rtp_source *source)
+{
+    assert(t != NULL);
+    assert(source >= t->sources && source < t->sources + t->count);
+
+    if(t->wheel)
+        t->seen[source - t->sources] = rtp_timer_wheel_now(t->wheel);
+}
+
+rtp_source_status rtp_source_table_receive(
+    rtp_source_table *t,
+    uint32_t ssrc,
+    uint16_t seq,
+    const void *from,
+    size_t len,
+    rtp_source **source)
+{
+    assert(t != NULL);
+    assert(source != NULL);
+    assert(from != NULL || len == 0);
+
+    *source = NULL;
+    if(t->has_local && ssrc == t->local)
+        return RTP_SOURCE_COLLISION;
+
+    const uint64_t origin = (from) ? hash_origin(from, len) : 0;
+
+    const size_t pos = find_slot(t, ssrc);
+    if(pos != SIZE_MAX) {
+        const size_t index = t->slots[pos].index;
+        *source = &t->sources[index];
+
+        if(origin) {
+            if(t->origins[index] == 0)
+                t->origins[index] = origin;
+            else if(t->origins[index] != origin)
+                return RTP_SOURCE_CONFLICT;
+        }
+
+        if(t->wheel)
+            t->seen[index] = rtp_timer_wheel_now(t->wheel);
+
+        return RTP_SOURCE_FOUND;
+    }
+
+    rtp_source *s = rtp_source_table_insert(t, ssrc, seq);
+    if(!s)
+        return RTP_SOURCE_NO_MEMORY;
+
+    t->origins[s - t->sources] = origin;
+    *source = s;
+    return RTP_SOURCE_NEW;
+}
@@ -0,0 +1,319 @@
+/**
+ * @file rtp_timer_wheel.c
+ * @brief Hierarchical timer wheel.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "rtp_timer_wheel.h"
+#include "alloc.h"
+
+#if LIBRTP_TIMER_WHEEL_BITS < 6 \
+    || LIBRTP_TIMER_WHEEL_BITS * LIBRTP_TIMER_WHEEL_LEVELS > 63
+#error "LIBRTP_TIMER_WHEEL_BITS must be at least 6 and span under 64 bits"
+#endif
+
+#define SLOTS ((uint64_t)1 << LIBRTP_TIMER_WHEEL_BITS)
+#define MASK (SLOTS - 1)
+#define RANGE ((uint64_t)1 << \
+    (LIBRTP_TIMER_WHEEL_BITS * LIBRTP_TIMER_WHEEL_LEVELS))
+
+struct rtp_timer_wheel {
+    rtp_timer *slots[LIBRTP_TIMER_WHEEL_LEVELS][SLOTS]; /**< Timer lists. */
+    uint64_t occupied[LIBRTP_TIMER_WHEEL_LEVELS][SLOTS / 64]; /**< Slots
+                                                * that may be in use. */
+    uint64_t now;               /**< Last tick processed. */
+    size_t count;               /**< Pending timers. */
+    const rtp_allocator *allocator; /**< Allocator. */
+};
+
+/**
+ * @brief Remove a timer from the list it is on.
+ * @private
+ */
+static inline void unlink_timer(rtp_timer *timer)
+{
+    *timer->pprev = timer->next;
+    if(timer->next)
+        timer->next->pprev = timer->pprev;
+
+    timer->next = NULL;
+    timer->pprev = NULL;
+}
+
+/**
+ * @brief Push a timer onto a list.
+ * @private
+ */
+static inline void link_timer(rtp_timer **head, rtp_timer *timer)
+{
+    timer->next = *head;
+    timer->pprev = head;
+    if(*head)
+        (*head)->pprev = &timer->next;
+
+    *head = timer;
+}
+
+/**
+ * @brief Link a timer into the slot for its expiry.
+ * @private
+ */
+static void place(rtp_timer_wheel *w, rtp_timer *timer)
+{
+    // Relative to the next tick to process, overdue timers go in its slot
+    const uint64_t base = w->now + 1;
+    uint64_t expires = timer->expires;
+    if(expires < base)
+        expires = base;
+
+    // Beyond the last level, park it as far out as possible
+    uint64_t delta = expires - base;
+    if(delta >= RANGE) {
+        delta = RANGE - 1;
+        expires = base + delta;
+    }
+
+    unsigned int level = 0;
+    while(delta >= ((uint64_t)1 << (LIBRTP_TIMER_WHEEL_BITS * (level + 1))))
+        level += 1;
+
+    const size_t index = (size_t)(
+        (expires >> (LIBRTP_TIMER_WHEEL_BITS * level)) & MASK);
+
+    link_timer(&w->slots[level][index], timer);
+    w->occupied[level][index / 64] |= 1ull << (index % 64);
+}
+
+/**
+ * @brief Move the timers of one slot down to the levels below.
+ * @private
+ */
+static void cascade(rtp_timer_wheel *w, unsigned int level, size_t index)
+{
+    rtp_timer *list = w->slots[level][index];
+    w->slots[level][index] = NULL;
+    w->occupied[level][index / 64] &= ~(1ull << (index % 64));
+
+    while(list) {
+        rtp_timer *timer = list;
+        list = timer->next;
+        place(w, timer);
+    }
+}
+
+/**
+ * @brief Returns the first slot of a level at or after index that may hold
+ * timers, or SLOTS.
+ * @private
+ */
+static uint64_t next_occupied(
+    const rtp_timer_wheel *w, unsigned int level, uint64_t index)
+{
+    const uint64_t *occupied = w->occupied[level];
+    for(uint64_t word = index / 64; word < SLOTS / 64; ++word) {
+        uint64_t bits = occupied[word];
+        if(word == index / 64)
+            bits &= ~0ull << (index % 64);
+
+        if(bits)
+            return (word * 64) + (uint64_t)__builtin_ctzll(bits);
+    }
+
+    return SLOTS;
+}
+
+/**
+ * @brief Returns the first tick from tick on that fires or cascades a slot.
+ *
+ * Empty slots are skipped level by level. A level is only looked past
+ * when it is completely empty, otherwise the search stops at its next
+ * wrap.
+ *
+ * @private
+ */
+static uint64_t next_event(const rtp_timer_wheel *w, uint64_t tick)
+{
+    for(unsigned int level = 0; level < LIBRTP_TIMER_WHEEL_LEVELS; ++level) {
+        const unsigned int shift = LIBRTP_TIMER_WHEEL_BITS * level;
+        const uint64_t span = (uint64_t)1 << shift;
+
+        // First tick this level's slots can be reached
+        const uint64_t start = (tick + span - 1) & ~(span - 1);
+        const uint64_t index = (start >> shift) & MASK;
+
+        // The wrap of a level above comes first
+        if(index == 0 && level + 1 < LIBRTP_TIMER_WHEEL_LEVELS)
+            return start;
+
+        const uint64_t next = next_occupied(w, level, index);
+        if(next < SLOTS)
+            return start + ((next - index) << shift);
+
+        // Slots behind the index belong to the next turn of this level
+        if(next_occupied(w, level, 0) < SLOTS)
+            return (start | ((span << LIBRTP_TIMER_WHEEL_BITS) - 1)) + 1;
+    }
+
+    return (tick | (RANGE - 1)) + 1;
+}
+
+void rtp_timer_init(rtp_timer *timer, rtp_timer_handler handler, void *ctx)
+{
+    assert(timer != NULL);
+
+    memset(timer, 0, sizeof(rtp_timer));
+    timer->handler = handler;
+    timer->ctx = ctx;
+}
+
+int rtp_timer_pending(const rtp_timer *timer)
+{
+    assert(timer != NULL);
+
+    return timer->pprev != NULL;
+}
+
+void rtp_timer_move(rtp_timer *dst, rtp_timer *src)
+{
+    assert(dst != NULL);
+    assert(src != NULL);
+    assert(dst->pprev == NULL);
+
+    *dst = *src;
+    if(dst->pprev) {
+        *dst->pprev = dst;
+        if(dst->next)
+            dst->next->pprev = &dst->next;
+    }
+
+    src->next = NULL;
+    src->pprev = NULL;
+}
+
+rtp_timer_wheel *rtp_timer_wheel_create(uint64_t now)
+{
+    return rtp_timer_wheel_create_with_allocator(now, NULL);
+}
+
+rtp_timer_wheel *rtp_timer_wheel_create_with_allocator(
+    uint64_t now, const rtp_allocator *allocator)
+{
+    allocator = rtp_allocator_or_default(allocator);
+
+    rtp_timer_wheel *w = (rtp_timer_wheel*)rtp_malloc(
+        allocator, sizeof(rtp_timer_wheel));
+
+    if(w) {
+        memset(w, 0, sizeof(rtp_timer_wheel));
+        w->now = now;
+        w->allocator = allocator;
+    }
+
+    return w;
+}
+
+void rtp_timer_wheel_free(rtp_timer_wheel *w)
+{
+    assert(w != NULL);
+
+    rtp_free(w->allocator, w);
+}
+
+uint64_t rtp_timer_wheel_now(const rtp_timer_wheel *w)
+{
+    assert(w != NULL);
+
+    return w->now;
+}
+
+size_t rtp_timer_wheel_size(const rtp_timer_wheel *w)
+{
+    assert(w != NULL);
+
+    return w->count;
+}
+
+void rtp_timer_wheel_add(
+    rtp_timer_wheel *w, rtp_timer *timer, uint64_t expires)
+{
+    assert(w != NULL);
+    assert(timer != NULL);
+
+    if(timer->pprev)
+        unlink_timer(timer);
+    else
+        w->count += 1;
+
+    timer->expires = expires;
+    place(w, timer);
+}
+
+void rtp_timer_wheel_cancel(rtp_timer_wheel *w, rtp_timer *timer)
+{
+    assert(w != NULL);
+    assert(timer != NULL);
+
+    if(timer->pprev) {
+        unlink_timer(timer);
+        w->count -= 1;
+    }
+}
+
+size_t rtp_timer_wheel_advance(rtp_timer_wheel *w, uint64_t now)
+{
+    assert(w != NULL);
+
+    size_t fired = 0;
+    while(w->now < now) {
+        if(w->count == 0) {
+            w->now = now;
+            break;
+        }
+
+        const uint64_t tick = next_event(w, w->now + 1);
+        if(tick > now) {
+            w->now = now;
+            break;
+        }
+
+        w->now = tick - 1;
+
+        // Each level that wrapped brings its next slot down
+        for(unsigned int i = 1; i < LIBRTP_TIMER_WHEEL_LEVELS; ++i) {
+            const unsigned int shift = LIBRTP_TIMER_WHEEL_BITS * i;
+            if(tick & (((uint64_t)1 << shift) - 1))
+                break;
+
+            cascade(w, i, (size_t)((tick >> shift) & MASK));
+        }
+
+        const size_t index = (size_t)(tick & MASK);
+        rtp_timer *list = w->slots[0][index];
+        w->slots[0][index] = NULL;
+        w->occupied[0][index / 64] &= ~(1ull << (index % 64));
+
+        // Timers added by the handlers go in later slots
+        w->now = tick;
+
+        // Handlers may cancel timers still on the list, so keep it linked
+        if(list)
+            list->pprev = &list;
+
+        while(list) {
+            rtp_timer *timer = list;
+            unlink_timer(timer);
+            w->count -= 1;
+            fired += 1;
+
+            if(timer->handler)
+                timer->handler(timer->ctx, timer);
+        }
+    }
+
+    return fired;
+}
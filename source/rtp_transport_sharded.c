@@ -0,0 +1,275 @@
+/**
+ * @file rtp_transport_sharded.c
+ * @brief Multi-threaded SO_REUSEPORT receive engine.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <linux/filter.h>
+
+#include "rtp_transport_sharded.h"
+#include "alloc.h"
+
+/**
+ * @brief One socket and the thread that drains it.
+ * @private
+ */
+typedef struct shard {
+    rtp_transport_sharded *owner;   /**< Engine. */
+    unsigned int index;             /**< Shard index. */
+    rtp_transport_udp *udp;         /**< Socket. */
+    rtp_transport_udp_packet *packets; /**< Receive batch. */
+    pthread_t thread;               /**< Receive thread. */
+} shard;
+
+struct rtp_transport_sharded {
+    size_t count;                   /**< Number of shards. */
+    size_t batch;                   /**< Packets per receive. */
+    int pin;                        /**< Pin threads to CPUs. */
+    size_t started;                 /**< Threads running. */
+    int stop_fd;                    /**< Readable once stop is requested. */
+    rtp_transport_sharded_handler handler; /**< Packet handler. */
+    void *ctx;                      /**< Handler context. */
+    shard shards[LIBRTP_MAX_SHARDS]; /**< Shards. */
+    const rtp_allocator *allocator; /**< Allocator. */
+};
+
+/**
+ * @brief Steer datagrams by SSRC, see rtp_transport_sharded_shard_of().
+ * @private
+ */
+static int attach_ssrc_filter(int fd, size_t shards)
+{
+    // The program sees the UDP payload, absolute loads are big-endian
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 8),
+        BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, 0x9e3779b1u),
+        BPF_STMT(BPF_ALU | BPF_RSH | BPF_K, 16),
+        BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, (uint32_t)shards),
+        BPF_STMT(BPF_RET | BPF_A, 0),
+    };
+
+    struct sock_fprog prog;
+    prog.len = sizeof(code) / sizeof(code[0]);
+    prog.filter = code;
+
+    return setsockopt(
+        fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog));
+}
+
+/**
+ * @brief Receive thread, runs the handler until stopped.
+ * @private
+ */
+static void *shard_main(void *arg)
+{
+    shard *s = (shard*)arg;
+    rtp_transport_sharded *t = s->owner;
+
+    if(t->pin) {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET((int)(s->index % (unsigned long)((cpus > 0) ? cpus : 1)), &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    }
+
+    struct pollfd fds[2];
+    fds[0].fd = rtp_transport_udp_fd(s->udp);
+    fds[0].events = POLLIN;
+    fds[1].fd = t->stop_fd;
+    fds[1].events = POLLIN;
+
+    for(;;) {
+        const int n = rtp_transport_udp_recv(s->udp, s->packets, t->batch);
+        if(n > 0) {
+            t->handler(t->ctx, s->index, s->packets, (size_t)n);
+            continue;
+        }
+
+        if(n < 0 && errno != EINTR)
+            break;
+
+        // Drained, sleep until more data arrives or stop is requested
+        if(poll(fds, 2, -1) < 0 && errno != EINTR)
+            break;
+
+        if(fds[1].revents)
+            break;
+    }
+
+    return NULL;
+}
+
+rtp_transport_sharded *rtp_transport_sharded_create(
+    int family,
+    const struct sockaddr *addr,
+    socklen_t len,
+    const rtp_transport_sharded_config *config)
+{
+    assert(addr != NULL);
+    assert(config != NULL);
+    assert(config->handler != NULL);
+
+    size_t count = config->shards;
+    if(count == 0) {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        count = (cpus > 0) ? (size_t)cpus : 1;
+        if(count > LIBRTP_MAX_SHARDS)
+            count = LIBRTP_MAX_SHARDS;
+    }
+
+    if(count > LIBRTP_MAX_SHARDS)
+        return NULL;
+
+    const rtp_allocator *allocator = rtp_allocator_or_default(
+        config->udp.allocator);
+
+    rtp_transport_sharded *t = (rtp_transport_sharded*)rtp_malloc(
+        allocator, sizeof(rtp_transport_sharded));
+
+    if(!t)
+        return NULL;
+
+    memset(t, 0, sizeof(rtp_transport_sharded));
+    t->count = count;
+    t->batch = (config->udp.batch) ? config->udp.batch : LIBRTP_UDP_BATCH;
+    t->pin = config->pin;
+    t->handler = config->handler;
+    t->ctx = config->ctx;
+    t->allocator = allocator;
+
+    t->stop_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if(t->stop_fd < 0) {
+        rtp_transport_sharded_free(t);
+        return NULL;
+    }
+
+    // Threads sleep in poll(), so the sockets never block
+    rtp_transport_udp_config udp = config->udp;
+    udp.nonblocking = 1;
+
+    const int on = 1;
+    for(size_t i = 0; i < count; ++i) {
+        shard *s = &t->shards[i];
+        s->owner = t;
+        s->index = (unsigned int)i;
+        s->udp = rtp_transport_udp_create(family, &udp);
+        s->packets = (rtp_transport_udp_packet*)rtp_calloc(
+            allocator, t->batch, sizeof(rtp_transport_udp_packet));
+
+        if(!s->udp || !s->packets) {
+            rtp_transport_sharded_free(t);
+            return NULL;
+        }
+
+        // Sockets join the group in bind order, which is the BPF index
+        const int fd = rtp_transport_udp_fd(s->udp);
+        if(setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0
+            || rtp_transport_udp_bind(s->udp, addr, len) < 0)
+        {
+            rtp_transport_sharded_free(t);
+            return NULL;
+        }
+    }
+
+    if(config->ssrc_affinity && attach_ssrc_filter(
+        rtp_transport_udp_fd(t->shards[0].udp), count) < 0)
+    {
+        rtp_transport_sharded_free(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+void rtp_transport_sharded_free(rtp_transport_sharded *t)
+{
+    assert(t != NULL);
+
+    rtp_transport_sharded_stop(t);
+
+    for(size_t i = 0; i < t->count; ++i) {
+        if(t->shards[i].udp)
+            rtp_transport_udp_free(t->shards[i].udp);
+
+        rtp_free(t->allocator, t->shards[i].packets);
+    }
+
+    if(t->stop_fd >= 0)
+        close(t->stop_fd);
+
+    rtp_free(t->allocator, t);
+}
+
+int rtp_transport_sharded_start(rtp_transport_sharded *t)
+{
+    assert(t != NULL);
+
+    if(t->started)
+        return 0;
+
+    for(size_t i = 0; i < t->count; ++i) {
+        shard *s = &t->shards[i];
+        if(pthread_create(&s->thread, NULL, shard_main, s) != 0) {
+            // Unwind the threads that did start
+            rtp_transport_sharded_stop(t);
+            return -1;
+        }
+
+        t->started += 1;
+    }
+
+    return 0;
+}
+
+void rtp_transport_sharded_stop(rtp_transport_sharded *t)
+{
+    assert(t != NULL);
+
+    if(t->started == 0)
+        return;
+
+    // Only EINTR can fail a write of 1 to an eventfd that is never left set
+    const uint64_t one = 1;
+    while(write(t->stop_fd, &one, sizeof(one)) < 0 && errno == EINTR)
+        continue;
+
+    for(size_t i = 0; i < t->started; ++i)
+        pthread_join(t->shards[i].thread, NULL);
+
+    t->started = 0;
+
+    // Clear the event so the engine can be started again
+    uint64_t value;
+    while(read(t->stop_fd, &value, sizeof(value)) < 0 && errno == EINTR)
+        continue;
+}
+
+size_t rtp_transport_sharded_count(const rtp_transport_sharded *t)
+{
+    assert(t != NULL);
+
+    return t->count;
+}
+
+rtp_transport_udp *rtp_transport_sharded_get(
+    rtp_transport_sharded *t, size_t shard)
+{
+    assert(t != NULL);
+    assert(shard < t->count);
+
+    return t->shards[shard].udp;
+}
@@ -0,0 +1,494 @@
+/**
+ * @file rtp_transport_udp.c
+ * @brief Batched UDP transport.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+
+#include "rtp_transport_udp.h"
+#include "alloc.h"
+
+/**
+ * @brief Ancillary data space per received datagram.
+ * @private
+ */
+#define RX_CONTROL_SIZE (64)
+
+/**
+ * @brief Largest UDP payload the kernel will segment.
+ * @private
+ */
+#define GSO_MAX_BYTES (65507)
+
+struct rtp_transport_udp {
+    int fd;                         /**< Socket. */
+    int nonblocking;                /**< Socket is non-blocking. */
+    int gro;                        /**< UDP_GRO is enabled. */
+    int gso;                        /**< UDP_SEGMENT is worth trying. */
+    size_t batch;                   /**< Datagrams per system call. */
+    size_t slots;                   /**< Receive ring size. */
+    size_t mtu;                     /**< Receive buffer size. */
+    size_t head;                    /**< Next receive slot. */
+    uint8_t *ring;                  /**< Receive buffers. */
+    struct mmsghdr *rx_msgs;        /**< Receive headers, one per batch. */
+    struct iovec *rx_iov;           /**< Receive vectors, one per batch. */
+    struct sockaddr_storage *rx_from; /**< Sender addresses. */
+    uint8_t *rx_control;            /**< Ancillary data, one per batch. */
+    size_t rx_count;                /**< Datagrams read by the last syscall. */
+    size_t rx_index;                /**< Next datagram to return. */
+    size_t rx_offset;               /**< Next segment within that datagram. */
+    struct mmsghdr *tx_msgs;        /**< Send headers, one per batch. */
+    rtp_transport_udp_stats stats;  /**< Counters. */
+    const rtp_allocator *allocator; /**< Allocator. */
+};
+
+rtp_transport_udp *rtp_transport_udp_create(
+    int family, const rtp_transport_udp_config *config)
+{
+    rtp_transport_udp_config defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    if(config)
+        defaults = *config;
+
+    const size_t batch = (defaults.batch) ? defaults.batch : LIBRTP_UDP_BATCH;
+    const size_t slots = (defaults.slots)
+        ? defaults.slots : ((defaults.gro) ? 2 : 4) * batch;
+
+    const size_t mtu = (defaults.mtu)
+        ? defaults.mtu : ((defaults.gro) ? 65535 : LIBRTP_UDP_MTU);
+
+    if(slots < batch || batch > UINT32_MAX || mtu > SIZE_MAX / slots)
+        return NULL;
+
+    const rtp_allocator *allocator = rtp_allocator_or_default(
+        defaults.allocator);
+
+    rtp_transport_udp *t = (rtp_transport_udp*)rtp_malloc(
+        allocator, sizeof(rtp_transport_udp));
+
+    if(!t)
+        return NULL;
+
+    memset(t, 0, sizeof(rtp_transport_udp));
+    t->fd = -1;
+    t->nonblocking = defaults.nonblocking;
+    t->gso = 1;
+    t->batch = batch;
+    t->slots = slots;
+    t->mtu = mtu;
+    t->allocator = allocator;
+
+    t->ring = (uint8_t*)rtp_malloc(allocator, slots * mtu);
+    t->rx_msgs = (struct mmsghdr*)rtp_calloc(
+        allocator, batch, sizeof(struct mmsghdr));
+    t->rx_iov = (struct iovec*)rtp_calloc(
+        allocator, batch, sizeof(struct iovec));
+    t->rx_from = (struct sockaddr_storage*)rtp_calloc(
+        allocator, batch, sizeof(struct sockaddr_storage));
+    t->rx_control = (uint8_t*)rtp_calloc(allocator, batch, RX_CONTROL_SIZE);
+    t->tx_msgs = (struct mmsghdr*)rtp_calloc(
+        allocator, batch, sizeof(struct mmsghdr));
+
+    if(!t->ring || !t->rx_msgs || !t->rx_iov || !t->rx_from || !t->rx_control
+        || !t->tx_msgs)
+    {
+        rtp_transport_udp_free(t);
+        return NULL;
+    }
+
+    int type = SOCK_DGRAM | SOCK_CLOEXEC;
+    if(t->nonblocking)
+        type |= SOCK_NONBLOCK;
+
+    t->fd = socket(family, type, 0);
+    if(t->fd < 0) {
+        rtp_transport_udp_free(t);
+        return NULL;
+    }
+
+    if(defaults.gro) {
+        // Older kernels lack UDP_GRO, datagrams then simply arrive one by one
+        const int on = 1;
+        t->gro = (setsockopt(t->fd, IPPROTO_UDP, UDP_GRO, &on, sizeof(on)) == 0);
+    }
+
+    if(defaults.timestamps) {
+        const int on = 1;
+        if(setsockopt(t->fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0) {
+            rtp_transport_udp_free(t);
+            return NULL;
+        }
+    }
+
+    return t;
+}
+
+void rtp_transport_udp_free(rtp_transport_udp *t)
+{
+    assert(t != NULL);
+
+    if(t->fd >= 0)
+        close(t->fd);
+
+    rtp_free(t->allocator, t->ring);
+    rtp_free(t->allocator, t->rx_msgs);
+    rtp_free(t->allocator, t->rx_iov);
+    rtp_free(t->allocator, t->rx_from);
+    rtp_free(t->allocator, t->rx_control);
+    rtp_free(t->allocator, t->tx_msgs);
+    rtp_free(t->allocator, t);
+}
+
+int rtp_transport_udp_bind(
+    rtp_transport_udp *t, const struct sockaddr *addr, socklen_t len)
+{
+    assert(t != NULL);
+    assert(addr != NULL);
+
+    return bind(t->fd, addr, len);
+}
+
+int rtp_transport_udp_connect(
+    rtp_transport_udp *t, const struct sockaddr *addr, socklen_t len)
+{
+    assert(t != NULL);
+    assert(addr != NULL);
+
+    return connect(t->fd, addr, len);
+}
+
+int rtp_transport_udp_fd(const rtp_transport_udp *t)
+{
+    assert(t != NULL);
+
+    return t->fd;
+}
+
+/**
+ * @brief Read the GRO segment size and kernel receive time of a datagram.
+ * @private
+ */
+static void read_control(
+    const struct msghdr *hdr, size_t *segment, struct timespec *arrival)
+{
+    *segment = 0;
+    memset(arrival, 0, sizeof(struct timespec));
+
+    for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(hdr); cmsg;
+        cmsg = CMSG_NXTHDR((struct msghdr*)hdr, cmsg))
+    {
+        if(cmsg->cmsg_level == IPPROTO_UDP && cmsg->cmsg_type == UDP_GRO) {
+            int size;
+            memcpy(&size, CMSG_DATA(cmsg), sizeof(int));
+            *segment = (size > 0) ? (size_t)size : 0;
+        }
+        else if(cmsg->cmsg_level == SOL_SOCKET
+            && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            memcpy(arrival, CMSG_DATA(cmsg), sizeof(struct timespec));
+        }
+    }
+}
+
+/**
+ * @brief Read the next batch of datagrams into the ring.
+ * @private
+ */
+static int recv_batch(rtp_transport_udp *t, size_t count)
+{
+    // Point the batch at the next slots in the ring
+    for(size_t i = 0; i < count; ++i) {
+        const size_t slot = (t->head + i) % t->slots;
+
+        t->rx_iov[i].iov_base = t->ring + (slot * t->mtu);
+        t->rx_iov[i].iov_len = t->mtu;
+
+        struct msghdr *hdr = &t->rx_msgs[i].msg_hdr;
+        memset(hdr, 0, sizeof(struct msghdr));
+        hdr->msg_name = &t->rx_from[i];
+        hdr->msg_namelen = sizeof(struct sockaddr_storage);
+        hdr->msg_iov = &t->rx_iov[i];
+        hdr->msg_iovlen = 1;
+        hdr->msg_control = t->rx_control + (i * RX_CONTROL_SIZE);
+        hdr->msg_controllen = RX_CONTROL_SIZE;
+    }
+
+    const int flags = (t->nonblocking) ? MSG_DONTWAIT : MSG_WAITFORONE;
+    const int result = recvmmsg(
+        t->fd, t->rx_msgs, (unsigned int)count, flags, NULL);
+
+    t->stats.rx_syscalls += 1;
+    if(result < 0) {
+        t->stats.rx_last_batch = 0;
+        if(errno == EAGAIN || errno == EWOULDBLOCK)
+            return 0;
+
+        return -1;
+    }
+
+    t->stats.rx_last_batch = (uint32_t)result;
+    t->head = (t->head + (unsigned)result) % t->slots;
+    t->rx_count = (unsigned)result;
+    t->rx_index = 0;
+    t->rx_offset = 0;
+
+    return result;
+}
+
+int rtp_transport_udp_recv(
+    rtp_transport_udp *t, rtp_transport_udp_packet *out, size_t n)
+{
+    assert(t != NULL);
+    assert(out != NULL);
+
+    if(n == 0)
+        return 0;
+
+    if(t->rx_index >= t->rx_count) {
+        // Without GRO each datagram fills at most one entry of out
+        size_t count = t->batch;
+        if(!t->gro && n < count)
+            count = n;
+
+        const int result = recv_batch(t, count);
+        if(result <= 0)
+            return result;
+    }
+
+    size_t valid = 0;
+    while(t->rx_index < t->rx_count && valid < n) {
+        const size_t i = t->rx_index;
+        const struct msghdr *hdr = &t->rx_msgs[i].msg_hdr;
+        const size_t len = t->rx_msgs[i].msg_len;
+
+        if(hdr->msg_flags & MSG_TRUNC) {
+            t->stats.rx_packets += 1;
+            t->stats.rx_truncated += 1;
+            t->rx_index += 1;
+            continue;
+        }
+
+        size_t segment;
+        struct timespec arrival;
+        read_control(hdr, &segment, &arrival);
+        if(segment == 0 || segment > len)
+            segment = len;
+
+        if(t->rx_offset == 0 && segment < len)
+            t->stats.rx_coalesced += 1;
+
+        // Split the datagram in place, the last segment may be shorter
+        const uint8_t *data = (const uint8_t*)t->rx_iov[i].iov_base;
+        while(t->rx_offset < len && valid < n) {
+            const size_t remaining = len - t->rx_offset;
+            const size_t size = (remaining < segment) ? remaining : segment;
+
+            rtp_transport_udp_packet *packet = &out[valid];
+            const int status = rtp_packet_view_parse(
+                &packet->view, data + t->rx_offset, size);
+
+            t->stats.rx_packets += 1;
+            t->rx_offset += size;
+
+            if(status != 0) {
+                t->stats.rx_invalid += 1;
+                continue;
+            }
+
+            memcpy(&packet->from, &t->rx_from[i], hdr->msg_namelen);
+            packet->from_len = hdr->msg_namelen;
+            packet->arrival = arrival;
+            valid += 1;
+        }
+
+        if(t->rx_offset >= len) {
+            t->rx_index += 1;
+            t->rx_offset = 0;
+        }
+    }
+
+    return (int)valid;
+}
+
+int rtp_transport_udp_send(
+    rtp_transport_udp *t, const struct iovec *datagrams, size_t n)
+{
+    assert(t != NULL);
+    assert(datagrams != NULL || n == 0);
+
+    size_t sent = 0;
+    while(sent < n) {
+        const size_t count = (n - sent < t->batch) ? n - sent : t->batch;
+
+        for(size_t i = 0; i < count; ++i) {
+            struct msghdr *hdr = &t->tx_msgs[i].msg_hdr;
+            memset(hdr, 0, sizeof(struct msghdr));
+
+            // sendmmsg() does not modify the vectors
+            hdr->msg_iov = (struct iovec*)&datagrams[sent + i];
+            hdr->msg_iovlen = 1;
+        }
+
+        const int result = sendmmsg(t->fd, t->tx_msgs, (unsigned int)count, 0);
+
+        t->stats.tx_syscalls += 1;
+        if(result < 0) {
+            t->stats.tx_last_batch = 0;
+            if(sent > 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+
+            return -1;
+        }
+
+        t->stats.tx_packets += (unsigned)result;
+        t->stats.tx_last_batch = (uint32_t)result;
+        sent += (unsigned)result;
+
+        if((size_t)result < count)
+            break;
+    }
+
+    return (int)sent;
+}
+
+/**
+ * @brief Send count segments of buffer with one UDP_SEGMENT call.
+ * @private
+ */
+static int send_segmented(
+    rtp_transport_udp *t, uint8_t *buffer, size_t len, size_t segment)
+{
+    union {
+        char buf[CMSG_SPACE(sizeof(uint16_t))];
+        struct cmsghdr align;
+    } control;
+
+    memset(&control, 0, sizeof(control));
+
+    struct iovec iov = { buffer, len };
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_iov = &iov;
+    hdr.msg_iovlen = 1;
+    hdr.msg_control = control.buf;
+    hdr.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr);
+    cmsg->cmsg_level = IPPROTO_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+
+    const uint16_t gso_size = (uint16_t)segment;
+    memcpy(CMSG_DATA(cmsg), &gso_size, sizeof(uint16_t));
+
+    t->stats.tx_syscalls += 1;
+    return (int)sendmsg(t->fd, &hdr, 0);
+}
+
+int rtp_transport_udp_send_burst(
+    rtp_transport_udp *t,
+    rtp_packet *const *packets,
+    size_t n,
+    uint8_t *buffer,
+    size_t size)
+{
+    assert(t != NULL);
+    assert(packets != NULL || n == 0);
+    assert(buffer != NULL || size == 0);
+
+    if(n == 0)
+        return 0;
+
+    // Lay the packets out back-to-back, one segment apart
+    const size_t segment = (size_t)rtp_packet_size(packets[0]);
+    if(segment == 0 || segment > UINT16_MAX || n > size / segment + 1)
+        return -1;
+
+    size_t total = 0;
+    for(size_t i = 0; i < n; ++i) {
+        const int len = rtp_packet_serialize(
+            packets[i], buffer + total, size - total);
+
+        if(len < 0 || (size_t)len > segment
+            || ((size_t)len < segment && i + 1 < n))
+        {
+            return -1;
+        }
+
+        total += (size_t)len;
+    }
+
+    size_t per_call = GSO_MAX_BYTES / segment;
+    if(per_call > LIBRTP_UDP_GSO_SEGMENTS)
+        per_call = LIBRTP_UDP_GSO_SEGMENTS;
+
+    size_t sent = 0;
+    while(t->gso && sent < n && per_call > 1) {
+        const size_t count = (n - sent < per_call) ? n - sent : per_call;
+        const size_t offset = sent * segment;
+        const size_t len = (sent + count < n)
+            ? count * segment : total - offset;
+
+        if(send_segmented(t, buffer + offset, len, segment) < 0) {
+            if(errno == EINVAL || errno == EIO || errno == ENOPROTOOPT) {
+                // No segmentation offload, stop trying
+                t->gso = 0;
+                break;
+            }
+
+            t->stats.tx_last_batch = 0;
+            return (sent > 0 || errno == EAGAIN || errno == EWOULDBLOCK)
+                ? (int)sent : -1;
+        }
+
+        t->stats.tx_packets += count;
+        t->stats.tx_segmented += 1;
+        t->stats.tx_last_batch = (uint32_t)count;
+        sent += count;
+    }
+
+    // Fall back to one datagram per packet
+    while(sent < n) {
+        struct iovec iov[LIBRTP_UDP_GSO_SEGMENTS];
+
+        size_t count = 0;
+        while(count < LIBRTP_UDP_GSO_SEGMENTS && sent + count < n) {
+            const size_t offset = (sent + count) * segment;
+            iov[count].iov_base = buffer + offset;
+            iov[count].iov_len = (sent + count + 1 < n)
+                ? segment : total - offset;
+
+            count += 1;
+        }
+
+        const int result = rtp_transport_udp_send(t, iov, count);
+        if(result < 0)
+            return (sent > 0) ? (int)sent : -1;
+
+        sent += (unsigned)result;
+        if((size_t)result < count)
+            break;
+    }
+
+    return (int)sent;
+}
+
+void rtp_transport_udp_get_stats(
+    const rtp_transport_udp *t, rtp_transport_udp_stats *stats)
+{
+    assert(t != NULL);
+    assert(stats != NULL);
+
+    *stats = t->stats;
+}
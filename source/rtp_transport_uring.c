@@ -0,0 +1,664 @@
+/**
+ * @file rtp_transport_uring.c
+ * @brief io_uring UDP transport.
+ * @author Wilkins White
+ * @copyright 2022 Daxbot
+ * @ingroup rtp
+ */
+
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "rtp_transport_uring.h"
+#include "alloc.h"
+
+/**
+ * @brief Tags send completions, receive completions carry the socket index.
+ * @private
+ */
+#define TX_TAG (1ULL << 32)
+
+/**
+ * @brief Provided buffer group used for every socket.
+ * @private
+ */
+#define BUFFER_GROUP (0)
+
+struct rtp_transport_uring {
+    int fd;                         /**< Ring file descriptor. */
+    int nonblocking;                /**< Return 0 rather than wait. */
+    int timestamps;                 /**< Enable SO_TIMESTAMPNS on sockets. */
+    void *sq_ring;                  /**< Submission ring mapping. */
+    void *cq_ring;                  /**< Completion ring mapping. */
+    size_t sq_ring_size;            /**< Submission ring mapping size. */
+    size_t cq_ring_size;            /**< Completion ring mapping size. */
+    unsigned *sq_head;              /**< Kernel submission head. */
+    unsigned *sq_tail;              /**< Shared submission tail. */
+    unsigned sq_mask;               /**< Submission index mask. */
+    unsigned sq_entries;            /**< Submission ring size. */
+    unsigned sq_local_tail;         /**< Submission tail not yet published. */
+    struct io_uring_sqe *sqes;      /**< Submission entries. */
+    size_t sqes_size;               /**< Submission entries mapping size. */
+    unsigned *cq_head;              /**< Shared completion head. */
+    unsigned *cq_tail;              /**< Kernel completion tail. */
+    unsigned cq_mask;               /**< Completion index mask. */
+    struct io_uring_cqe *cqes;      /**< Completion entries. */
+    struct io_uring_buf_ring *buf_ring; /**< Provided buffer ring. */
+    size_t buf_ring_size;           /**< Provided buffer ring mapping size. */
+    uint16_t buf_tail;              /**< Provided buffer ring tail. */
+    uint8_t *buffers;               /**< Receive buffers. */
+    size_t buffer_count;            /**< Number of receive buffers. */
+    size_t buffer_size;             /**< Size of each buffer. */
+    uint16_t *returned;             /**< Buffers to give back to the kernel. */
+    size_t returned_count;          /**< Entries in returned. */
+    struct msghdr rx_msg;           /**< Layout for multishot receives. */
+    int *sockets;                   /**< Added sockets. */
+    size_t socket_count;            /**< Entries in sockets. */
+    size_t socket_capacity;         /**< Capacity of sockets. */
+    uint8_t *tx_buffers;            /**< Send buffers. */
+    struct msghdr *tx_msgs;         /**< Send headers, one per buffer. */
+    struct iovec *tx_iov;           /**< Send vectors, one per buffer. */
+    uint32_t *tx_free;              /**< Free send buffers. */
+    size_t tx_free_count;           /**< Entries in tx_free. */
+    rtp_transport_uring_stats stats; /**< Counters. */
+    const rtp_allocator *allocator; /**< Allocator. */
+};
+
+/**
+ * @brief Enter the kernel to submit queued entries and reap completions.
+ * @private
+ */
+static int uring_enter(rtp_transport_uring *t, unsigned wait, unsigned flags)
+{
+    __atomic_store_n(t->sq_tail, t->sq_local_tail, __ATOMIC_RELEASE);
+    const unsigned pending = t->sq_local_tail
+        - __atomic_load_n(t->sq_head, __ATOMIC_ACQUIRE);
+
+    if(wait)
+        flags |= IORING_ENTER_GETEVENTS;
+
+    t->stats.syscalls += 1;
+    const long result = syscall(__NR_io_uring_enter,
+        t->fd, pending, wait, flags, NULL, 0);
+
+    if(result < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+        return -1;
+
+    return 0;
+}
+
+/**
+ * @brief Returns the next free submission entry, or NULL if the ring is full.
+ *
+ * Sets errno when it returns NULL, to EAGAIN if the kernel took no entries.
+ * @private
+ */
+static struct io_uring_sqe *uring_get_sqe(rtp_transport_uring *t)
+{
+    unsigned head = __atomic_load_n(t->sq_head, __ATOMIC_ACQUIRE);
+    if(t->sq_local_tail - head >= t->sq_entries) {
+        // Make room by handing the queued entries to the kernel
+        if(uring_enter(t, 0, 0) < 0)
+            return NULL;
+
+        head = __atomic_load_n(t->sq_head, __ATOMIC_ACQUIRE);
+        if(t->sq_local_tail - head >= t->sq_entries) {
+            errno = EAGAIN;
+            return NULL;
+        }
+    }
+
+    struct io_uring_sqe *sqe = &t->sqes[t->sq_local_tail & t->sq_mask];
+    t->sq_local_tail += 1;
+
+    memset(sqe, 0, sizeof(struct io_uring_sqe));
+    return sqe;
+}
+
+/**
+ * @brief Queue a multishot receive on a socket.
+ * @private
+ */
+static int uring_arm(rtp_transport_uring *t, size_t index)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(t);
+    if(!sqe)
+        return -1;
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = t->sockets[index];
+    sqe->addr = (uint64_t)(uintptr_t)&t->rx_msg;
+    sqe->len = 1;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = index;
+    return 0;
+}
+
+/**
+ * @brief Hand a receive buffer to the kernel, published by uring_recycle().
+ * @private
+ */
+static inline void uring_provide(rtp_transport_uring *t, uint16_t bid)
+{
+    const size_t mask = t->buffer_count - 1;
+    struct io_uring_buf *buf = &t->buf_ring->bufs[t->buf_tail & mask];
+
+    buf->addr = (uint64_t)(uintptr_t)(t->buffers + (bid * t->buffer_size));
+    buf->len = (uint32_t)t->buffer_size;
+    buf->bid = bid;
+    t->buf_tail += 1;
+}
+
+/**
+ * @brief Give the buffers returned by the last receive back to the kernel.
+ * @private
+ */
+static void uring_recycle(rtp_transport_uring *t)
+{
+    if(t->returned_count == 0)
+        return;
+
+    for(size_t i = 0; i < t->returned_count; ++i)
+        uring_provide(t, t->returned[i]);
+
+    __atomic_store_n(&t->buf_ring->tail, t->buf_tail, __ATOMIC_RELEASE);
+    t->returned_count = 0;
+}
+
+/**
+ * @brief Read the kernel receive time from a datagram's control messages.
+ * @private
+ */
+static void read_arrival(
+    const uint8_t *control, size_t size, struct timespec *arrival)
+{
+    memset(arrival, 0, sizeof(struct timespec));
+
+    struct msghdr hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.msg_control = (void*)control;
+    hdr.msg_controllen = size;
+
+    for(struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg;
+        cmsg = CMSG_NXTHDR(&hdr, cmsg))
+    {
+        if(cmsg->cmsg_level == SOL_SOCKET
+            && cmsg->cmsg_type == SCM_TIMESTAMPNS)
+        {
+            memcpy(arrival, CMSG_DATA(cmsg), sizeof(struct timespec));
+        }
+    }
+}
+
+/**
+ * @brief Consume completions until out is full.
+ *
+ * Send completions are always consumed. Reaping stops at the first receive
+ * completion that does not fit in out.
+ *
+ * @private
+ */
+static size_t uring_reap(
+    rtp_transport_uring *t, rtp_transport_uring_packet *out, size_t n)
+{
+    unsigned head = *t->cq_head;
+    const unsigned tail = __atomic_load_n(t->cq_tail, __ATOMIC_ACQUIRE);
+    const size_t name_size = t->rx_msg.msg_namelen;
+    const size_t control_size = t->rx_msg.msg_controllen;
+
+    size_t valid = 0;
+    while(head != tail) {
+        const struct io_uring_cqe *cqe = &t->cqes[head & t->cq_mask];
+
+        if(cqe->user_data & TX_TAG) {
+            t->tx_free[t->tx_free_count++] = (uint32_t)cqe->user_data;
+            if(cqe->res < 0)
+                t->stats.tx_errors += 1;
+            else
+                t->stats.tx_packets += 1;
+
+            head += 1;
+            continue;
+        }
+
+        if(valid >= n)
+            break;
+
+        head += 1;
+
+        // Multishot receives stop when the buffers run out, restart them
+        const size_t index = (size_t)cqe->user_data;
+        if(!(cqe->flags & IORING_CQE_F_MORE)
+            && (cqe->res >= 0 || cqe->res == -ENOBUFS))
+        {
+            if(uring_arm(t, index) == 0)
+                t->stats.rx_rearmed += 1;
+        }
+
+        if(cqe->res < 0 || !(cqe->flags & IORING_CQE_F_BUFFER))
+            continue;
+
+        const uint16_t bid = (uint16_t)(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
+        t->returned[t->returned_count++] = bid;
+        t->stats.rx_packets += 1;
+
+        // Result header, then the sender address, then the payload
+        const uint8_t *buffer = t->buffers + (bid * t->buffer_size);
+        struct io_uring_recvmsg_out msg;
+        memcpy(&msg, buffer, sizeof(msg));
+
+        if(msg.flags & MSG_TRUNC) {
+            t->stats.rx_truncated += 1;
+            continue;
+        }
+
+        // The kernel reserves the full name and control space we asked for
+        const uint8_t *name = buffer + sizeof(msg);
+        const uint8_t *control = name + name_size;
+        const uint8_t *payload = control + control_size;
+
+        rtp_transport_uring_packet *packet = &out[valid];
+        if(rtp_packet_view_parse(&packet->view, payload, msg.payloadlen) != 0) {
+            t->stats.rx_invalid += 1;
+            continue;
+        }
+
+        const size_t name_len = (msg.namelen < name_size)
+            ? msg.namelen : name_size;
+
+        memcpy(&packet->from, name, name_len);
+        packet->from_len = (socklen_t)name_len;
+        packet->socket = (int)index;
+        read_arrival(control, msg.controllen, &packet->arrival);
+        valid += 1;
+    }
+
+    __atomic_store_n(t->cq_head, head, __ATOMIC_RELEASE);
+    return valid;
+}
+
+/**
+ * @brief Create the ring and map its queues.
+ * @private
+ */
+static int uring_setup(rtp_transport_uring *t, size_t entries)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+
+    // Size the completion queue for every buffer plus every send
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SUBMIT_ALL
+        | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = (unsigned)(t->buffer_count + entries);
+
+    t->fd = (int)syscall(__NR_io_uring_setup, (unsigned)entries, &params);
+    if(t->fd < 0 && errno == EINVAL) {
+        // Kernels before 6.1 lack the single issuer flags
+        memset(&params, 0, sizeof(params));
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = (unsigned)(t->buffer_count + entries);
+        t->fd = (int)syscall(__NR_io_uring_setup, (unsigned)entries, &params);
+    }
+
+    if(t->fd < 0)
+        return -1;
+
+    t->sq_ring_size = params.sq_off.array
+        + params.sq_entries * sizeof(unsigned);
+
+    t->cq_ring_size = params.cq_off.cqes
+        + params.cq_entries * sizeof(struct io_uring_cqe);
+
+    const int single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if(single) {
+        if(t->cq_ring_size > t->sq_ring_size)
+            t->sq_ring_size = t->cq_ring_size;
+
+        t->cq_ring_size = t->sq_ring_size;
+    }
+
+    t->sq_ring = mmap(NULL, t->sq_ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, t->fd, IORING_OFF_SQ_RING);
+
+    if(t->sq_ring == MAP_FAILED) {
+        t->sq_ring = NULL;
+        return -1;
+    }
+
+    if(single) {
+        t->cq_ring = t->sq_ring;
+    }
+    else {
+        t->cq_ring = mmap(NULL, t->cq_ring_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, t->fd, IORING_OFF_CQ_RING);
+
+        if(t->cq_ring == MAP_FAILED) {
+            t->cq_ring = NULL;
+            return -1;
+        }
+    }
+
+    t->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    t->sqes = (struct io_uring_sqe*)mmap(NULL, t->sqes_size,
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+        t->fd, IORING_OFF_SQES);
+
+    if(t->sqes == MAP_FAILED) {
+        t->sqes = NULL;
+        return -1;
+    }
+
+    uint8_t *sq = (uint8_t*)t->sq_ring;
+    t->sq_head = (unsigned*)(sq + params.sq_off.head);
+    t->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    t->sq_mask = *(unsigned*)(sq + params.sq_off.ring_mask);
+    t->sq_entries = params.sq_entries;
+    t->sq_local_tail = *t->sq_tail;
+
+    // Submission slots map one-to-one onto entries
+    unsigned *array = (unsigned*)(sq + params.sq_off.array);
+    for(unsigned i = 0; i < params.sq_entries; ++i)
+        array[i] = i;
+
+    uint8_t *cq = (uint8_t*)t->cq_ring;
+    t->cq_head = (unsigned*)(cq + params.cq_off.head);
+    t->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    t->cq_mask = *(unsigned*)(cq + params.cq_off.ring_mask);
+    t->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    return 0;
+}
+
+/**
+ * @brief Register the provided buffer ring and fill it.
+ * @private
+ */
+static int uring_setup_buffers(rtp_transport_uring *t)
+{
+    t->buf_ring_size = t->buffer_count * sizeof(struct io_uring_buf);
+    t->buf_ring = (struct io_uring_buf_ring*)mmap(NULL, t->buf_ring_size,
+        PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if(t->buf_ring == MAP_FAILED) {
+        t->buf_ring = NULL;
+        return -1;
+    }
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (uint64_t)(uintptr_t)t->buf_ring;
+    reg.ring_entries = (uint32_t)t->buffer_count;
+    reg.bgid = BUFFER_GROUP;
+
+    if(syscall(__NR_io_uring_register,
+        t->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        return -1;
+    }
+
+    for(size_t i = 0; i < t->buffer_count; ++i)
+        uring_provide(t, (uint16_t)i);
+
+    __atomic_store_n(&t->buf_ring->tail, t->buf_tail, __ATOMIC_RELEASE);
+    return 0;
+}
+
+rtp_transport_uring *rtp_transport_uring_create(
+    const rtp_transport_uring_config *config)
+{
+    rtp_transport_uring_config defaults;
+    memset(&defaults, 0, sizeof(defaults));
+    if(config)
+        defaults = *config;
+
+    const size_t entries = (defaults.entries)
+        ? defaults.entries : LIBRTP_URING_ENTRIES;
+
+    const size_t buffers = (defaults.buffers)
+        ? defaults.buffers : LIBRTP_URING_BUFFERS;
+
+    const size_t buffer_size = (defaults.buffer_size)
+        ? defaults.buffer_size : LIBRTP_URING_BUFFER_SIZE;
+
+    // Buffer ids are 16 bits and the ring size must be a power of two
+    if(entries > 32768 || buffers > 32768 || (buffers & (buffers - 1))
+        || buffer_size > UINT32_MAX)
+    {
+        return NULL;
+    }
+
+    const rtp_allocator *allocator = rtp_allocator_or_default(
+        defaults.allocator);
+
+    rtp_transport_uring *t = (rtp_transport_uring*)rtp_malloc(
+        allocator, sizeof(rtp_transport_uring));
+
+    if(!t)
+        return NULL;
+
+    memset(t, 0, sizeof(rtp_transport_uring));
+    t->fd = -1;
+    t->nonblocking = defaults.nonblocking;
+    t->buffer_count = buffers;
+    t->buffer_size = buffer_size;
+    t->allocator = allocator;
+
+    // Every received datagram is preceded by its sender address
+    t->rx_msg.msg_namelen = sizeof(struct sockaddr_storage);
+    t->timestamps = defaults.timestamps;
+    if(t->timestamps)
+        t->rx_msg.msg_controllen = CMSG_SPACE(sizeof(struct timespec));
+
+    t->buffers = (uint8_t*)rtp_calloc(allocator, buffers, buffer_size);
+    t->returned = (uint16_t*)rtp_calloc(allocator, buffers, sizeof(uint16_t));
+    t->tx_buffers = (uint8_t*)rtp_calloc(allocator, entries, buffer_size);
+    t->tx_msgs = (struct msghdr*)rtp_calloc(
+        allocator, entries, sizeof(struct msghdr));
+    t->tx_iov = (struct iovec*)rtp_calloc(
+        allocator, entries, sizeof(struct iovec));
+    t->tx_free = (uint32_t*)rtp_calloc(allocator, entries, sizeof(uint32_t));
+
+    if(!t->buffers || !t->returned || !t->tx_buffers || !t->tx_msgs
+        || !t->tx_iov || !t->tx_free)
+    {
+        rtp_transport_uring_free(t);
+        return NULL;
+    }
+
+    for(size_t i = 0; i < entries; ++i) {
+        t->tx_iov[i].iov_base = t->tx_buffers + (i * buffer_size);
+        t->tx_msgs[i].msg_iov = &t->tx_iov[i];
+        t->tx_msgs[i].msg_iovlen = 1;
+        t->tx_free[i] = (uint32_t)(entries - i - 1);
+    }
+    t->tx_free_count = entries;
+
+    if(uring_setup(t, entries) < 0 || uring_setup_buffers(t) < 0) {
+        rtp_transport_uring_free(t);
+        return NULL;
+    }
+
+    return t;
+}
+
+void rtp_transport_uring_free(rtp_transport_uring *t)
+{
+    assert(t != NULL);
+
+    // Closing the ring cancels the outstanding receives
+    if(t->fd >= 0)
+        close(t->fd);
+
+    if(t->sqes)
+        munmap(t->sqes, t->sqes_size);
+
+    if(t->cq_ring && t->cq_ring != t->sq_ring)
+        munmap(t->cq_ring, t->cq_ring_size);
+
+    if(t->sq_ring)
+        munmap(t->sq_ring, t->sq_ring_size);
+
+    if(t->buf_ring)
+        munmap(t->buf_ring, t->buf_ring_size);
+
+    rtp_free(t->allocator, t->buffers);
+    rtp_free(t->allocator, t->returned);
+    rtp_free(t->allocator, t->sockets);
+    rtp_free(t->allocator, t->tx_buffers);
+    rtp_free(t->allocator, t->tx_msgs);
+    rtp_free(t->allocator, t->tx_iov);
+    rtp_free(t->allocator, t->tx_free);
+    rtp_free(t->allocator, t);
+}
+
+int rtp_transport_uring_add(rtp_transport_uring *t, int fd)
+{
+    assert(t != NULL);
+
+    if(fd < 0 || t->socket_count >= TX_TAG) {
+        errno = EBADF;
+        return -1;
+    }
+
+    if(t->socket_count == t->socket_capacity) {
+        const size_t capacity = (t->socket_capacity)
+            ? 2 * t->socket_capacity : 16;
+
+        int *sockets = (int*)rtp_realloc(
+            t->allocator, t->sockets, capacity * sizeof(int));
+
+        if(!sockets)
+            return -1;
+
+        t->sockets = sockets;
+        t->socket_capacity = capacity;
+    }
+
+    if(t->timestamps) {
+        const int on = 1;
+        if(setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) < 0)
+            return -1;
+    }
+
+    const size_t index = t->socket_count;
+    t->sockets[index] = fd;
+
+    if(uring_arm(t, index) < 0)
+        return -1;
+
+    t->socket_count += 1;
+    return (int)index;
+}
+
+int rtp_transport_uring_recv(
+    rtp_transport_uring *t, rtp_transport_uring_packet *out, size_t n)
+{
+    assert(t != NULL);
+    assert(out != NULL);
+
+    uring_recycle(t);
+    if(n == 0)
+        return 0;
+
+    for(;;) {
+        const unsigned ready = __atomic_load_n(t->cq_tail, __ATOMIC_ACQUIRE)
+            - *t->cq_head;
+
+        // One system call submits the queued sends and collects completions
+        const int pending = (t->sq_local_tail
+            != __atomic_load_n(t->sq_head, __ATOMIC_ACQUIRE));
+
+        if(pending || ready == 0) {
+            const unsigned wait = (ready == 0 && !t->nonblocking);
+            if(uring_enter(t, wait, IORING_ENTER_GETEVENTS) < 0)
+                return -1;
+        }
+
+        const size_t valid = uring_reap(t, out, n);
+        if(valid > 0 || t->nonblocking)
+            return (int)valid;
+    }
+}
+
+int rtp_transport_uring_send(
+    rtp_transport_uring *t,
+    int socket,
+    const struct iovec *datagrams,
+    size_t n)
+{
+    assert(t != NULL);
+    assert(datagrams != NULL || n == 0);
+
+    if(socket < 0 || (size_t)socket >= t->socket_count) {
+        errno = EBADF;
+        return -1;
+    }
+
+    size_t queued = 0;
+    while(queued < n) {
+        const struct iovec *datagram = &datagrams[queued];
+        if(datagram->iov_len > t->buffer_size) {
+            errno = EMSGSIZE;
+            break;
+        }
+
+        if(t->tx_free_count == 0) {
+            // Collect finished sends, stopping at unread receives
+            uring_enter(t, 0, IORING_ENTER_GETEVENTS);
+            uring_reap(t, NULL, 0);
+
+            if(t->tx_free_count == 0) {
+                errno = EAGAIN;
+                break;
+            }
+        }
+
+        struct io_uring_sqe *sqe = uring_get_sqe(t);
+        if(!sqe)
+            break;
+
+        const uint32_t slot = t->tx_free[--t->tx_free_count];
+        memcpy(t->tx_iov[slot].iov_base, datagram->iov_base, datagram->iov_len);
+        t->tx_iov[slot].iov_len = datagram->iov_len;
+
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = t->sockets[socket];
+        sqe->addr = (uint64_t)(uintptr_t)&t->tx_msgs[slot];
+        sqe->len = 1;
+        sqe->user_data = TX_TAG | slot;
+        queued += 1;
+    }
+
+    if(queued == 0 && n > 0)
+        return -1;
+
+    return (int)queued;
+}
+
+int rtp_transport_uring_submit(rtp_transport_uring *t)
+{
+    assert(t != NULL);
+
+    if(t->sq_local_tail == __atomic_load_n(t->sq_head, __ATOMIC_ACQUIRE))
+        return 0;
+
+    return uring_enter(t, 0, 0);
+}
+
+void rtp_transport_uring_get_stats(
+    const rtp_transport_uring *t, rtp_transport_uring_stats *stats)
+{
+    assert(t != NULL);
+    assert(stats != NULL);
+
+    *stats = t->stats;
+}
@@ -3,17 +3,37 @@
  * @brief Utility helper functions.
  * @author Wilkins White
  * @copyright 2022 Daxbot
+ *
+ * These are defined inline so that the byte-order conversions in the packet
+ * parsers and serializers compile down to single loads and stores.
  */
 
 #ifndef LIBRTP_UTIL_H_
 #define LIBRTP_UTIL_H_
 
 #include <stdint.h>
+#include <string.h>
 
 #if defined(__cplusplus)
 extern "C" {
 #endif // __cplusplus
 
+/**
+ * @brief Thread-local storage class.
+ * @private
+ */
+#if defined(_MSC_VER)
+#define LIBRTP_THREAD_LOCAL __declspec(thread)
+#else
+#define LIBRTP_THREAD_LOCAL __thread
+#endif
+
+/**
+ * @brief Assumed size of a CPU cache line in bytes.
+ * @private
+ */
+#define LIBRTP_CACHE_LINE (64)
+
 /**
  * @brief Write a 24-bit value to a buffer (big-endian).
  *
@@ -21,7 +41,12 @@ extern "C" {
  * @param [in] value - value to write.
  * @private
  */
-void write_u24(uint8_t *buffer, uint32_t value);
+static inline void write_u24(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (uint8_t)((value >> 16) & 0xff);
+    buffer[1] = (uint8_t)((value >> 8) & 0xff);
+    buffer[2] = (uint8_t)((value >> 0) & 0xff);
+}
 
 /**
  * @brief Write a signed 24-bit value to a buffer (big endian).
@@ -30,7 +55,12 @@ void write_u24(uint8_t *buffer, uint32_t value);
  * @param [in] value - value to write.
  * @private
  */
-void write_s24(uint8_t *buffer, int32_t value);
+static inline void write_s24(uint8_t *buffer, int32_t value)
+{
+    uint32_t u;
+    memcpy(&u, &value, 4);
+    write_u24(buffer, u);
+}
 
 /**
  * @brief Write a 32-bit value to a buffer (big-endian).
@@ -39,7 +69,13 @@ void write_s24(uint8_t *buffer, int32_t value);
  * @param [in] value - value to write.
  * @private
  */
-void write_u32(uint8_t *buffer, uint32_t value);
+static inline void write_u32(uint8_t *buffer, uint32_t value)
+{
+    buffer[0] = (uint8_t)((value >> 24) & 0xff);
+    buffer[1] = (uint8_t)((value >> 16) & 0xff);
+    buffer[2] = (uint8_t)((value >> 8) & 0xff);
+    buffer[3] = (uint8_t)((value >> 0) & 0xff);
+}
 
 /**
  * @brief Read a 24-bit value from a buffer (big-endian).
@@ -48,7 +84,12 @@ void write_u32(uint8_t *buffer, uint32_t value);
  * @return uint32_t - value read.
  * @private
  */
-uint32_t read_u24(const uint8_t *buffer);
+static inline uint32_t read_u24(const uint8_t *buffer)
+{
+    return ((uint32_t)buffer[0] << 16)
+         | ((uint32_t)buffer[1] << 8)
+         | ((uint32_t)buffer[2] << 0);
+}
 
 /**
  * @brief Read a signed 24-bit value from a buffer (big-endian).
@@ -57,7 +98,15 @@ uint32_t read_u24(const uint8_t *buffer);
  * @return int32_t - value read.
  * @private
  */
-int32_t read_s24(const uint8_t *buffer);
+static inline int32_t read_s24(const uint8_t *buffer)
+{
+    // Read in the two's complement representation
+    const uint32_t u = read_u24(buffer);
+    if(u < 0x800000)
+        return (int32_t)u;
+
+    return -1 * (int32_t)(((~u) & 0xffffff) + 1);
+}
 
 /**
  * @brief Read a 32-bit value from a buffer (big-endian).
@@ -66,7 +115,13 @@ int32_t read_s24(const uint8_t *buffer);
  * @return uint32_t - value read.
  * @private
  */
-uint32_t read_u32(const uint8_t *buffer);
+static inline uint32_t read_u32(const uint8_t *buffer)
+{
+    return ((uint32_t)buffer[0] << 24)
+         | ((uint32_t)buffer[1] << 16)
+         | ((uint32_t)buffer[2] << 8)
+         | ((uint32_t)buffer[3] << 0);
+}
 
 /**
  * @brief Write a 16-bit value to a buffer (big-endian).
@@ -75,7 +130,11 @@ uint32_t read_u32(const uint8_t *buffer);
  * @param [in] value - value to write.
  * @private
  */
-void write_u16(uint8_t *buffer, uint16_t value);
+static inline void write_u16(uint8_t *buffer, uint16_t value)
+{
+    buffer[0] = (uint8_t)((value >> 8) & 0xff);
+    buffer[1] = (uint8_t)(value & 0xff);
+}
 
 /**
  * @brief Read a 16-bit value from a buffer (big-endian).
@@ -84,7 +143,10 @@ void write_u16(uint8_t *buffer, uint16_t value);
  * @return uint16_t - value read.
  * @private
  */
-uint16_t read_u16(const uint8_t *buffer);
+static inline uint16_t read_u16(const uint8_t *buffer)
+{
+    return (uint16_t)(((uint16_t)buffer[0] << 8) | buffer[1]);
+}
 
 #if defined(__cplusplus)
 }
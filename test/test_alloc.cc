@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "rtp_alloc.h"
+#include "rtp_packet.h"
+#include "rtcp_sdes.h"
+#include "rtcp_rr.h"
+
+struct counter {
+    int allocs;
+    int frees;
+};
+
+static void *count_alloc(void *ctx, size_t size)
+{
+    ((counter*)ctx)->allocs += 1;
+    return malloc(size);
+}
+
+static void *count_resize(void *ctx, void *ptr, size_t size)
+{
+    if(!ptr)
+        ((counter*)ctx)->allocs += 1;
+
+    return realloc(ptr, size);
+}
+
+static void count_release(void *ctx, void *ptr)
+{
+    if(ptr)
+        ((counter*)ctx)->frees += 1;
+
+    free(ptr);
+}
+
+TEST(Alloc, Global) {
+    counter count = { 0, 0 };
+    const rtp_allocator allocator = {
+        count_alloc, count_resize, count_release, &count };
+
+    const rtp_allocator *prev = rtp_get_allocator();
+    rtp_set_allocator(&allocator);
+    EXPECT_EQ(rtp_get_allocator(), &allocator);
+
+    rtp_packet *packet = rtp_packet_create();
+    ASSERT_NE(packet, nullptr);
+
+    rtp_packet_init(packet, 96, 0xdeadbeef, 1, 2);
+    EXPECT_EQ(rtp_header_add_csrc(packet->header, 1), 0);
+    EXPECT_EQ(rtp_header_add_csrc(packet->header, 2), 0);
+
+    const uint8_t payload[4] = { 1, 2, 3, 4 };
+    EXPECT_EQ(rtp_packet_set_payload(packet, payload, sizeof(payload)), 0);
+
+    // Existing objects keep the allocator they were created with
+    rtp_set_allocator(prev);
+    EXPECT_EQ(rtp_get_allocator(), prev);
+
+    rtp_packet_free(packet);
+    EXPECT_EQ(count.allocs, 3); // packet, header, payload
+    EXPECT_EQ(count.frees, count.allocs);
+
+    // NULL restores the default allocator
+    rtp_set_allocator(NULL);
+    EXPECT_NE(rtp_get_allocator(), &allocator);
+}
+
+TEST(Alloc, Object) {
+    counter count = { 0, 0 };
+    const rtp_allocator allocator = {
+        count_alloc, count_resize, count_release, &count };
+
+    rtcp_sdes *packet = rtcp_sdes_create_with_allocator(&allocator);
+    ASSERT_NE(packet, nullptr);
+
+    rtcp_sdes_init(packet);
+    EXPECT_EQ(rtcp_sdes_add_entry(packet, 0xdeadbeef), 0);
+    EXPECT_EQ(rtcp_sdes_add_entry(packet, 0xfeedface), 0);
+    EXPECT_EQ(rtcp_sdes_set_item(
+        packet, 0xdeadbeef, RTCP_SDES_CNAME, "user@example.com"), 0);
+
+    EXPECT_EQ(rtcp_sdes_set_item(
+        packet, 0xdeadbeef, RTCP_SDES_NAME, "User"), 0);
+
+    rtcp_sdes_clear_item(packet, 0xdeadbeef, RTCP_SDES_CNAME);
+    rtcp_sdes_remove_entry(packet, 0xdeadbeef);
+    EXPECT_EQ(packet->header.common.count, 1);
+    EXPECT_EQ(packet->srcs[0].id, 0xfeedface);
+
+    rtcp_sdes_free(packet);
+    EXPECT_GT(count.allocs, 0);
+    EXPECT_EQ(count.frees, count.allocs);
+}
+
+TEST(Alloc, Arena) {
+    alignas(16) uint8_t buffer[256];
+
+    rtp_arena arena;
+    rtp_arena_init(&arena, buffer, sizeof(buffer));
+
+    const rtp_allocator *a = &arena.allocator;
+
+    void *p1 = a->alloc(a->ctx, 10);
+    ASSERT_NE(p1, nullptr);
+    EXPECT_EQ((uintptr_t)p1 % 16, 0);
+
+    // The most recent block grows in place
+    void *p2 = a->alloc(a->ctx, 8);
+    ASSERT_NE(p2, nullptr);
+    EXPECT_EQ((uintptr_t)p2 % 16, 0);
+    EXPECT_EQ(a->resize(a->ctx, p2, 40), p2);
+
+    // Older blocks move when they grow
+    memset(p1, 0xab, 10);
+    void *p3 = a->resize(a->ctx, p1, 20);
+    ASSERT_NE(p3, nullptr);
+    EXPECT_NE(p3, p1);
+    EXPECT_EQ(((uint8_t*)p3)[9], 0xab);
+
+    // Releasing the most recent block gives its space back
+    const size_t used = arena.used;
+    void *p4 = a->alloc(a->ctx, 16);
+    ASSERT_NE(p4, nullptr);
+    a->release(a->ctx, p4);
+    EXPECT_EQ(arena.used, used);
+
+    // Exhaustion fails cleanly
+    EXPECT_EQ(a->alloc(a->ctx, 1024), nullptr);
+
+    // Sizes near SIZE_MAX must not wrap the bounds check
+    const size_t before = arena.used;
+    EXPECT_EQ(a->alloc(a->ctx, SIZE_MAX - 20), nullptr);
+    EXPECT_EQ(a->resize(a->ctx, p3, SIZE_MAX - 20), nullptr);
+    EXPECT_EQ(arena.used, before);
+
+    const size_t high_water = arena.high_water;
+    rtp_arena_reset(&arena);
+    EXPECT_EQ(arena.used, 0);
+    EXPECT_EQ(arena.high_water, high_water);
+    EXPECT_EQ(a->alloc(a->ctx, 10), p1);
+}
+
+TEST(Alloc, ArenaInterval) {
+    alignas(16) uint8_t buffer[4096];
+
+    rtp_arena arena;
+    rtp_arena_init(&arena, buffer, sizeof(buffer));
+
+    // Build and discard a report every interval without touching the heap
+    for(int interval = 0; interval < 4; ++interval) {
+        rtcp_rr *packet = rtcp_rr_create_with_allocator(&arena.allocator);
+        ASSERT_NE(packet, nullptr);
+        EXPECT_GE((uint8_t*)packet, buffer);
+        EXPECT_LT((uint8_t*)packet, buffer + sizeof(buffer));
+
+        rtcp_rr_init(packet);
+        for(uint32_t i = 0; i < 8; ++i) {
+            rtcp_report report = {};
+            report.ssrc = i;
+            EXPECT_EQ(rtcp_rr_add_report(packet, &report), 0);
+        }
+
+        rtcp_rr_remove_report(packet, 3);
+        EXPECT_EQ(packet->header.common.count, 7);
+        EXPECT_EQ(packet->reports[3].ssrc, 4);
+        EXPECT_EQ(packet->reports[6].ssrc, 7);
+
+        rtp_arena_reset(&arena);
+        EXPECT_EQ(arena.used, 0);
+    }
+}
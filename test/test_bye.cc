@@ -126,11 +126,16 @@ TEST(ByePacket, Serialize) {
 
     const int size = rtcp_bye_size(packet);
     uint8_t *buffer = new uint8_t[size];
+    memset(buffer, 0xff, size);
 
     EXPECT_DEATH(rtcp_bye_serialize(nullptr, buffer, size), "");
     EXPECT_DEATH(rtcp_bye_serialize(packet, nullptr, 0), "");
     EXPECT_EQ(rtcp_bye_serialize(packet, buffer, size), size);
 
+    // The reason is padded with zeros
+    for(int i = 4 + 1 + (int)strlen(message); i < size; ++i)
+        EXPECT_EQ(buffer[i], 0);
+
     rtcp_bye_free(packet);
     delete[] buffer;
 }
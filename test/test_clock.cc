@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <random>
+
+#include "rtp_clock.h"
+#include "rtp_source.h"
+
+using namespace std::chrono;
+
+TEST(Clock, Now) {
+    rtp_clock c;
+    rtp_clock_init(&c);
+
+    uint64_t last = rtp_clock_now(&c);
+    for(int i = 0; i < 1000; ++i) {
+        const uint64_t now = rtp_clock_now(&c);
+        ASSERT_GE(now, last);
+        last = now;
+    }
+
+    // The anchor maps monotonic reads onto the wallclock
+    const double unix_now =
+        duration<double>(system_clock::now().time_since_epoch()).count();
+    const ntp_tv ntp = ntp64_to_tv(rtp_clock_ntp(&c, rtp_clock_now(&c)));
+    EXPECT_NEAR(ntp_to_unix(ntp), unix_now, 0.01);
+
+    // Earlier than the anchor
+    EXPECT_EQ(rtp_clock_ntp(&c, c.mono - 1500000000u),
+        c.ntp - ((1ull << 32) | 0x80000000u));
+
+    rtp_clock_sync(&c);
+    EXPECT_GE(rtp_clock_now(&c), last);
+
+    EXPECT_DEATH(rtp_clock_now(nullptr), "");
+}
+
+TEST(Clock, Rate) {
+    const uint32_t rates[] = { 8000, 16000, 44100, 48000, 90000 };
+    std::mt19937_64 rng(1234);
+
+    for(uint32_t rate : rates) {
+        rtp_clock_rate r;
+        rtp_clock_rate_init(&r, rate);
+        EXPECT_EQ(r.clock_rate, rate);
+
+        // Exact up to 18 s
+        for(int i = 0; i < 10000; ++i) {
+            const uint64_t ns = rng() % 18000000000ull;
+            struct timespec ts;
+            ts.tv_sec = (time_t)(ns / 1000000000u);
+            ts.tv_nsec = (long)(ns % 1000000000u);
+            ASSERT_EQ(rtp_clock_to_rtp(&r, ns), rtp_timespec_to_rtp(&ts, rate));
+        }
+
+        // Within a tick for any uptime
+        for(int i = 0; i < 10000; ++i) {
+            const uint64_t ns = rng() >> 1;
+            struct timespec ts;
+            ts.tv_sec = (time_t)(ns / 1000000000u);
+            ts.tv_nsec = (long)(ns % 1000000000u);
+            const uint32_t d = rtp_clock_to_rtp(&r, ns)
+                - rtp_timespec_to_rtp(&ts, rate);
+            ASSERT_LE(d, 1u);
+        }
+
+        // Whole seconds are exact
+        EXPECT_EQ(rtp_clock_to_rtp(&r, 1000000000u), rate);
+        EXPECT_EQ(rtp_clock_to_rtp(&r, 3600000000000ull), rate * 3600);
+    }
+}
+
+#if LIBRTP_CLOCK_TSC
+#include <thread>
+
+TEST(Clock, Tsc) {
+    rtp_clock c;
+    rtp_clock_init(&c);
+    EXPECT_EQ(c.tsc_mult, 0u);
+
+    std::this_thread::sleep_for(milliseconds(20));
+    rtp_clock_sync(&c);
+
+    // Calibrated reads track CLOCK_MONOTONIC
+    std::this_thread::sleep_for(milliseconds(20));
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    const uint64_t mono = (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+    const uint64_t now = rtp_clock_now(&c);
+    EXPECT_NEAR((double)now, (double)mono, 1e6);
+}
+#endif
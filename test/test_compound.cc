@@ -0,0 +1,384 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+
+#include "rtcp_compound.h"
+#include "rtcp_app.h"
+#include "rtcp_bye.h"
+#include "rtcp_rr.h"
+#include "rtcp_sdes.h"
+#include "rtcp_sr.h"
+
+static rtcp_sr *make_sr()
+{
+    rtcp_sr *sr = rtcp_sr_create();
+    rtcp_sr_init(sr);
+    sr->ssrc = 0x1234;
+    sr->ntp_sec = 1;
+    sr->ntp_frac = 2;
+    sr->rtp_ts = 3;
+    sr->pkt_count = 4;
+    sr->byte_count = 5;
+
+    rtcp_report report;
+    memset(&report, 0, sizeof(report));
+    report.ssrc = 0x5678;
+    report.fraction = 12;
+    report.lost = -3;
+    report.last_seq = 100;
+    report.jitter = 7;
+    rtcp_sr_add_report(sr, &report);
+    return sr;
+}
+
+static rtcp_sdes *make_sdes()
+{
+    rtcp_sdes *sdes = rtcp_sdes_create();
+    rtcp_sdes_init(sdes);
+    rtcp_sdes_add_entry(sdes, 0x1234);
+    rtcp_sdes_set_item(sdes, 0x1234, RTCP_SDES_CNAME, "user@host");
+    rtcp_sdes_set_item(sdes, 0x1234, RTCP_SDES_NAME, "User");
+    rtcp_sdes_add_entry(sdes, 0x9abc);
+    rtcp_sdes_set_item(sdes, 0x9abc, RTCP_SDES_CNAME, "abc");
+    return sdes;
+}
+
+static rtcp_bye *make_bye()
+{
+    rtcp_bye *bye = rtcp_bye_create();
+    rtcp_bye_init(bye);
+    rtcp_bye_add_source(bye, 0x1234);
+    rtcp_bye_add_source(bye, 0x9abc);
+    rtcp_bye_set_message(bye, "done");
+    return bye;
+}
+
+static rtcp_app *make_app()
+{
+    rtcp_app *app = rtcp_app_create();
+    rtcp_app_init(app, 3);
+    app->ssrc = 0x1234;
+    app->name = 0x54455354;
+    rtcp_app_set_data(app, "12345678", 8);
+    return app;
+}
+
+/**
+ * @brief SR with one report, SDES with two chunks, BYE and APP, serialized
+ * one packet at a time.
+ */
+static size_t build_compound(uint8_t *buffer, size_t size)
+{
+    size_t offset = 0;
+
+    rtcp_sr *sr = make_sr();
+    offset += rtcp_sr_serialize(sr, buffer + offset, size - offset);
+    rtcp_sr_free(sr);
+
+    rtcp_sdes *sdes = make_sdes();
+    offset += rtcp_sdes_serialize(sdes, buffer + offset, size - offset);
+    rtcp_sdes_free(sdes);
+
+    rtcp_bye *bye = make_bye();
+    offset += rtcp_bye_serialize(bye, buffer + offset, size - offset);
+    rtcp_bye_free(bye);
+
+    rtcp_app *app = make_app();
+    offset += rtcp_app_serialize(app, buffer + offset, size - offset);
+    rtcp_app_free(app);
+
+    return offset;
+}
+
+TEST(RtcpCompound, Iterate) {
+    uint8_t buffer[512];
+    const size_t size = build_compound(buffer, sizeof(buffer));
+
+    rtcp_compound_iter it;
+    ASSERT_EQ(rtcp_compound_iter_init(&it, buffer, size), RTCP_COMPOUND_OK);
+
+    rtcp_view view;
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.pt, RTCP_SR);
+    EXPECT_EQ(view.count, 1);
+    EXPECT_EQ(view.data, buffer);
+    EXPECT_EQ(view.body.sr.ssrc, 0x1234u);
+    EXPECT_EQ(view.body.sr.ntp_sec, 1u);
+    EXPECT_EQ(view.body.sr.ntp_frac, 2u);
+    EXPECT_EQ(view.body.sr.rtp_ts, 3u);
+    EXPECT_EQ(view.body.sr.pkt_count, 4u);
+    EXPECT_EQ(view.body.sr.byte_count, 5u);
+    EXPECT_EQ(view.body.sr.ext_data, nullptr);
+
+    rtcp_report report;
+    rtcp_view_report(&view, 0, &report);
+    EXPECT_EQ(report.ssrc, 0x5678u);
+    EXPECT_EQ(report.fraction, 12);
+    EXPECT_EQ(report.lost, -3);
+    EXPECT_EQ(report.last_seq, 100u);
+    EXPECT_EQ(report.jitter, 7u);
+    EXPECT_DEATH(rtcp_view_report(&view, 1, &report), "");
+
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.pt, RTCP_SDES);
+    EXPECT_EQ(view.count, 2);
+
+    size_t chunk_offset = 0;
+    rtcp_sdes_chunk_view chunk;
+    ASSERT_EQ(rtcp_view_next_chunk(&view, &chunk_offset, &chunk), 1);
+    EXPECT_EQ(chunk.src, 0x1234u);
+
+    size_t item_offset = 0;
+    rtcp_sdes_item_view item;
+    ASSERT_EQ(rtcp_sdes_chunk_next_item(&chunk, &item_offset, &item), 1);
+    EXPECT_EQ(item.type, RTCP_SDES_CNAME);
+    EXPECT_EQ(std::string(item.data, item.length), "user@host");
+    ASSERT_EQ(rtcp_sdes_chunk_next_item(&chunk, &item_offset, &item), 1);
+    EXPECT_EQ(item.type, RTCP_SDES_NAME);
+    EXPECT_EQ(std::string(item.data, item.length), "User");
+    EXPECT_EQ(rtcp_sdes_chunk_next_item(&chunk, &item_offset, &item), 0);
+
+    ASSERT_EQ(rtcp_view_next_chunk(&view, &chunk_offset, &chunk), 1);
+    EXPECT_EQ(chunk.src, 0x9abcu);
+    item_offset = 0;
+    ASSERT_EQ(rtcp_sdes_chunk_next_item(&chunk, &item_offset, &item), 1);
+    EXPECT_EQ(std::string(item.data, item.length), "abc");
+    EXPECT_EQ(rtcp_sdes_chunk_next_item(&chunk, &item_offset, &item), 0);
+    EXPECT_EQ(rtcp_view_next_chunk(&view, &chunk_offset, &chunk), 0);
+
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.pt, RTCP_BYE);
+    EXPECT_EQ(view.count, 2);
+    EXPECT_EQ(rtcp_view_bye_src(&view, 0), 0x1234u);
+    EXPECT_EQ(rtcp_view_bye_src(&view, 1), 0x9abcu);
+    EXPECT_EQ(std::string(view.body.bye.reason, view.body.bye.reason_length),
+        "done");
+
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.pt, RTCP_APP);
+    EXPECT_EQ(view.count, 3);
+    EXPECT_EQ(view.body.app.ssrc, 0x1234u);
+    EXPECT_EQ(view.body.app.name, 0x54455354u);
+    ASSERT_EQ(view.body.app.app_size, 8u);
+    EXPECT_EQ(memcmp(view.body.app.app_data, "12345678", 8), 0);
+    EXPECT_EQ(view.data + view.size, buffer + size);
+
+    EXPECT_EQ(rtcp_compound_iter_next(&it, &view), 0);
+    EXPECT_EQ(rtcp_compound_iter_next(&it, &view), 0);
+
+    EXPECT_DEATH(rtcp_compound_iter_init(nullptr, buffer, size), "");
+    EXPECT_DEATH(rtcp_compound_iter_next(&it, nullptr), "");
+}
+
+TEST(RtcpCompound, Padding) {
+    uint8_t buffer[512];
+    size_t size = build_compound(buffer, sizeof(buffer));
+
+    // Pad the APP packet by 8 bytes
+    const size_t last = size - 20;
+    memset(buffer + size, 0, 8);
+    buffer[size + 7] = 8;
+    buffer[last] |= 0x20;
+    buffer[last + 3] += 2;
+    size += 8;
+
+    rtcp_compound_iter it;
+    rtcp_view view;
+    ASSERT_EQ(rtcp_compound_iter_init(&it, buffer, size), RTCP_COMPOUND_OK);
+    for(int i = 0; i < 4; ++i)
+        ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+
+    EXPECT_EQ(view.pt, RTCP_APP);
+    EXPECT_EQ(view.size, 20u);
+    EXPECT_EQ(view.body.app.app_size, 8u);
+
+    // Pad count larger than the packet
+    buffer[size - 1] = 32;
+    EXPECT_EQ(rtcp_compound_iter_init(&it, buffer, size),
+        RTCP_COMPOUND_PADDING);
+
+    // Padding on a packet that is not the last
+    buffer[size - 1] = 8;
+    buffer[52] |= 0x20;
+    EXPECT_EQ(rtcp_compound_iter_init(&it, buffer, size),
+        RTCP_COMPOUND_PADDING);
+
+    buffer[52] &= ~0x20;
+    buffer[0] |= 0x20;
+    EXPECT_EQ(rtcp_compound_iter_init(&it, buffer, size),
+        RTCP_COMPOUND_PADDING);
+    EXPECT_EQ(rtcp_compound_iter_next(&it, &view), 0);
+}
+
+TEST(RtcpCompound, Invalid) {
+    uint8_t buffer[512];
+    const size_t size = build_compound(buffer, sizeof(buffer));
+
+    rtcp_compound_iter it;
+    rtcp_view view;
+
+    EXPECT_EQ(rtcp_compound_iter_init(&it, buffer, 0), RTCP_COMPOUND_SHORT);
+    EXPECT_EQ(rtcp_compound_iter_init(&it, buffer, size - 2),
+        RTCP_COMPOUND_SHORT);
+
+    // The lengths must add up to the datagram
+    EXPECT_EQ(rtcp_compound_iter_init(&it, buffer, size - 4),
+        RTCP_COMPOUND_SHORT);
+    EXPECT_EQ(rtcp_compound_iter_next(&it, &view), 0);
+
+    // SDES first
+    EXPECT_EQ(rtcp_compound_iter_init(&it, buffer + 52, size - 52),
+        RTCP_COMPOUND_FIRST);
+
+    uint8_t copy[512];
+    memcpy(copy, buffer, size);
+    copy[52] = (uint8_t)((copy[52] & 0x3f) | 0x40);
+    EXPECT_EQ(rtcp_compound_iter_init(&it, copy, size),
+        RTCP_COMPOUND_VERSION);
+
+    // More reports than the SR holds
+    memcpy(copy, buffer, size);
+    copy[0] += 1;
+    EXPECT_EQ(rtcp_compound_iter_init(&it, copy, size), RTCP_COMPOUND_FORMAT);
+
+    // SDES item running past its packet
+    memcpy(copy, buffer, size);
+    copy[52 + 9] = 200;
+    EXPECT_EQ(rtcp_compound_iter_init(&it, copy, size), RTCP_COMPOUND_FORMAT);
+
+    // Unknown packet types are passed through
+    memcpy(copy, buffer, size);
+    copy[53] = 207;
+    ASSERT_EQ(rtcp_compound_iter_init(&it, copy, size), RTCP_COMPOUND_OK);
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.pt, 207);
+    EXPECT_EQ(view.data, copy + 52);
+}
+
+TEST(RtcpCompound, Build) {
+    uint8_t expected[512];
+    memset(expected, 0, sizeof(expected));
+    const size_t size = build_compound(expected, sizeof(expected));
+
+    rtcp_sr *sr = make_sr();
+    rtcp_sdes *sdes = make_sdes();
+    rtcp_bye *bye = make_bye();
+    rtcp_app *app = make_app();
+
+    uint8_t buffer[512];
+    memset(buffer, 0xff, sizeof(buffer));
+
+    rtcp_compound_builder b;
+    rtcp_compound_builder_init(&b, buffer, sizeof(buffer));
+    EXPECT_EQ(rtcp_compound_add_sr(&b, sr), 1);
+    EXPECT_EQ(rtcp_compound_add_sdes(&b, sdes), 40);
+    EXPECT_EQ(rtcp_compound_add_bye(&b, bye), 20);
+    EXPECT_EQ(rtcp_compound_add_app(&b, app), 20);
+
+    ASSERT_EQ(b.offset, size);
+    EXPECT_EQ(memcmp(buffer, expected, size), 0);
+
+    // Everything or nothing of a packet that does not fit
+    rtcp_compound_builder_init(&b, buffer, 80);
+    EXPECT_EQ(rtcp_compound_add_sr(&b, sr), 1);
+    EXPECT_EQ(rtcp_compound_add_bye(&b, bye), 20);
+    EXPECT_EQ(rtcp_compound_add_sdes(&b, sdes), -1);
+    EXPECT_EQ(rtcp_compound_add_app(&b, app), -1);
+    EXPECT_EQ(b.offset, 72u);
+
+    rtcp_compound_iter it;
+    EXPECT_EQ(rtcp_compound_iter_init(&it, buffer, b.offset),
+        RTCP_COMPOUND_OK);
+
+    rtcp_compound_builder_init(&b, buffer, 20);
+    EXPECT_EQ(rtcp_compound_add_sr(&b, sr), -1);
+    EXPECT_EQ(b.offset, 0u);
+
+    EXPECT_DEATH(rtcp_compound_add_sr(nullptr, sr), "");
+    EXPECT_DEATH(rtcp_compound_add_reports(&b, nullptr, 1), "");
+
+    rtcp_sr_free(sr);
+    rtcp_sdes_free(sdes);
+    rtcp_bye_free(bye);
+    rtcp_app_free(app);
+}
+
+TEST(RtcpCompound, Split) {
+    rtcp_report reports[70];
+    memset(reports, 0, sizeof(reports));
+    for(uint32_t i = 0; i < 70; ++i)
+        reports[i].ssrc = 1000 + i;
+
+    rtcp_rr *rr = rtcp_rr_create();
+    rtcp_rr_init(rr);
+    rr->ssrc = 0x1234;
+
+    uint8_t buffer[2048];
+    rtcp_compound_builder b;
+    rtcp_compound_builder_init(&b, buffer, sizeof(buffer));
+    EXPECT_EQ(rtcp_compound_add_rr(&b, rr), 0);
+    EXPECT_EQ(rtcp_compound_add_reports(&b, reports, 70), 70u);
+
+    rtcp_bye *bye = make_bye();
+    EXPECT_GT(rtcp_compound_add_bye(&b, bye), 0);
+    EXPECT_EQ(b.offset, 3 * 8 + 70 * 24 + 20u);
+
+    rtcp_compound_iter it;
+    rtcp_view view;
+    rtcp_report report;
+    ASSERT_EQ(rtcp_compound_iter_init(&it, buffer, b.offset),
+        RTCP_COMPOUND_OK);
+
+    uint32_t next = 1000;
+    const uint8_t counts[] = { 31, 31, 8 };
+    for(uint8_t count : counts) {
+        ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+        EXPECT_EQ(view.pt, RTCP_RR);
+        EXPECT_EQ(view.body.rr.ssrc, 0x1234u);
+        ASSERT_EQ(view.count, count);
+        for(uint8_t i = 0; i < count; ++i) {
+            rtcp_view_report(&view, i, &report);
+            EXPECT_EQ(report.ssrc, next++);
+        }
+    }
+
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.pt, RTCP_BYE);
+
+    // MTU of 576 bytes with room held back for the BYE
+    rtcp_compound_builder_init(&b, buffer, 576);
+    rtcp_compound_builder_reserve(&b, 20);
+    EXPECT_EQ(rtcp_compound_add_rr(&b, rr), 0);
+
+    const size_t fit = rtcp_compound_add_reports(&b, reports, 70);
+    EXPECT_EQ(fit, 22u);
+    EXPECT_EQ(rtcp_compound_add_reports(&b, reports + fit, 70 - fit), 0u);
+    EXPECT_EQ(rtcp_compound_add_bye(&b, bye), 20);
+    EXPECT_LE(b.offset, 576u);
+
+    ASSERT_EQ(rtcp_compound_iter_init(&it, buffer, b.offset),
+        RTCP_COMPOUND_OK);
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.count, 22);
+
+    // The extension stays with its packet
+    const uint32_t ext = 0xdeadbeef;
+    rtcp_rr_set_ext(rr, &ext, sizeof(ext));
+    rtcp_rr_add_report(rr, &reports[0]);
+    rtcp_compound_builder_init(&b, buffer, sizeof(buffer));
+    EXPECT_EQ(rtcp_compound_add_rr(&b, rr), 1);
+    EXPECT_EQ(rtcp_compound_add_reports(&b, reports + 1, 2), 2u);
+
+    ASSERT_EQ(rtcp_compound_iter_init(&it, buffer, b.offset),
+        RTCP_COMPOUND_OK);
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.count, 1);
+    ASSERT_EQ(view.body.rr.ext_size, 4u);
+    EXPECT_EQ(memcmp(view.body.rr.ext_data, &ext, 4), 0);
+    ASSERT_EQ(rtcp_compound_iter_next(&it, &view), 1);
+    EXPECT_EQ(view.count, 2);
+
+    rtcp_rr_free(rr);
+    rtcp_bye_free(bye);
+}
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include "rtp_decode.h"
+
+static void fill(uint8_t (*data)[16], struct iovec *iov, size_t n)
+{
+    for(size_t i = 0; i < n; ++i) {
+        for(size_t j = 0; j < 16; ++j)
+            data[i][j] = rand() & 0xff;
+
+        // Mostly valid headers
+        if(i % 3)
+            data[i][0] = (uint8_t)(0x80 | (data[i][0] & 0x3f));
+
+        iov[i].iov_base = data[i];
+        iov[i].iov_len = (i % 7 == 6) ? (rand() % 12) : 12 + (rand() % 5);
+    }
+}
+
+TEST(Decode, Scalar) {
+    uint8_t data[4][16] = {
+        { 0x80, 0xe0, 0x12, 0x34, 0x01, 0x02, 0x03, 0x04, 0xaa, 0xbb, 0xcc, 0xdd },
+        { 0x40, 0x60 },
+        { 0x80, 0x48 },
+        { 0x80, 0x60 },
+    };
+
+    struct iovec iov[4];
+    for(int i = 0; i < 4; ++i) {
+        iov[i].iov_base = data[i];
+        iov[i].iov_len = 12;
+    }
+
+    // Runt
+    iov[3].iov_len = 11;
+
+    rtp_decoder decoder = rtp_decoder_get(RTP_DECODE_SCALAR);
+    ASSERT_NE(decoder, nullptr);
+
+    rtp_fixed out[4];
+    EXPECT_EQ(decoder(iov, 4, out), 0x1);
+
+    EXPECT_EQ(out[0].b0, 0x80);
+    EXPECT_EQ(out[0].b1, 0xe0);
+    EXPECT_EQ(out[0].seq, 0x1234);
+    EXPECT_EQ(out[0].ts, 0x01020304);
+    EXPECT_EQ(out[0].ssrc, 0xaabbccdd);
+    EXPECT_EQ(out[3].b0, 0);
+}
+
+TEST(Decode, Kernels) {
+    const size_t n = LIBRTP_DECODE_MAX;
+    uint8_t (*data)[16] = new uint8_t[n][16];
+    struct iovec *iov = new struct iovec[n];
+
+    rtp_fixed expected[LIBRTP_DECODE_MAX];
+    rtp_fixed actual[LIBRTP_DECODE_MAX];
+
+    rtp_decoder scalar = rtp_decoder_get(RTP_DECODE_SCALAR);
+
+    const rtp_decode_kernel kernels[] = {
+        RTP_DECODE_SSE41, RTP_DECODE_AVX2, RTP_DECODE_NEON
+    };
+
+    for(rtp_decode_kernel kernel : kernels) {
+        rtp_decoder decoder = rtp_decoder_get(kernel);
+        if(!decoder)
+            continue;
+
+        for(int round = 0; round < 1000; ++round) {
+            fill(data, iov, n);
+
+            // Exercise the scalar tails as well as full vectors
+            const size_t count = (round % 2) ? n : 1 + (rand() % n);
+
+            const uint64_t a = scalar(iov, count, expected);
+            const uint64_t b = decoder(iov, count, actual);
+            ASSERT_EQ(a, b) << "kernel " << kernel;
+
+            for(size_t i = 0; i < count; ++i) {
+                EXPECT_EQ(expected[i].ts, actual[i].ts);
+                EXPECT_EQ(expected[i].ssrc, actual[i].ssrc);
+                EXPECT_EQ(expected[i].seq, actual[i].seq);
+                EXPECT_EQ(expected[i].b0, actual[i].b0);
+                EXPECT_EQ(expected[i].b1, actual[i].b1);
+            }
+        }
+    }
+
+    EXPECT_NE(rtp_decoder_get(rtp_decoder_best()), nullptr);
+
+    delete[] data;
+    delete[] iov;
+}
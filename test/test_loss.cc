@@ -0,0 +1,199 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "rtp_loss.h"
+#include "rtp_source.h"
+
+TEST(RtpLoss, Burst) {
+    rtp_loss *l = rtp_loss_create();
+    ASSERT_NE(l, nullptr);
+
+    // An isolated loss, a burst of 3 in 5 packets and another isolated loss,
+    // then enough to push the first 400 packets out of the window
+    for(uint32_t seq = 0; seq < 400 + LIBRTP_LOSS_WINDOW; ++seq) {
+        if(seq == 100 || seq == 102 || seq == 104 || seq == 205)
+            continue;
+
+        EXPECT_EQ(rtp_loss_update(l, seq), 0);
+    }
+
+    rtp_loss_stats stats;
+    rtp_loss_get_stats(l, &stats);
+    EXPECT_EQ(stats.received, 396u + LIBRTP_LOSS_WINDOW);
+    EXPECT_EQ(stats.lost, 4u);
+    EXPECT_EQ(stats.duplicates, 0u);
+    EXPECT_EQ(stats.reordered, 0u);
+    EXPECT_EQ(stats.bursts, 1u);
+    EXPECT_EQ(stats.burst_density, (3 * 256) / 5);
+    EXPECT_EQ(stats.burst_length, 5u);
+    EXPECT_EQ(stats.gap_density, 256 / 395);
+    EXPECT_EQ(stats.gap_length, 395u / 2);
+
+    EXPECT_DEATH(rtp_loss_update(nullptr, 0), "");
+    rtp_loss_free(l);
+}
+
+TEST(RtpLoss, Reorder) {
+    rtp_loss l;
+    rtp_loss_init(&l);
+
+    for(uint32_t seq = 0; seq < 10; ++seq)
+        EXPECT_EQ(rtp_loss_update(&l, seq), 0);
+
+    EXPECT_EQ(rtp_loss_update(&l, 12), 0);
+    EXPECT_EQ(rtp_loss_update(&l, 11), 0);
+    EXPECT_EQ(rtp_loss_update(&l, 10), 0);
+    EXPECT_EQ(rtp_loss_update(&l, 11), 1);
+    EXPECT_EQ(rtp_loss_update(&l, 12), 1);
+
+    // Older than the first packet or the window
+    EXPECT_EQ(rtp_loss_update(&l, 0xffffffff), -1);
+    const uint32_t top = 4 * LIBRTP_LOSS_WINDOW;
+    EXPECT_EQ(rtp_loss_update(&l, top), 0);
+    EXPECT_EQ(rtp_loss_update(&l, top - LIBRTP_LOSS_WINDOW), -1);
+    EXPECT_EQ(rtp_loss_update(&l, top - LIBRTP_LOSS_WINDOW + 1), 0);
+
+    rtp_loss_stats stats;
+    rtp_loss_get_stats(&l, &stats);
+    EXPECT_EQ(stats.received, 15u);
+    EXPECT_EQ(stats.duplicates, 2u);
+    EXPECT_EQ(stats.reordered, 3u);
+    EXPECT_EQ(stats.max_reorder, LIBRTP_LOSS_WINDOW - 1u);
+    EXPECT_EQ(stats.late, 2u);
+}
+
+TEST(RtpLoss, Jump) {
+    rtp_loss l;
+    rtp_loss_init(&l);
+
+    // Across the 32-bit wrap, lost packets are final as they leave the window
+    const uint32_t base = 0xffffff00u;
+    const uint32_t jump = 16 * LIBRTP_LOSS_WINDOW;
+    EXPECT_EQ(rtp_loss_update(&l, base), 0);
+    EXPECT_EQ(rtp_loss_update(&l, base + jump), 0);
+
+    rtp_loss_stats stats;
+    rtp_loss_get_stats(&l, &stats);
+    EXPECT_EQ(stats.lost, jump - LIBRTP_LOSS_WINDOW);
+    EXPECT_EQ(stats.bursts, 1u);
+
+    for(uint32_t i = 1; i <= LIBRTP_LOSS_WINDOW; ++i)
+        rtp_loss_update(&l, base + jump + i);
+
+    rtp_loss_get_stats(&l, &stats);
+    EXPECT_EQ(stats.lost, jump - 1);
+    EXPECT_EQ(stats.burst_length, jump - 1);
+    EXPECT_EQ(stats.burst_density, 255u);
+}
+
+TEST(RtpLoss, Random) {
+    std::mt19937 rng(1234);
+
+    // Random loss, duplication and reordering within the window
+    const uint32_t count = 20000;
+    std::vector<bool> sent(count, false);
+    std::vector<uint32_t> order;
+    for(uint32_t seq = 0; seq < count; ++seq) {
+        const bool burst = (seq / 500) % 2;
+        if(rng() % 100 < (burst ? 30u : 2u))
+            continue;
+
+        sent[seq] = true;
+        order.push_back(seq);
+        if(rng() % 100 == 0)
+            order.push_back(seq);
+    }
+
+    for(size_t i = 0; i + 8 < order.size(); i += 8) {
+        if(rng() % 4 == 0)
+            std::shuffle(order.begin() + i, order.begin() + i + 8, rng);
+    }
+
+    // Flush the window with packets that are all received
+    sent.resize(count + LIBRTP_LOSS_WINDOW, true);
+    for(uint32_t seq = count; seq < count + LIBRTP_LOSS_WINDOW; ++seq)
+        order.push_back(seq);
+
+    // The first packet must also be first in the window
+    sent[0] = true;
+    order.insert(order.begin(), 0);
+
+    rtp_loss l;
+    rtp_loss_init(&l);
+    uint32_t duplicates = 0;
+    for(uint32_t seq : order) {
+        if(rtp_loss_update(&l, seq) == 1)
+            duplicates += 1;
+    }
+
+    // Reference classification, one packet at a time
+    uint32_t run = 0, cluster_packets = 0, cluster_lost = 0;
+    uint32_t bursts = 0, burst_packets = 0, burst_lost = 0;
+    uint32_t gap_packets = 0, gap_lost = 0;
+    auto close = [&]() {
+        if(cluster_lost == 1) {
+            gap_packets += 1;
+            gap_lost += 1;
+        }
+        else if(cluster_lost > 1) {
+            bursts += 1;
+            burst_packets += cluster_packets;
+            burst_lost += cluster_lost;
+        }
+        cluster_packets = cluster_lost = 0;
+    };
+
+    // The flush packets are still in the window
+    for(uint32_t seq = 0; seq < count; ++seq) {
+        if(sent[seq]) {
+            run += 1;
+            continue;
+        }
+
+        if(cluster_lost == 0 || run >= LIBRTP_LOSS_GMIN) {
+            close();
+            gap_packets += run;
+            cluster_packets = 1;
+        }
+        else {
+            cluster_packets += run + 1;
+        }
+        cluster_lost += 1;
+        run = 0;
+    }
+    close();
+    gap_packets += run;
+
+    rtp_loss_stats stats;
+    rtp_loss_get_stats(&l, &stats);
+    EXPECT_EQ(stats.received,
+        (uint32_t)std::count(sent.begin(), sent.end(), true));
+    EXPECT_EQ(stats.lost, burst_lost + gap_lost);
+    EXPECT_EQ(stats.duplicates, duplicates);
+    EXPECT_EQ(stats.late, 0u);
+    EXPECT_EQ(stats.bursts, bursts);
+    EXPECT_GT(stats.bursts, 10u);
+    EXPECT_EQ(stats.burst_length, burst_packets / bursts);
+    EXPECT_EQ(stats.burst_density, (burst_lost << 8) / burst_packets);
+    EXPECT_EQ(stats.gap_length, gap_packets / (bursts + 1));
+    EXPECT_EQ(stats.gap_density, (gap_lost << 8) / gap_packets);
+}
+
+TEST(RtpLoss, ExtendedSeq) {
+    rtp_source s;
+    memset(&s, 0, sizeof(s));
+    rtp_source_init(&s, 0x1234, 65530);
+
+    for(uint16_t seq = 65530; seq != 3; ++seq)
+        rtp_source_update_seq(&s, seq);
+
+    EXPECT_EQ(s.cycles, 65536u);
+    EXPECT_EQ(rtp_source_extended_seq(&s, 2), 65538u);
+    EXPECT_EQ(rtp_source_extended_seq(&s, 0), 65536u);
+
+    // Late packet from before the wrap
+    EXPECT_EQ(rtp_source_extended_seq(&s, 65534), 65534u);
+}
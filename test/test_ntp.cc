@@ -42,4 +42,61 @@ TEST(NTP, Diff) {
 
     ntp_tv ntp = ntp_from_unix(s);
     EXPECT_DOUBLE_EQ(ntp_to_unix(ntp), s);
-}
\ No newline at end of file
+}
+
+TEST(NTP, Fixed) {
+    ntp_tv tv = { 0xdeadbeef, 0x12345678 };
+    EXPECT_EQ(ntp64_from_tv(tv), 0xdeadbeef12345678ull);
+    EXPECT_EQ(ntp64_to_tv(ntp64_from_tv(tv)).sec, tv.sec);
+    EXPECT_EQ(ntp64_to_tv(ntp64_from_tv(tv)).frac, tv.frac);
+    EXPECT_EQ(ntp64_short(ntp64_from_tv(tv)), ntp_short(tv));
+    EXPECT_EQ(ntp64_from_short(0xbeef1234), 0xbeef12340000ull);
+
+    // Ordering holds across the 2036 era rollover
+    const ntp64 before = 0xffffffff00000000ull;
+    const ntp64 after = ntp64_add(before, 2ull << 32);
+    EXPECT_EQ(after, 1ull << 32);
+    EXPECT_LT(ntp64_cmp(before, after), 0);
+    EXPECT_GT(ntp64_cmp(after, before), 0);
+    EXPECT_EQ(ntp64_cmp(after, after), 0);
+    EXPECT_EQ(ntp64_sub(after, before), 2ull << 32);
+
+    EXPECT_EQ(ntp64_from_ns(1500000000), (1ull << 32) | 0x80000000u);
+    EXPECT_EQ(ntp64_to_ns((1ull << 32) | 0x80000000u), 1500000000u);
+    // Each conversion rounds down, losing at most a nanosecond
+    for(uint64_t ns = 0; ns < 10000000000ull; ns += 999999937) {
+        const uint64_t back = ntp64_to_ns(ntp64_from_ns(ns));
+        EXPECT_LE(back, ns);
+        EXPECT_LE(ns - back, 1u);
+    }
+}
+
+TEST(NTP, Precision) {
+    // Late in the era a double keeps only ~21 fraction bits, the fixed
+    // point difference is exact
+    srand(1234);
+    for(int i = 0; i < 10000; ++i) {
+        ntp_tv a = { 0xf0000000u + (uint32_t)(rand() % 1000), (uint32_t)rand() };
+        ntp_tv b = { a.sec - (uint32_t)(rand() % 100), (uint32_t)rand() };
+        if(b.sec == a.sec && b.frac > a.frac)
+            std::swap(a.frac, b.frac);
+
+        const uint64_t expected = (((uint64_t)a.sec << 32) | a.frac)
+            - (((uint64_t)b.sec << 32) | b.frac);
+
+        ntp_tv d = ntp_diff(a, b);
+        ASSERT_EQ(((uint64_t)d.sec << 32) | d.frac, expected);
+    }
+}
+
+TEST(NTP, RoundTrip) {
+    // SR sent at 10.5s, held 1.25s by the receiver, back at 12s
+    const ntp64 sent = ntp64_from_ns(10500000000ull);
+    const uint32_t lsr = ntp64_short(sent);
+    const uint32_t dlsr = ntp64_short(ntp64_from_ns(1250000000ull));
+    const uint32_t arrival = ntp64_short(ntp64_from_ns(12000000000ull));
+
+    EXPECT_EQ(ntp_short_rtt(arrival, lsr, dlsr), 0x4000u); // 0.25s
+    EXPECT_EQ(ntp_short_rtt(arrival, 0, dlsr), 0u);
+    EXPECT_EQ(ntp_short_rtt(lsr, lsr, dlsr), 0u);
+}
@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+#include "rtp_pool.h"
+
+TEST(Pool, Create) {
+    EXPECT_EQ(rtp_pool_create(0, 1500), nullptr);
+    EXPECT_EQ(rtp_pool_create(16, 0), nullptr);
+    EXPECT_EQ(rtp_pool_create(16, SIZE_MAX), nullptr);
+    EXPECT_EQ(rtp_pool_create(16, SIZE_MAX / 8), nullptr);
+
+    rtp_pool *pool = rtp_pool_create(16, 1500);
+    EXPECT_NE(pool, nullptr);
+
+    rtp_pool_stats stats;
+    rtp_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.capacity, 16);
+    EXPECT_EQ(stats.in_use, 0);
+    EXPECT_EQ(stats.high_water, 0);
+    EXPECT_EQ(stats.exhausted, 0);
+
+    EXPECT_DEATH(rtp_pool_free(nullptr), "");
+    rtp_pool_free(pool);
+}
+
+TEST(Pool, Exhaust) {
+    rtp_pool *pool = rtp_pool_create(16, 1500);
+    EXPECT_NE(pool, nullptr);
+
+    rtp_packet *packets[16];
+    for(int i = 0; i < 16; ++i) {
+        packets[i] = rtp_pool_acquire(pool);
+        ASSERT_NE(packets[i], nullptr);
+
+        // Packets are cache line aligned and distinct
+        EXPECT_EQ((uintptr_t)packets[i] % 64, 0);
+        for(int j = 0; j < i; ++j)
+            EXPECT_NE(packets[i], packets[j]);
+    }
+
+    EXPECT_EQ(rtp_pool_acquire(pool), nullptr);
+    EXPECT_EQ(rtp_pool_acquire(pool), nullptr);
+
+    rtp_pool_stats stats;
+    rtp_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.in_use, 16);
+    EXPECT_EQ(stats.high_water, 16);
+    EXPECT_EQ(stats.exhausted, 2);
+
+    for(int i = 0; i < 16; ++i)
+        rtp_pool_release(pool, packets[i]);
+
+    rtp_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.in_use, 0);
+    EXPECT_EQ(stats.high_water, 16);
+
+    EXPECT_NE(rtp_pool_acquire(pool), nullptr);
+
+    rtp_pool_free(pool);
+}
+
+TEST(Pool, Packet) {
+    rtp_pool *pool = rtp_pool_create(4, 64);
+    EXPECT_NE(pool, nullptr);
+
+    rtp_packet *packet = rtp_pool_acquire(pool);
+    ASSERT_NE(packet, nullptr);
+    EXPECT_NE(packet->header, nullptr);
+    EXPECT_EQ(packet->payload_capacity, 64);
+
+    rtp_packet_init(packet, 96, 0x1234, 1, 2);
+    rtp_header_add_csrc(packet->header, 0x5678);
+
+    uint8_t data[128];
+    memset(data, 0xab, sizeof(data));
+    EXPECT_EQ(rtp_packet_set_payload(packet, data, sizeof(data)), -1);
+    EXPECT_EQ(rtp_packet_set_payload(packet, data, 32), 0);
+    EXPECT_EQ(rtp_packet_set_payload(packet, data, 32), -1);
+
+    uint8_t buffer[128];
+    const int size = rtp_packet_serialize(packet, buffer, sizeof(buffer));
+    EXPECT_EQ(size, 12 + 4 + 32);
+
+    // Parse into a second pooled packet
+    rtp_packet *parsed = rtp_pool_acquire(pool);
+    ASSERT_NE(parsed, nullptr);
+    EXPECT_EQ(rtp_packet_parse(parsed, buffer, size), 0);
+    EXPECT_EQ(parsed->header->ssrc, 0x1234);
+    EXPECT_EQ(parsed->payload_size, 32);
+    EXPECT_EQ(memcmp(parsed->payload_data, data, 32), 0);
+
+    rtp_packet_clear_payload(packet);
+    EXPECT_EQ(packet->payload_size, 0);
+    EXPECT_NE(packet->payload_data, nullptr);
+
+    // Released packets come back empty
+    rtp_pool_release(pool, packet);
+    rtp_pool_release(pool, parsed);
+
+    for(int i = 0; i < 4; ++i) {
+        rtp_packet *p = rtp_pool_acquire(pool);
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(p->header->cc, 0);
+        EXPECT_EQ(p->header->ssrc, 0);
+        EXPECT_EQ(p->payload_size, 0);
+    }
+
+    rtp_pool_free(pool);
+}
+
+TEST(Pool, Threads) {
+    const int capacity = 64;
+    rtp_pool *pool = rtp_pool_create(capacity, 256);
+    EXPECT_NE(pool, nullptr);
+
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t) {
+        threads.emplace_back([pool]() {
+            for(int i = 0; i < 20000; ++i) {
+                rtp_packet *packets[8];
+                int count = 0;
+                for(; count < 8; ++count) {
+                    packets[count] = rtp_pool_acquire(pool);
+                    if(!packets[count])
+                        break;
+
+                    rtp_packet_init(packets[count], 96, i, i, i);
+                }
+
+                for(int j = 0; j < count; ++j) {
+                    EXPECT_EQ(packets[j]->header->ssrc, (uint32_t)i);
+                    rtp_pool_release(pool, packets[j]);
+                }
+            }
+        });
+    }
+
+    for(auto &thread : threads)
+        thread.join();
+
+    rtp_pool_stats stats;
+    rtp_pool_get_stats(pool, &stats);
+    EXPECT_EQ(stats.in_use, 0);
+    EXPECT_LE(stats.high_water, capacity);
+
+    // Every packet is still reachable
+    for(int i = 0; i < capacity; ++i)
+        EXPECT_NE(rtp_pool_acquire(pool), nullptr);
+
+    EXPECT_EQ(rtp_pool_acquire(pool), nullptr);
+
+    rtp_pool_free(pool);
+}
@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+
+#include "rtp_random.h"
+#include "rtcp_util.h"
+
+TEST(Random, Reference) {
+    // Reference output of xoshiro256** for the state {1, 2, 3, 4}
+    rtp_random r = { { 1, 2, 3, 4 } };
+    EXPECT_EQ(rtp_random_next(&r), 11520u);
+    EXPECT_EQ(rtp_random_next(&r), 0u);
+    EXPECT_EQ(rtp_random_next(&r), 1509978240u);
+    EXPECT_EQ(rtp_random_next(&r), 1215971899390074240u);
+
+    EXPECT_DEATH(rtp_random_next(nullptr), "");
+}
+
+TEST(Random, Seed) {
+    rtp_random a, b;
+    rtp_random_seed(&a, 42);
+    rtp_random_seed(&b, 42);
+    for(int i = 0; i < 1000; ++i)
+        EXPECT_EQ(rtp_random_next(&a), rtp_random_next(&b));
+
+    rtp_random_seed(&b, 43);
+    EXPECT_NE(rtp_random_next(&a), rtp_random_next(&b));
+
+    // Even a zero seed gives a usable state
+    rtp_random_seed(&a, 0);
+    EXPECT_NE(a.s[0] | a.s[1] | a.s[2] | a.s[3], 0u);
+
+    rtp_random_init(&a);
+    rtp_random_init(&b);
+    EXPECT_NE(rtp_random_next(&a), rtp_random_next(&b));
+
+    EXPECT_EQ(rtp_random_thread(), rtp_random_thread());
+}
+
+TEST(Random, Double) {
+    rtp_random r;
+    rtp_random_seed(&r, 1234);
+
+    double sum = 0;
+    const int n = 100000;
+    for(int i = 0; i < n; ++i) {
+        const double d = rtp_random_double(&r);
+        ASSERT_GE(d, 0.0);
+        ASSERT_LT(d, 1.0);
+        sum += d;
+    }
+
+    EXPECT_NEAR(sum / n, 0.5, 0.01);
+}
+
+TEST(Random, Interval) {
+    // Reseeding the thread's generator makes the interval repeatable
+    rtp_random_seed(rtp_random_thread(), 7);
+    const double a = rtcp_interval(10, 1, 1000.0, false, 100.0, false);
+    rtp_random_seed(rtp_random_thread(), 7);
+    EXPECT_EQ(rtcp_interval(10, 1, 1000.0, false, 100.0, false), a);
+
+    rtp_random r;
+    rtp_random_seed(&r, 7);
+    EXPECT_EQ(rtcp_interval_with_random(
+        10, 1, 1000.0, false, 100.0, false, &r), a);
+
+    // Uniform factor in [0.5, 1.5) before compensation
+    const double compensation = 2.71828 - 1.5;
+    double lo = 1e9, hi = 0;
+    for(int i = 0; i < 10000; ++i) {
+        const double t = rtcp_interval_with_random(
+            1, 0, 1000.0, false, 100.0, false, &r) * compensation;
+        lo = std::min(lo, t);
+        hi = std::max(hi, t);
+    }
+
+    EXPECT_GE(lo, LIBRTP_RTCP_MIN_TIME * 0.5);
+    EXPECT_LT(hi, LIBRTP_RTCP_MIN_TIME * 1.5);
+    EXPECT_LT(lo, LIBRTP_RTCP_MIN_TIME * 0.51);
+    EXPECT_GT(hi, LIBRTP_RTCP_MIN_TIME * 1.49);
+}
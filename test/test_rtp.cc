@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include "rtp_packet.h"
+#include "rtp_packet_view.h"
 
 TEST(RtpPacket, Create) {
     rtp_packet *packet = rtp_packet_create();
@@ -88,3 +89,155 @@ TEST(RtpPacket, Parse) {
     rtp_packet_free(packet);
     delete[] buffer;
 }
+
+TEST(RtpHeader, Csrc) {
+    rtp_header *header = rtp_header_create();
+    EXPECT_NE(header, nullptr);
+
+    rtp_header_init(header, 96, rand(), rand(), rand());
+
+    for(uint32_t i = 0; i < RTP_MAX_CSRC; ++i)
+        EXPECT_EQ(rtp_header_add_csrc(header, 100 + i), 0);
+
+    EXPECT_EQ(header->cc, RTP_MAX_CSRC);
+    EXPECT_EQ(rtp_header_add_csrc(header, 99), -1);
+    EXPECT_EQ(rtp_header_add_csrc(header, 100), -1);
+
+    uint8_t buffer[128];
+    const int size = rtp_header_serialize(header, buffer, sizeof(buffer));
+    EXPECT_EQ(size, 12 + (4 * RTP_MAX_CSRC));
+    EXPECT_EQ(buffer[0] & 0xf, RTP_MAX_CSRC);
+
+    rtp_header *parsed = rtp_header_create();
+    EXPECT_EQ(rtp_header_parse(parsed, buffer, size), 0);
+    EXPECT_EQ(parsed->cc, RTP_MAX_CSRC);
+    for(uint32_t i = 0; i < RTP_MAX_CSRC; ++i)
+        EXPECT_EQ(parsed->csrc[i], 100 + i);
+
+    // Remove from the middle and the end
+    rtp_header_remove_csrc(header, 107);
+    rtp_header_remove_csrc(header, 114);
+    EXPECT_EQ(header->cc, RTP_MAX_CSRC - 2);
+    EXPECT_EQ(rtp_header_find_csrc(header, 107), -1);
+    EXPECT_EQ(rtp_header_find_csrc(header, 108), 7);
+    EXPECT_EQ(header->csrc[header->cc - 1], 113);
+
+    rtp_header_free(parsed);
+    rtp_header_free(header);
+}
+
+TEST(RtpHeader, Ext) {
+    const uint32_t small[1] = { 0xdeadbeef };
+    uint32_t large[LIBRTP_HEADER_EXT_INLINE + 1];
+    for(size_t i = 0; i < LIBRTP_HEADER_EXT_INLINE + 1; ++i)
+        large[i] = (uint32_t)i;
+
+    rtp_header *header = rtp_header_create();
+    EXPECT_NE(header, nullptr);
+
+    rtp_header_init(header, 96, rand(), rand(), rand());
+    header->x = 1;
+
+    // Small extensions are stored inline
+    EXPECT_EQ(rtp_header_set_ext(header, 0xbede, small, 1), 0);
+    EXPECT_EQ(header->ext_data, header->ext_inline);
+    EXPECT_EQ(rtp_header_set_ext(header, 0xbede, small, 1), -1);
+    EXPECT_EQ(rtp_header_size(header), 20);
+    rtp_header_clear_ext(header);
+    EXPECT_EQ(header->ext_data, nullptr);
+
+    // Large extensions fall back to the heap
+    const uint16_t count = LIBRTP_HEADER_EXT_INLINE + 1;
+    EXPECT_EQ(rtp_header_set_ext(header, 0x1000, large, count), 0);
+    EXPECT_NE(header->ext_data, header->ext_inline);
+
+    uint8_t buffer[128];
+    const int size = rtp_header_serialize(header, buffer, sizeof(buffer));
+    EXPECT_EQ(size, 16 + (4 * count));
+
+    rtp_header *parsed = rtp_header_create();
+    EXPECT_EQ(rtp_header_parse(parsed, buffer, size), 0);
+    EXPECT_EQ(parsed->ext_id, 0x1000);
+    EXPECT_EQ(parsed->ext_count, count);
+    EXPECT_EQ(memcmp(parsed->ext_data, large, sizeof(large)), 0);
+
+    // Truncated extensions are rejected
+    EXPECT_EQ(rtp_header_parse(parsed, buffer, size - 4), -1);
+
+    // So are truncated extension headers, copied so a read past the end
+    // leaves the allocation
+    for(size_t n = 12; n < 16; ++n) {
+        uint8_t *truncated = (uint8_t*)malloc(n);
+        memcpy(truncated, buffer, n);
+        EXPECT_EQ(rtp_header_parse(parsed, truncated, n), -1);
+        free(truncated);
+    }
+
+    rtp_header_free(parsed);
+    rtp_header_free(header);
+}
+
+TEST(RtpPacket, SerializeIov) {
+    rtp_packet *packet = rtp_packet_create();
+    EXPECT_NE(packet, nullptr);
+
+    rtp_packet_init(packet, 96, rand(), rand(), rand());
+    rtp_header_add_csrc(packet->header, 0x11111111);
+
+    uint8_t data[1200];
+    for(size_t i = 0; i < sizeof(data); ++i)
+        data[i] = (uint8_t)i;
+
+    rtp_packet_set_payload(packet, data, sizeof(data));
+
+    uint8_t buffer[32];
+    struct iovec iov[3];
+    EXPECT_DEATH(rtp_packet_serialize_iov(
+        nullptr, buffer, sizeof(buffer), 0, iov, 3), "");
+    EXPECT_DEATH(rtp_packet_serialize_iov(
+        packet, nullptr, 0, 0, iov, 3), "");
+    EXPECT_DEATH(rtp_packet_serialize_iov(
+        packet, buffer, sizeof(buffer), 0, nullptr, 3), "");
+
+    // No padding, the payload is referenced in place
+    EXPECT_EQ(rtp_packet_serialize_iov(
+        packet, buffer, sizeof(buffer), 0, iov, 2), 2);
+    EXPECT_EQ(iov[0].iov_base, buffer);
+    EXPECT_EQ(iov[0].iov_len, 16);
+    EXPECT_EQ(iov[1].iov_base, packet->payload_data);
+    EXPECT_EQ(iov[1].iov_len, sizeof(data));
+
+    // Gathered output matches rtp_packet_serialize()
+    const size_t size = rtp_packet_size(packet);
+    uint8_t *expected = new uint8_t[size];
+    EXPECT_EQ(rtp_packet_serialize(packet, expected, size), (int)size);
+    EXPECT_EQ(memcmp(iov[0].iov_base, expected, 16), 0);
+    EXPECT_EQ(memcmp(iov[1].iov_base, expected + 16, sizeof(data)), 0);
+    delete[] expected;
+
+    // Padding needs a third entry and room in the buffer
+    EXPECT_EQ(rtp_packet_serialize_iov(
+        packet, buffer, sizeof(buffer), 4, iov, 2), -1);
+    EXPECT_EQ(rtp_packet_serialize_iov(
+        packet, buffer, 16, 4, iov, 3), -1);
+    EXPECT_EQ(rtp_packet_serialize_iov(
+        packet, buffer, sizeof(buffer), 4, iov, 3), 3);
+    EXPECT_EQ(iov[2].iov_len, 4);
+    EXPECT_EQ(((uint8_t*)iov[2].iov_base)[3], 4);
+
+    // Reassemble and parse the padded packet as a receiver would
+    uint8_t wire[16 + sizeof(data) + 4];
+    size_t offset = 0;
+    for(int i = 0; i < 3; ++i) {
+        memcpy(wire + offset, iov[i].iov_base, iov[i].iov_len);
+        offset += iov[i].iov_len;
+    }
+
+    rtp_packet_view view;
+    EXPECT_EQ(rtp_packet_view_parse(&view, wire, offset), RTP_PARSE_OK);
+    EXPECT_EQ(view.p, 1);
+    EXPECT_EQ(view.payload_size, sizeof(data));
+    EXPECT_EQ(memcmp(view.payload_data, data, sizeof(data)), 0);
+
+    rtp_packet_free(packet);
+}
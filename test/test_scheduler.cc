@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+
+#include "rtcp_scheduler.h"
+#include "rtcp_util.h"
+
+// Bounds of the randomized interval for a deterministic interval of t
+static const double COMPENSATION = 2.71828 - 1.5;
+#define EXPECT_INTERVAL(value, t) \
+    EXPECT_GE(value, (t) * 0.5 / COMPENSATION); \
+    EXPECT_LE(value, (t) * 1.5 / COMPENSATION)
+
+TEST(RtcpScheduler, Create) {
+    rtcp_scheduler *s = rtcp_scheduler_create();
+    ASSERT_NE(s, nullptr);
+
+    rtcp_scheduler_init(s, 100.0, 1000.0, 100.0);
+    EXPECT_EQ(s->members, 1);
+    EXPECT_EQ(s->pmembers, 1);
+    EXPECT_EQ(s->senders, 0);
+    EXPECT_TRUE(s->initial);
+    EXPECT_FALSE(s->we_sent);
+
+    // Half the minimum interval for the first report
+    EXPECT_INTERVAL(rtcp_scheduler_next_deadline(s) - 100.0,
+        LIBRTP_RTCP_MIN_TIME / 2);
+
+    EXPECT_DEATH(rtcp_scheduler_free(nullptr), "");
+    rtcp_scheduler_free(s);
+}
+
+TEST(RtcpScheduler, Report) {
+    rtcp_scheduler s;
+    rtcp_scheduler_init(&s, 0.0, 1000.0, 100.0);
+
+    rtcp_scheduler_on_rtp_sent(&s);
+    rtcp_scheduler_on_rtp_sent(&s);
+    EXPECT_TRUE(s.we_sent);
+    EXPECT_EQ(s.senders, 1);
+
+    EXPECT_TRUE(rtcp_scheduler_on_expire(&s, 10.0));
+    rtcp_scheduler_on_rtcp_sent(&s, 10.0, 200);
+    EXPECT_FALSE(s.initial);
+    EXPECT_DOUBLE_EQ(s.tp, 10.0);
+    EXPECT_DOUBLE_EQ(s.avg_rtcp_size, 100.0 + (200.0 - 100.0) / 16);
+
+    // As in the reference code the interval after the first report is still
+    // drawn with the initial minimum
+    EXPECT_INTERVAL(rtcp_scheduler_next_deadline(&s) - 10.0,
+        LIBRTP_RTCP_MIN_TIME / 2);
+
+    rtcp_scheduler_on_rtcp_received(&s, 100, false);
+    EXPECT_LT(s.avg_rtcp_size, 100.0 + (200.0 - 100.0) / 16);
+
+    // No RTP since the 2nd previous report
+    rtcp_scheduler_on_rtcp_sent(&s, 20.0, 100);
+    EXPECT_FALSE(s.we_sent);
+    EXPECT_EQ(s.senders, 0);
+    EXPECT_INTERVAL(rtcp_scheduler_next_deadline(&s) - 20.0,
+        LIBRTP_RTCP_MIN_TIME);
+}
+
+TEST(RtcpScheduler, Reconsider) {
+    rtcp_scheduler s;
+    rtcp_scheduler_init(&s, 0.0, 1000.0, 100.0);
+    const double tn = rtcp_scheduler_next_deadline(&s);
+
+    // Forward, a crowd joined so the report is pushed back
+    rtcp_scheduler_set_members(&s, 1.0, 999, 0);
+    EXPECT_EQ(s.members, 1000);
+    EXPECT_FALSE(rtcp_scheduler_on_expire(&s, tn));
+    EXPECT_INTERVAL(rtcp_scheduler_next_deadline(&s),
+        100.0 * 1000 / (1000.0 * 0.75));
+
+    rtcp_scheduler_on_rtcp_sent(&s, 100.0, 100);
+    EXPECT_EQ(s.pmembers, 1000);
+
+    // Reverse, most of them left so the report is pulled in
+    const double before = rtcp_scheduler_next_deadline(&s);
+    rtcp_scheduler_set_members(&s, 100.0, 99, 0);
+    EXPECT_EQ(s.pmembers, 100);
+    EXPECT_NEAR(rtcp_scheduler_next_deadline(&s) - 100.0,
+        (before - 100.0) / 10, 1e-9);
+}
+
+TEST(RtcpScheduler, Bye) {
+    rtcp_scheduler s;
+    rtcp_scheduler_init(&s, 0.0, 1000.0, 100.0);
+
+    // Never sent anything
+    EXPECT_EQ(rtcp_scheduler_leave(&s, 1.0, 100), -1);
+
+    rtcp_scheduler_init(&s, 0.0, 1000.0, 100.0);
+    rtcp_scheduler_on_rtp_sent(&s);
+    rtcp_scheduler_set_members(&s, 1.0, LIBRTP_RTCP_BYE_BACKOFF_MEMBERS - 1, 0);
+    EXPECT_EQ(rtcp_scheduler_leave(&s, 1.0, 100), 1);
+
+    // Backoff when the session is large
+    rtcp_scheduler_init(&s, 0.0, 1000.0, 100.0);
+    rtcp_scheduler_on_rtp_sent(&s);
+    rtcp_scheduler_set_members(&s, 1.0, 500, 0);
+    EXPECT_EQ(rtcp_scheduler_leave(&s, 2.0, 100), 0);
+    EXPECT_TRUE(s.leaving);
+    EXPECT_EQ(s.members, 1);
+    EXPECT_INTERVAL(rtcp_scheduler_next_deadline(&s) - 2.0,
+        LIBRTP_RTCP_MIN_TIME / 2);
+
+    // Only other BYEs count, membership updates are ignored
+    for(int i = 0; i < 500; ++i)
+        rtcp_scheduler_on_rtcp_received(&s, 100, true);
+
+    rtcp_scheduler_on_rtcp_received(&s, 100, false);
+    rtcp_scheduler_set_members(&s, 3.0, 10, 0);
+    EXPECT_EQ(s.members, 501);
+
+    EXPECT_FALSE(rtcp_scheduler_on_expire(&s, 3.0));
+    EXPECT_INTERVAL(rtcp_scheduler_next_deadline(&s) - 2.0,
+        100.0 * 501 / (1000.0 * 0.75));
+    EXPECT_TRUE(rtcp_scheduler_on_expire(&s, 1000.0));
+}
+
+static void count_expiry(void *ctx, rtp_timer *)
+{
+    *(int*)ctx += 1;
+}
+
+TEST(RtcpScheduler, Wheel) {
+    rtp_timer_wheel *w = rtp_timer_wheel_create(0);
+    ASSERT_NE(w, nullptr);
+
+    // Millisecond ticks
+    int expired = 0;
+    rtcp_scheduler s;
+    rtcp_scheduler_init(&s, 0.0, 1000.0, 100.0);
+    rtcp_scheduler_attach(&s, w, 0.001, count_expiry, &expired);
+    EXPECT_EQ(rtp_timer_wheel_size(w), 1u);
+
+    const uint64_t deadline =
+        (uint64_t)(rtcp_scheduler_next_deadline(&s) * 1000.0);
+    rtp_timer_wheel_advance(w, deadline - 1);
+    EXPECT_EQ(expired, 0);
+    rtp_timer_wheel_advance(w, deadline + 1);
+    EXPECT_EQ(expired, 1);
+
+    // Sending moves the timer to the new deadline
+    const double tc = (double)(deadline + 1) / 1000.0;
+    rtcp_scheduler_on_rtcp_sent(&s, tc, 100);
+    EXPECT_TRUE(rtp_timer_pending(&s.timer));
+    EXPECT_NEAR((double)s.timer.expires / 1000.0,
+        rtcp_scheduler_next_deadline(&s), 0.001);
+
+    // Reverse reconsideration pulls it in
+    rtcp_scheduler_set_members(&s, tc, 99, 0);
+    rtcp_scheduler_on_rtcp_sent(&s, tc, 100);
+    rtcp_scheduler_set_members(&s, tc, 9, 0);
+    EXPECT_NEAR((double)s.timer.expires / 1000.0,
+        rtcp_scheduler_next_deadline(&s), 0.001);
+
+    // A BYE sent at once needs no timer
+    rtcp_scheduler_on_rtp_sent(&s);
+    EXPECT_EQ(rtcp_scheduler_leave(&s, tc, 100), 1);
+    EXPECT_FALSE(rtp_timer_pending(&s.timer));
+
+    rtcp_scheduler_init(&s, tc, 1000.0, 100.0);
+    rtcp_scheduler_attach(&s, w, 0.001, count_expiry, &expired);
+    rtcp_scheduler_attach(&s, nullptr, 0, nullptr, nullptr);
+    EXPECT_EQ(rtp_timer_wheel_size(w), 0u);
+
+    rtp_timer_wheel_free(w);
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "rtp_transport_sharded.h"
+#include "rtp_header.h"
+
+struct shard_counts {
+    std::atomic<int> received[4];
+    std::atomic<int> misplaced;
+    std::atomic<int> total;
+};
+
+static void count_packets(
+    void *ctx, unsigned int shard, rtp_transport_udp_packet *packets, size_t n)
+{
+    shard_counts *counts = (shard_counts*)ctx;
+    for(size_t i = 0; i < n; ++i) {
+        if(rtp_transport_sharded_shard_of(packets[i].view.ssrc, 4) != shard)
+            counts->misplaced += 1;
+
+        counts->received[shard] += 1;
+        counts->total += 1;
+    }
+}
+
+TEST(TransportSharded, ShardOf) {
+    for(uint32_t ssrc = 0; ssrc < 1000; ++ssrc)
+        EXPECT_LT(rtp_transport_sharded_shard_of(ssrc, 3), 3u);
+
+    // Sequential SSRCs spread across every shard
+    int hits[4] = { 0, 0, 0, 0 };
+    for(uint32_t ssrc = 0; ssrc < 64; ++ssrc)
+        hits[rtp_transport_sharded_shard_of(ssrc, 4)] += 1;
+
+    for(int i = 0; i < 4; ++i)
+        EXPECT_GT(hits[i], 0);
+}
+
+TEST(TransportSharded, SsrcAffinity) {
+    shard_counts counts = {};
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // Bind the group to a free port
+    const int probe = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_EQ(bind(probe, (struct sockaddr*)&addr, sizeof(addr)), 0);
+    socklen_t len = sizeof(addr);
+    ASSERT_EQ(getsockname(probe, (struct sockaddr*)&addr, &len), 0);
+    close(probe);
+
+    rtp_transport_sharded_config config = {};
+    config.shards = 4;
+    config.ssrc_affinity = 1;
+    config.handler = count_packets;
+    config.ctx = &counts;
+
+    rtp_transport_sharded *t = rtp_transport_sharded_create(
+        AF_INET, (struct sockaddr*)&addr, sizeof(addr), &config);
+    ASSERT_NE(t, nullptr);
+    EXPECT_EQ(rtp_transport_sharded_count(t), 4u);
+    ASSERT_EQ(rtp_transport_sharded_start(t), 0);
+
+    // Four packets from each of 64 sources
+    const int tx = socket(AF_INET, SOCK_DGRAM, 0);
+    int expected[4] = { 0, 0, 0, 0 };
+    rtp_header *header = rtp_header_create();
+    for(uint32_t ssrc = 0; ssrc < 64; ++ssrc) {
+        rtp_header_init(header, 96, 0x1000 + ssrc, 0, 0);
+        expected[rtp_transport_sharded_shard_of(0x1000 + ssrc, 4)] += 4;
+
+        for(int i = 0; i < 4; ++i) {
+            uint8_t data[64] = {};
+            header->seq = (uint16_t)i;
+            rtp_header_serialize(header, data, sizeof(data));
+            EXPECT_EQ(sendto(tx, data, sizeof(data), 0,
+                (struct sockaddr*)&addr, sizeof(addr)), 64);
+        }
+    }
+    rtp_header_free(header);
+    close(tx);
+
+    for(int tries = 0; counts.total < 256 && tries < 200; ++tries)
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+    rtp_transport_sharded_stop(t);
+
+    EXPECT_EQ(counts.total, 256);
+    EXPECT_EQ(counts.misplaced, 0);
+    for(int i = 0; i < 4; ++i)
+        EXPECT_EQ(counts.received[i], expected[i]);
+
+    // The engine can be restarted
+    EXPECT_EQ(rtp_transport_sharded_start(t), 0);
+    rtp_transport_sharded_free(t);
+}
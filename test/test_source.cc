@@ -0,0 +1,147 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "rtp_source.h"
+
+TEST(RtpSource, TimespecToRtp) {
+    struct timespec t = { 1, 500000000 };
+    EXPECT_EQ(rtp_timespec_to_rtp(&t, 8000), 12000u);
+    EXPECT_EQ(rtp_timespec_to_rtp(&t, 90000), 135000u);
+
+    // Only the low 32 bits are kept
+    t.tv_sec = 1700000000;
+    t.tv_nsec = 999999999;
+    const uint64_t expected = (uint64_t)1700000000 * 48000 + 47999;
+    EXPECT_EQ(rtp_timespec_to_rtp(&t, 48000), (uint32_t)expected);
+
+    EXPECT_DEATH(rtp_timespec_to_rtp(nullptr, 8000), "");
+}
+
+TEST(RtpSource, Arrival) {
+    rtp_source *s = rtp_source_create();
+    ASSERT_NE(s, nullptr);
+    rtp_source_init(s, 0xdeadbeef, 0);
+
+    // The first packet only establishes the transit time
+    struct timespec arrival = { 100, 0 };
+    rtp_source_update_arrival(s, 1000, &arrival, 8000);
+    s->jitter = 0;
+
+    // 20 ms packets arriving exactly on time have no jitter
+    for(uint32_t i = 1; i < 10; ++i) {
+        arrival.tv_nsec += 20000000;
+        rtp_source_update_arrival(s, 1000 + (i * 160), &arrival, 8000);
+    }
+    EXPECT_EQ(rtp_source_jitter(s), 0u);
+
+    // One packet 10 ms late moves the estimate by 80 / 16 samples
+    arrival.tv_nsec += 30000000;
+    rtp_source_update_arrival(s, 1000 + (10 * 160), &arrival, 8000);
+#if LIBRTP_JITTER_FIXED
+    EXPECT_EQ(s->jitter, 80u);
+#else
+    EXPECT_DOUBLE_EQ(s->jitter, 5.0);
+#endif
+    EXPECT_EQ(rtp_source_jitter(s), 5u);
+
+    EXPECT_DEATH(rtp_source_update_arrival(nullptr, 0, &arrival, 8000), "");
+    rtp_source_free(s);
+}
+
+TEST(RtpSource, JitterBatch) {
+    rtp_source scalar;
+    rtp_source batch;
+    memset(&scalar, 0, sizeof(scalar));
+    memset(&batch, 0, sizeof(batch));
+
+    // 20 ms packets at 8 kHz with up to 5 ms of arrival noise
+    std::mt19937 rng(1234);
+    std::vector<uint32_t> ts(1000);
+    std::vector<uint32_t> arrival(1000);
+    for(size_t i = 0; i < ts.size(); ++i) {
+        ts[i] = 0xfffff000u + (uint32_t)(i * 160);
+        arrival[i] = 5000 + (uint32_t)(i * 160) + (rng() % 40);
+    }
+
+    for(size_t i = 0; i < ts.size(); ++i)
+        rtp_source_update_jitter(&scalar, ts[i], arrival[i]);
+
+    // Uneven runs cross the internal chunk size
+    size_t offset = 0;
+    const size_t runs[] = { 1, 31, 64, 65, 200, 639 };
+    for(size_t n : runs) {
+        rtp_source_update_jitter_batch(&batch, &ts[offset], &arrival[offset], n);
+        offset += n;
+    }
+
+    ASSERT_EQ(offset, ts.size());
+    EXPECT_EQ(batch.transit, scalar.transit);
+    EXPECT_EQ(batch.jitter, scalar.jitter);
+    EXPECT_GT(rtp_source_jitter(&batch), 0u);
+
+    rtp_source_update_jitter_batch(&batch, nullptr, nullptr, 0);
+    EXPECT_EQ(batch.jitter, scalar.jitter);
+    EXPECT_DEATH(rtp_source_update_jitter_batch(nullptr, nullptr, nullptr, 0), "");
+}
+
+TEST(RtpSource, SeqBatch) {
+    std::mt19937 rng(1234);
+
+    for(int trial = 0; trial < 200; ++trial) {
+        rtp_source scalar;
+        rtp_source batch;
+        memset(&scalar, 0, sizeof(scalar));
+        const uint16_t first = (uint16_t)rng();
+        rtp_source_init(&scalar, 0x1234, first);
+        batch = scalar;
+
+        // Mostly in order runs with loss, duplicates, jumps and the wrap
+        uint16_t next = first;
+        for(int round = 0; round < 50; ++round) {
+            const size_t n = 1 + rng() % 64;
+            std::vector<uint16_t> seqs(n);
+            for(size_t i = 0; i < n; ++i) {
+                const uint32_t event = rng() % 100;
+                if(event < 3)
+                    next += 1 + rng() % 5;
+                else if(event < 5)
+                    next -= 1 + rng() % 5;
+                else if(event == 5)
+                    next += (uint16_t)rng();
+
+                seqs[i] = next++;
+            }
+
+            uint64_t expected = 0;
+            for(size_t i = 0; i < n; ++i) {
+                if(rtp_source_update_seq(&scalar, seqs[i]) == 0)
+                    expected |= 1ull << i;
+            }
+
+            ASSERT_EQ(rtp_source_update_seq_batch(&batch, seqs.data(), n),
+                expected);
+            ASSERT_EQ(memcmp(&batch, &scalar, sizeof(rtp_source)), 0);
+        }
+    }
+
+    // A full batch across the wrap
+    rtp_source s;
+    memset(&s, 0, sizeof(s));
+    rtp_source_init(&s, 0x1234, 65500);
+    rtp_source_update_seq(&s, 65500);
+    rtp_source_update_seq(&s, 65501);
+
+    uint16_t seqs[64];
+    for(int i = 0; i < 64; ++i)
+        seqs[i] = (uint16_t)(65502 + i);
+
+    EXPECT_EQ(rtp_source_update_seq_batch(&s, seqs, 64), ~0ull);
+    EXPECT_EQ(s.cycles, 65536u);
+    EXPECT_EQ(s.max_seq, (uint16_t)(65502 + 63));
+    EXPECT_EQ(s.received, 65);
+
+    EXPECT_EQ(rtp_source_update_seq_batch(&s, nullptr, 0), 0u);
+    EXPECT_DEATH(rtp_source_update_seq_batch(&s, seqs, 65), "");
+}
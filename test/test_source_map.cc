@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstring>
+#include <set>
+#include <thread>
+
+#include "rtp_source_map.h"
+
+TEST(RtpSourceMap, Insert) {
+    rtp_source_map *m = rtp_source_map_create(4);
+    ASSERT_NE(m, nullptr);
+
+    const int reader = rtp_source_map_join(m);
+    ASSERT_GE(reader, 0);
+
+    rtp_source_map_read_lock(m, reader);
+    EXPECT_EQ(rtp_source_map_size(m), 0u);
+    EXPECT_EQ(rtp_source_map_find(m, 0x1234), nullptr);
+    EXPECT_EQ(rtp_source_map_next(m, nullptr), nullptr);
+
+    rtp_source_map_entry *e = rtp_source_map_insert(m, 0x1234, 100);
+    ASSERT_NE(e, nullptr);
+    EXPECT_EQ(rtp_source_map_find(m, 0x1234), e);
+    EXPECT_EQ(rtp_source_map_insert(m, 0x1234, 200), e);
+
+    rtp_source s;
+    rtp_source_map_read(e, &s);
+    EXPECT_EQ(s.id, 0x1234u);
+
+    // More sources than buckets
+    std::set<uint32_t> expected = { 0x1234 };
+    for(uint32_t ssrc = 0; ssrc < 64; ++ssrc) {
+        ASSERT_NE(rtp_source_map_insert(m, ssrc, 0), nullptr);
+        expected.insert(ssrc);
+    }
+
+    EXPECT_EQ(rtp_source_map_remove(m, 0x1234), 0);
+    EXPECT_EQ(rtp_source_map_remove(m, 0x1234), -1);
+    EXPECT_EQ(rtp_source_map_find(m, 0x1234), nullptr);
+    expected.erase(0x1234);
+
+    // The removed entry is still readable until the section ends
+    rtp_source_map_read(e, &s);
+    EXPECT_EQ(s.id, 0x1234u);
+    rtp_source_map_read_unlock(m, reader);
+
+    rtp_source_map_read_lock(m, reader);
+    std::set<uint32_t> iterated;
+    for(e = rtp_source_map_next(m, nullptr); e; e = rtp_source_map_next(m, e)) {
+        rtp_source_map_read(e, &s);
+        iterated.insert(s.id);
+    }
+
+    EXPECT_EQ(iterated, expected);
+    EXPECT_EQ(rtp_source_map_size(m), expected.size());
+    rtp_source_map_read_unlock(m, reader);
+
+    // Reader slots run out
+    int count = 1;
+    while(rtp_source_map_join(m) >= 0)
+        count += 1;
+
+    EXPECT_EQ(count, LIBRTP_SOURCE_MAP_THREADS);
+    rtp_source_map_leave(m, reader);
+    EXPECT_EQ(rtp_source_map_join(m), reader);
+
+    rtp_source_map_reclaim(m);
+    EXPECT_DEATH(rtp_source_map_insert(nullptr, 0, 0), "");
+    rtp_source_map_free(m);
+}
+
+TEST(RtpSourceMap, Report) {
+    rtp_source_map *m = rtp_source_map_create(16);
+    ASSERT_NE(m, nullptr);
+
+    const int reader = rtp_source_map_join(m);
+    rtp_source_map_read_lock(m, reader);
+    rtp_source_map_entry *e = rtp_source_map_insert(m, 0x1234, 0);
+    ASSERT_NE(e, nullptr);
+
+    // 100 packets with every fourth one lost
+    for(uint16_t seq = 0; seq < 100; ++seq) {
+        if(seq > 2 && seq % 4 == 0)
+            continue;
+
+        rtp_source *s = rtp_source_map_write_begin(e);
+        rtp_source_update_seq(s, seq);
+        rtp_source_map_write_end(e);
+    }
+
+    const ntp_tv lsr = { 100, 0 };
+    const ntp_tv tc = { 101, 0 };
+    rtp_source_map_update_lsr(e, lsr);
+
+    rtcp_report report;
+    memset(&report, 0, sizeof(report));
+    rtp_source_map_report(e, &report, tc);
+    EXPECT_EQ(report.ssrc, 0x1234u);
+    EXPECT_EQ(report.last_seq, 99u);
+    EXPECT_EQ(report.lost, 24);
+    EXPECT_EQ(report.fraction, (24u << 8) / 99);
+    EXPECT_EQ(report.lsr, ntp_short(lsr));
+    EXPECT_EQ(report.dlsr, 1u << 16);
+
+    // No packets since the last report, so no fraction lost
+    rtp_source_map_report(e, &report, tc);
+    EXPECT_EQ(report.lost, 24);
+    EXPECT_EQ(report.fraction, 0u);
+
+    // The writer's state is untouched by reporting
+    rtp_source s;
+    rtp_source_map_read(e, &s);
+    EXPECT_EQ(s.expected_prior, 0);
+    EXPECT_EQ(s.lost, 0);
+
+    rtp_source_map_read_unlock(m, reader);
+    rtp_source_map_free(m);
+}
+
+TEST(RtpSourceMap, Concurrent) {
+    rtp_source_map *m = rtp_source_map_create(64);
+    ASSERT_NE(m, nullptr);
+
+    const uint32_t sources = 16;
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+    std::atomic<int> unknown(0);
+
+    // Receive worker, every packet in order so expected == received
+    std::thread writer([&]() {
+        const int reader = rtp_source_map_join(m);
+        for(uint32_t i = 0; i < 200000; ++i) {
+            rtp_source_map_read_lock(m, reader);
+            rtp_source_map_entry *e = rtp_source_map_insert(
+                m, i % sources, 0);
+
+            rtp_source *s = rtp_source_map_write_begin(e);
+            rtp_source_update_seq(s, (uint16_t)(i / sources));
+            rtp_source_map_write_end(e);
+            rtp_source_map_read_unlock(m, reader);
+        }
+
+        rtp_source_map_leave(m, reader);
+        done = true;
+    });
+
+    // Sources joining and leaving
+    std::thread churn([&]() {
+        const int reader = rtp_source_map_join(m);
+        uint32_t i = 0;
+        while(!done) {
+            const uint32_t ssrc = 1000 + (i++ % 64);
+            rtp_source_map_read_lock(m, reader);
+            if(!rtp_source_map_find(m, ssrc))
+                rtp_source_map_insert(m, ssrc, 0);
+            else
+                rtp_source_map_remove(m, ssrc);
+
+            rtp_source_map_read_unlock(m, reader);
+        }
+
+        rtp_source_map_leave(m, reader);
+    });
+
+    // RTCP thread
+    const int reader = rtp_source_map_join(m);
+    while(!done) {
+        rtp_source_map_read_lock(m, reader);
+        rtp_source_map_entry *e = rtp_source_map_next(m, nullptr);
+        for(; e; e = rtp_source_map_next(m, e)) {
+            rtp_source s;
+            rtp_source_map_read(e, &s);
+            if(s.id >= 1000 && s.id < 1064)
+                continue;
+
+            if(s.id >= sources)
+                unknown += 1;
+
+            const uint32_t expected = s.cycles + s.max_seq - s.base_seq + 1;
+            if(s.probation == 0 && expected != (uint32_t)s.received)
+                torn += 1;
+        }
+
+        rtp_source_map_read_unlock(m, reader);
+    }
+
+    writer.join();
+    churn.join();
+
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(unknown, 0);
+
+    rtp_source_map_read_lock(m, reader);
+    for(uint32_t ssrc = 0; ssrc < sources; ++ssrc) {
+        rtp_source_map_entry *e = rtp_source_map_find(m, ssrc);
+        ASSERT_NE(e, nullptr);
+
+        rtp_source s;
+        rtp_source_map_read(e, &s);
+        EXPECT_EQ(s.received, 200000 / (int)sources - 1);
+    }
+
+    rtp_source_map_read_unlock(m, reader);
+    rtp_source_map_free(m);
+}
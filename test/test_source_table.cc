@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <set>
+
+#include "rtp_source_table.h"
+
+TEST(RtpSourceTable, Insert) {
+    rtp_source_table *t = rtp_source_table_create(0);
+    ASSERT_NE(t, nullptr);
+    EXPECT_EQ(rtp_source_table_size(t), 0u);
+    EXPECT_EQ(rtp_source_table_find(t, 0x1234), nullptr);
+
+    rtp_source *s = rtp_source_table_insert(t, 0x1234, 100);
+    ASSERT_NE(s, nullptr);
+    EXPECT_EQ(s->id, 0x1234u);
+    EXPECT_EQ(rtp_source_table_find(t, 0x1234), s);
+
+    // Inserting again returns the existing source
+    EXPECT_EQ(rtp_source_table_insert(t, 0x1234, 200), s);
+    EXPECT_EQ(rtp_source_table_size(t), 1u);
+
+    EXPECT_DEATH(rtp_source_table_insert(nullptr, 0, 0), "");
+    EXPECT_DEATH(rtp_source_table_at(t, 1), "");
+    rtp_source_table_free(t);
+}
+
+TEST(RtpSourceTable, Random) {
+    rtp_source_table *t = rtp_source_table_create(16);
+    ASSERT_NE(t, nullptr);
+
+    std::mt19937 rng(1234);
+    std::set<uint32_t> expected;
+
+    // Grow well past the initial capacity with interleaved removals
+    for(int i = 0; i < 20000; ++i) {
+        const uint32_t ssrc = rng() % 8192;
+        if(rng() % 4 == 0) {
+            const int result = rtp_source_table_remove(t, ssrc);
+            EXPECT_EQ(result, expected.erase(ssrc) ? 0 : -1);
+        }
+        else {
+            rtp_source *s = rtp_source_table_insert(t, ssrc, 0);
+            ASSERT_NE(s, nullptr);
+            EXPECT_EQ(s->id, ssrc);
+            expected.insert(ssrc);
+        }
+    }
+
+    ASSERT_EQ(rtp_source_table_size(t), expected.size());
+
+    // Every source is reachable by lookup and by iteration
+    for(uint32_t ssrc : expected) {
+        rtp_source *s = rtp_source_table_find(t, ssrc);
+        ASSERT_NE(s, nullptr);
+        EXPECT_EQ(s->id, ssrc);
+    }
+
+    std::set<uint32_t> iterated;
+    for(size_t i = 0; i < rtp_source_table_size(t); ++i)
+        iterated.insert(rtp_source_table_at(t, i)->id);
+
+    EXPECT_EQ(iterated, expected);
+
+    for(uint32_t ssrc = 8192; ssrc < 9000; ++ssrc)
+        EXPECT_EQ(rtp_source_table_find(t, ssrc), nullptr);
+
+    rtp_source_table_free(t);
+}
+
+TEST(RtpSourceTable, Receive) {
+    rtp_source_table *t = rtp_source_table_create(4);
+    ASSERT_NE(t, nullptr);
+    rtp_source_table_set_local(t, 0xfeedface);
+
+    const uint8_t addr1[8] = { 2, 0, 0x13, 0x88, 10, 0, 0, 1 };
+    const uint8_t addr2[8] = { 2, 0, 0x13, 0x88, 10, 0, 0, 2 };
+
+    rtp_source *s = nullptr;
+    EXPECT_EQ(rtp_source_table_receive(
+        t, 0x1234, 10, addr1, sizeof(addr1), &s), RTP_SOURCE_NEW);
+    ASSERT_NE(s, nullptr);
+    EXPECT_EQ(s->id, 0x1234u);
+
+    rtp_source *found = nullptr;
+    EXPECT_EQ(rtp_source_table_receive(
+        t, 0x1234, 11, addr1, sizeof(addr1), &found), RTP_SOURCE_FOUND);
+    EXPECT_EQ(found, s);
+
+    // Same SSRC from another address is a third-party collision or a loop
+    EXPECT_EQ(rtp_source_table_receive(
+        t, 0x1234, 12, addr2, sizeof(addr2), &found), RTP_SOURCE_CONFLICT);
+    EXPECT_EQ(found, s);
+
+    // Skipping the address check
+    EXPECT_EQ(rtp_source_table_receive(
+        t, 0x1234, 13, nullptr, 0, &found), RTP_SOURCE_FOUND);
+
+    // Our own SSRC from anyone else is a collision
+    EXPECT_EQ(rtp_source_table_receive(
+        t, 0xfeedface, 1, addr2, sizeof(addr2), &found), RTP_SOURCE_COLLISION);
+    EXPECT_EQ(found, nullptr);
+    EXPECT_EQ(rtp_source_table_size(t), 1u);
+
+    // The address follows the source when another is removed
+    EXPECT_EQ(rtp_source_table_receive(
+        t, 0x5678, 1, addr2, sizeof(addr2), &found), RTP_SOURCE_NEW);
+    EXPECT_EQ(rtp_source_table_remove(t, 0x1234), 0);
+    EXPECT_EQ(rtp_source_table_receive(
+        t, 0x5678, 2, addr2, sizeof(addr2), &found), RTP_SOURCE_FOUND);
+    EXPECT_EQ(rtp_source_table_receive(
+        t, 0x5678, 3, addr1, sizeof(addr1), &found), RTP_SOURCE_CONFLICT);
+
+    rtp_source_table_free(t);
+}
+
+static void collect_timeout(void *ctx, rtp_source *source)
+{
+    ((std::set<uint32_t>*)ctx)->insert(source->id);
+}
+
+TEST(RtpSourceTable, Timeout) {
+    rtp_source_table *t = rtp_source_table_create(8);
+    ASSERT_NE(t, nullptr);
+
+    rtp_timer_wheel *w = rtp_timer_wheel_create(0);
+    ASSERT_NE(w, nullptr);
+
+    std::set<uint32_t> timed_out;
+    rtp_source *s = nullptr;
+    ASSERT_EQ(rtp_source_table_receive(t, 1, 0, nullptr, 0, &s), RTP_SOURCE_NEW);
+    ASSERT_EQ(rtp_source_table_set_timeout(
+        t, w, 100, collect_timeout, &timed_out), 0);
+
+    // Enough sources to grow the table with timers pending
+    for(uint32_t ssrc = 2; ssrc <= 64; ++ssrc)
+        ASSERT_EQ(rtp_source_table_receive(
+            t, ssrc, 0, nullptr, 0, &s), RTP_SOURCE_NEW);
+
+    EXPECT_EQ(rtp_timer_wheel_size(w), 64u);
+
+    // Odd sources keep sending, even ones go quiet
+    for(uint64_t tick = 10; tick <= 300; tick += 10) {
+        rtp_timer_wheel_advance(w, tick);
+        for(uint32_t ssrc = 1; ssrc <= 64; ssrc += 2)
+            rtp_source_table_receive(t, ssrc, 0, nullptr, 0, &s);
+    }
+
+    EXPECT_EQ(rtp_source_table_size(t), 32u);
+    EXPECT_EQ(timed_out.size(), 32u);
+    for(uint32_t ssrc = 1; ssrc <= 64; ++ssrc) {
+        EXPECT_EQ(timed_out.count(ssrc), (ssrc % 2) ? 0u : 1u);
+        EXPECT_EQ(rtp_source_table_find(t, ssrc) != nullptr, ssrc % 2 == 1);
+    }
+
+    // Touching keeps a source alive without a packet
+    for(uint64_t tick = 310; tick <= 400; tick += 10) {
+        rtp_timer_wheel_advance(w, tick);
+        rtp_source_table_touch(t, rtp_source_table_find(t, 1));
+    }
+
+    rtp_timer_wheel_advance(w, 499);
+    EXPECT_EQ(rtp_source_table_size(t), 1u);
+    EXPECT_NE(rtp_source_table_find(t, 1), nullptr);
+
+    // Removed sources take their timer with them
+    EXPECT_EQ(rtp_source_table_remove(t, 1), 0);
+    EXPECT_EQ(rtp_timer_wheel_size(w), 0u);
+
+    ASSERT_EQ(rtp_source_table_receive(t, 2, 0, nullptr, 0, &s), RTP_SOURCE_NEW);
+    ASSERT_EQ(rtp_source_table_set_timeout(t, nullptr, 0, nullptr, nullptr), 0);
+    EXPECT_EQ(rtp_timer_wheel_size(w), 0u);
+
+    rtp_source_table_free(t);
+    rtp_timer_wheel_free(w);
+}
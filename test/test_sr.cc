@@ -155,4 +155,18 @@ TEST(SrPacket, Parse) {
     rtcp_sr_free(parsed);
     rtcp_sr_free(packet);
     delete[] buffer;
-}
\ No newline at end of file
+}
+
+TEST(SrPacket, Ntp) {
+    rtcp_sr *packet = rtcp_sr_create();
+    EXPECT_NE(packet, nullptr);
+
+    rtcp_sr_init(packet);
+    rtcp_sr_set_ntp(packet, 0xe5c8a1b2c3d4e5f6ull);
+    EXPECT_EQ(packet->ntp_sec, 0xe5c8a1b2u);
+    EXPECT_EQ(packet->ntp_frac, 0xc3d4e5f6u);
+    EXPECT_EQ(rtcp_sr_ntp(packet), 0xe5c8a1b2c3d4e5f6ull);
+
+    EXPECT_DEATH(rtcp_sr_ntp(nullptr), "");
+    rtcp_sr_free(packet);
+}
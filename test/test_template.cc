@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include "rtp_header_template.h"
+
+TEST(HeaderTemplate, Write) {
+    const uint32_t ext[2] = { 0x10ff0000, 0x20aa0000 };
+
+    rtp_header *header = rtp_header_create();
+    EXPECT_NE(header, nullptr);
+
+    rtp_header_init(header, 96, 0xdeadbeef, 1, 2);
+    rtp_header_add_csrc(header, 0x11111111);
+    header->x = 1;
+    rtp_header_set_ext(header, 0xbede, ext, 2);
+
+    rtp_header_template tmpl;
+    EXPECT_DEATH(rtp_header_template_init(nullptr, header), "");
+    EXPECT_DEATH(rtp_header_template_init(&tmpl, nullptr), "");
+    EXPECT_EQ(rtp_header_template_init(&tmpl, header), 0);
+    EXPECT_EQ(tmpl.size, rtp_header_size(header));
+
+    // Each written header matches a full serialize
+    uint8_t expected[64];
+    uint8_t actual[64];
+    for(int i = 0; i < 4; ++i) {
+        header->m = i & 1;
+        header->seq = (uint16_t)(0xfffe + i);
+        header->ts = 0xfffffc40U + (960U * i);
+
+        const int size = rtp_header_serialize(
+            header, expected, sizeof(expected));
+
+        EXPECT_EQ(rtp_header_template_write(&tmpl, actual, sizeof(actual),
+            header->m, header->seq, header->ts), size);
+
+        EXPECT_EQ(memcmp(actual, expected, size), 0);
+    }
+
+    // Exact and short buffers
+    EXPECT_EQ(rtp_header_template_write(
+        &tmpl, actual, tmpl.size, 0, 1, 2), (int)tmpl.size);
+    EXPECT_EQ(rtp_header_template_write(
+        &tmpl, actual, tmpl.size - 1, 0, 1, 2), -1);
+
+    rtp_header_free(header);
+}
+
+TEST(HeaderTemplate, Ext) {
+    const uint32_t ext[2] = { 0, 0 };
+
+    rtp_header *header = rtp_header_create();
+    rtp_header_init(header, 96, 0xdeadbeef, 1, 2);
+    header->x = 1;
+    rtp_header_set_ext(header, 0xbede, ext, 2);
+
+    rtp_header_template tmpl;
+    EXPECT_EQ(rtp_header_template_init(&tmpl, header), 0);
+    EXPECT_EQ(rtp_header_template_set_ext(&tmpl, 1, 0x12345678), 0);
+    EXPECT_EQ(rtp_header_template_set_ext(&tmpl, 2, 0), -1);
+
+    uint8_t buffer[64];
+    const int size = rtp_header_template_write(
+        &tmpl, buffer, sizeof(buffer), 0, 1, 2);
+
+    rtp_header *parsed = rtp_header_create();
+    EXPECT_EQ(rtp_header_parse(parsed, buffer, size), 0);
+    EXPECT_EQ(parsed->ext_count, 2);
+    EXPECT_EQ(parsed->ext_data[0], 0);
+    EXPECT_EQ(parsed->ext_data[1], 0x12345678);
+
+    rtp_header_free(parsed);
+    rtp_header_free(header);
+}
+
+TEST(HeaderTemplate, TooLarge) {
+    uint32_t ext[LIBRTP_HEADER_TEMPLATE_SIZE / 4] = {};
+
+    rtp_header *header = rtp_header_create();
+    rtp_header_init(header, 96, 0xdeadbeef, 1, 2);
+    header->x = 1;
+    rtp_header_set_ext(header, 0xbede, ext, LIBRTP_HEADER_TEMPLATE_SIZE / 4);
+
+    rtp_header_template tmpl;
+    EXPECT_EQ(rtp_header_template_init(&tmpl, header), -1);
+
+    rtp_header_free(header);
+}
+
+TEST(HeaderTemplate, Payload) {
+    rtp_header *header = rtp_header_create();
+    EXPECT_NE(header, nullptr);
+
+    // Every header size up to a few CSRCs leaves the payload alone
+    rtp_header_init(header, 96, 0xdeadbeef, 1, 2);
+    for(int cc = 0; cc <= 6; ++cc) {
+        rtp_header_template tmpl;
+        EXPECT_EQ(rtp_header_template_init(&tmpl, header), 0);
+
+        uint8_t buffer[128];
+        memset(buffer, 0xa5, sizeof(buffer));
+        EXPECT_EQ(rtp_header_template_write(
+            &tmpl, buffer, sizeof(buffer), 0, 1, 2), (int)tmpl.size);
+
+        for(size_t i = tmpl.size; i < sizeof(buffer); ++i)
+            ASSERT_EQ(buffer[i], 0xa5);
+
+        rtp_header_add_csrc(header, 0x11111111U * (uint32_t)(cc + 1));
+    }
+
+    rtp_header_free(header);
+}
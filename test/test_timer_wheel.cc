@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "rtp_timer_wheel.h"
+
+namespace {
+
+struct Probe {
+    rtp_timer timer;
+    rtp_timer_wheel *wheel;
+    uint64_t fired_at;
+    int fired;
+};
+
+void on_fire(void *ctx, rtp_timer *timer)
+{
+    Probe *p = static_cast<Probe*>(ctx);
+    EXPECT_EQ(&p->timer, timer);
+    EXPECT_FALSE(rtp_timer_pending(timer));
+    p->fired_at = rtp_timer_wheel_now(p->wheel);
+    p->fired += 1;
+}
+
+} // namespace
+
+TEST(TimerWheel, Expiry) {
+    const uint64_t start = 1000;
+    rtp_timer_wheel *w = rtp_timer_wheel_create(start);
+    ASSERT_NE(w, nullptr);
+
+    // Both sides of every level boundary, and past the last level
+    const uint64_t offsets[] = {
+        1, 2, 255, 256, 257, 65535, 65536, 65537, 1ull << 24,
+        (1ull << 24) + 1, (1ull << 32) - 1, 1ull << 32, (1ull << 33) + 5
+    };
+    const size_t n = sizeof(offsets) / sizeof(offsets[0]);
+
+    std::vector<Probe> probes(n);
+    for(size_t i = 0; i < n; ++i) {
+        probes[i].wheel = w;
+        probes[i].fired = 0;
+        rtp_timer_init(&probes[i].timer, on_fire, &probes[i]);
+        rtp_timer_wheel_add(w, &probes[i].timer, start + offsets[i]);
+        EXPECT_TRUE(rtp_timer_pending(&probes[i].timer));
+    }
+    EXPECT_EQ(rtp_timer_wheel_size(w), n);
+
+    for(size_t i = 0; i < n; ++i) {
+        // Nothing early
+        EXPECT_EQ(rtp_timer_wheel_advance(w, start + offsets[i] - 1), 0u);
+        EXPECT_EQ(probes[i].fired, 0);
+
+        EXPECT_EQ(rtp_timer_wheel_advance(w, start + offsets[i]), 1u);
+        EXPECT_EQ(probes[i].fired, 1);
+        EXPECT_EQ(probes[i].fired_at, start + offsets[i]);
+    }
+
+    EXPECT_EQ(rtp_timer_wheel_size(w), 0u);
+    EXPECT_EQ(rtp_timer_wheel_now(w), start + offsets[n - 1]);
+
+    // Overdue timers fire on the next advance
+    rtp_timer_wheel_add(w, &probes[0].timer, 0);
+    EXPECT_EQ(rtp_timer_wheel_advance(w, rtp_timer_wheel_now(w) + 1), 1u);
+    EXPECT_EQ(probes[0].fired, 2);
+
+    EXPECT_DEATH(rtp_timer_wheel_add(nullptr, &probes[0].timer, 0), "");
+    rtp_timer_wheel_free(w);
+}
+
+TEST(TimerWheel, Cancel) {
+    rtp_timer_wheel *w = rtp_timer_wheel_create(0);
+
+    Probe a = {}, b = {};
+    a.wheel = b.wheel = w;
+    rtp_timer_init(&a.timer, on_fire, &a);
+    rtp_timer_init(&b.timer, on_fire, &b);
+
+    rtp_timer_wheel_add(w, &a.timer, 100);
+    rtp_timer_wheel_add(w, &b.timer, 100);
+    rtp_timer_wheel_cancel(w, &a.timer);
+    rtp_timer_wheel_cancel(w, &a.timer);
+    EXPECT_FALSE(rtp_timer_pending(&a.timer));
+    EXPECT_EQ(rtp_timer_wheel_size(w), 1u);
+
+    // Moving a pending timer
+    rtp_timer_wheel_add(w, &b.timer, 70000);
+    EXPECT_EQ(rtp_timer_wheel_size(w), 1u);
+    EXPECT_EQ(rtp_timer_wheel_advance(w, 69999), 0u);
+    EXPECT_EQ(rtp_timer_wheel_advance(w, 100000), 1u);
+    EXPECT_EQ(a.fired, 0);
+    EXPECT_EQ(b.fired_at, 70000u);
+
+    rtp_timer_wheel_free(w);
+}
+
+namespace {
+
+struct Chain {
+    rtp_timer timer;
+    rtp_timer_wheel *wheel;
+    Chain *victim;
+    int fired;
+};
+
+void on_chain(void *ctx, rtp_timer *timer)
+{
+    Chain *c = static_cast<Chain*>(ctx);
+    c->fired += 1;
+
+    // Cancel a timer due in the same tick and re-arm ourselves
+    if(c->victim)
+        rtp_timer_wheel_cancel(c->wheel, &c->victim->timer);
+
+    if(c->fired < 3)
+        rtp_timer_wheel_add(c->wheel, timer, timer->expires);
+}
+
+} // namespace
+
+TEST(TimerWheel, Handler) {
+    rtp_timer_wheel *w = rtp_timer_wheel_create(0);
+
+    Chain a = {}, b = {};
+    a.wheel = b.wheel = w;
+    rtp_timer_init(&a.timer, on_chain, &a);
+    rtp_timer_init(&b.timer, on_chain, &b);
+
+    // b is pushed last so fires first, and cancels a
+    rtp_timer_wheel_add(w, &a.timer, 10);
+    rtp_timer_wheel_add(w, &b.timer, 10);
+    b.victim = &a;
+
+    EXPECT_EQ(rtp_timer_wheel_advance(w, 10), 1u);
+    EXPECT_EQ(a.fired, 0);
+    EXPECT_EQ(b.fired, 1);
+
+    // An overdue re-add fires on each following tick
+    EXPECT_EQ(rtp_timer_wheel_advance(w, 100), 2u);
+    EXPECT_EQ(b.fired, 3);
+    EXPECT_EQ(rtp_timer_wheel_size(w), 0u);
+
+    rtp_timer_wheel_free(w);
+}
+
+TEST(TimerWheel, Random) {
+    std::mt19937_64 rng(1234);
+    rtp_timer_wheel *w = rtp_timer_wheel_create(rng() >> 2);
+
+    const size_t n = 5000;
+    std::vector<Probe> probes(n);
+    std::vector<uint64_t> expected(n, 0);
+    for(size_t i = 0; i < n; ++i) {
+        probes[i].wheel = w;
+        probes[i].fired = 0;
+        rtp_timer_init(&probes[i].timer, on_fire, &probes[i]);
+    }
+
+    size_t pending = 0;
+    for(int round = 0; round < 1000; ++round) {
+        const uint64_t now = rtp_timer_wheel_now(w);
+        for(int j = 0; j < 20; ++j) {
+            Probe &p = probes[rng() % n];
+            if(rng() % 4 == 0) {
+                pending -= rtp_timer_pending(&p.timer) ? 1 : 0;
+                rtp_timer_wheel_cancel(w, &p.timer);
+                continue;
+            }
+
+            const uint64_t expires = now + 1 + (rng() >> (2 + rng() % 62));
+            pending += rtp_timer_pending(&p.timer) ? 0 : 1;
+            rtp_timer_wheel_add(w, &p.timer, expires);
+            p.fired = 0;
+            expected[&p - &probes[0]] = expires;
+        }
+
+        ASSERT_EQ(rtp_timer_wheel_size(w), pending);
+
+        const uint64_t to = now + (rng() >> (40 + rng() % 24));
+        pending -= rtp_timer_wheel_advance(w, to);
+        for(size_t i = 0; i < n; ++i) {
+            if(probes[i].fired) {
+                ASSERT_EQ(probes[i].fired, 1);
+                ASSERT_EQ(probes[i].fired_at, expected[i]);
+                probes[i].fired = 0;
+                expected[i] = 0;
+            }
+            else if(rtp_timer_pending(&probes[i].timer)) {
+                ASSERT_GT(expected[i], to);
+            }
+        }
+    }
+
+    rtp_timer_wheel_free(w);
+}
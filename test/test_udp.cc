@@ -0,0 +1,280 @@
+#include <gtest/gtest.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "rtp_transport_udp.h"
+#include "rtp_header.h"
+#include "rtp_packet.h"
+
+/**
+ * @brief Bind a transport to an ephemeral loopback port.
+ */
+static void bind_loopback(rtp_transport_udp *t, struct sockaddr_in *addr)
+{
+    memset(addr, 0, sizeof(struct sockaddr_in));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr->sin_port = 0;
+
+    ASSERT_EQ(rtp_transport_udp_bind(
+        t, (struct sockaddr*)addr, sizeof(struct sockaddr_in)), 0);
+
+    socklen_t len = sizeof(struct sockaddr_in);
+    ASSERT_EQ(getsockname(rtp_transport_udp_fd(t),
+        (struct sockaddr*)addr, &len), 0);
+}
+
+TEST(TransportUdp, Create) {
+    rtp_transport_udp_config config = {};
+    config.batch = 8;
+    config.slots = 4;
+    EXPECT_EQ(rtp_transport_udp_create(AF_INET, &config), nullptr);
+
+    // The ring size would wrap
+    config.slots = 16;
+    config.mtu = SIZE_MAX / 8;
+    EXPECT_EQ(rtp_transport_udp_create(AF_INET, &config), nullptr);
+
+    rtp_transport_udp *t = rtp_transport_udp_create(AF_INET, nullptr);
+    EXPECT_NE(t, nullptr);
+    EXPECT_GE(rtp_transport_udp_fd(t), 0);
+
+    EXPECT_DEATH(rtp_transport_udp_free(nullptr), "");
+    rtp_transport_udp_free(t);
+}
+
+TEST(TransportUdp, Loopback) {
+    rtp_transport_udp_config config = {};
+    config.batch = 16;
+    config.nonblocking = 1;
+
+    rtp_transport_udp *rx = rtp_transport_udp_create(AF_INET, &config);
+    rtp_transport_udp *tx = rtp_transport_udp_create(AF_INET, &config);
+    ASSERT_NE(rx, nullptr);
+    ASSERT_NE(tx, nullptr);
+
+    struct sockaddr_in addr;
+    bind_loopback(rx, &addr);
+    ASSERT_EQ(rtp_transport_udp_connect(
+        tx, (struct sockaddr*)&addr, sizeof(addr)), 0);
+
+    // Nothing to read yet
+    rtp_transport_udp_packet packets[64];
+    EXPECT_EQ(rtp_transport_udp_recv(rx, packets, 64), 0);
+
+    // 64 packets plus one runt
+    static uint8_t data[65][64];
+    struct iovec iov[65];
+
+    rtp_header *header = rtp_header_create();
+    rtp_header_init(header, 96, 0xdeadbeef, 0, 0);
+    for(int i = 0; i < 64; ++i) {
+        header->seq = (uint16_t)i;
+        const int size = rtp_header_serialize(header, data[i], 64);
+        memset(data[i] + size, i, 64 - (size_t)size);
+
+        iov[i].iov_base = data[i];
+        iov[i].iov_len = 64;
+    }
+    rtp_header_free(header);
+
+    iov[64].iov_base = data[64];
+    iov[64].iov_len = 4;
+
+    EXPECT_EQ(rtp_transport_udp_send(tx, iov, 65), 65);
+
+    rtp_transport_udp_stats stats;
+    rtp_transport_udp_get_stats(tx, &stats);
+    EXPECT_EQ(stats.tx_packets, 65);
+    EXPECT_EQ(stats.tx_syscalls, 5);
+
+    int received = 0;
+    for(int tries = 0; received < 64 && tries < 100; ++tries) {
+        const int n = rtp_transport_udp_recv(rx, packets, 64);
+        ASSERT_GE(n, 0);
+
+        for(int i = 0; i < n; ++i) {
+            const rtp_packet_view *view = &packets[i].view;
+            EXPECT_EQ(view->seq, received);
+            EXPECT_EQ(view->ssrc, 0xdeadbeef);
+            EXPECT_EQ(view->payload_size, 52);
+            EXPECT_EQ(view->payload_data[0], received);
+            EXPECT_EQ(packets[i].from.ss_family, AF_INET);
+            received += 1;
+        }
+    }
+
+    EXPECT_EQ(received, 64);
+
+    // Drain the runt
+    EXPECT_EQ(rtp_transport_udp_recv(rx, packets, 64), 0);
+
+    rtp_transport_udp_get_stats(rx, &stats);
+    EXPECT_EQ(stats.rx_packets, 65);
+    EXPECT_EQ(stats.rx_invalid, 1);
+    EXPECT_LE(stats.rx_syscalls, 7);
+
+    rtp_transport_udp_free(tx);
+    rtp_transport_udp_free(rx);
+}
+
+TEST(TransportUdp, Truncated) {
+    rtp_transport_udp_config config = {};
+    config.mtu = 32;
+    config.nonblocking = 1;
+
+    rtp_transport_udp *rx = rtp_transport_udp_create(AF_INET, &config);
+    rtp_transport_udp *tx = rtp_transport_udp_create(AF_INET, &config);
+    ASSERT_NE(rx, nullptr);
+    ASSERT_NE(tx, nullptr);
+
+    struct sockaddr_in addr;
+    bind_loopback(rx, &addr);
+    ASSERT_EQ(rtp_transport_udp_connect(
+        tx, (struct sockaddr*)&addr, sizeof(addr)), 0);
+
+    uint8_t data[64] = { 0x80, 96 };
+    struct iovec iov = { data, sizeof(data) };
+    EXPECT_EQ(rtp_transport_udp_send(tx, &iov, 1), 1);
+
+    rtp_transport_udp_packet packet;
+    EXPECT_EQ(rtp_transport_udp_recv(rx, &packet, 1), 0);
+
+    rtp_transport_udp_stats stats;
+    rtp_transport_udp_get_stats(rx, &stats);
+    EXPECT_EQ(stats.rx_truncated, 1);
+
+    rtp_transport_udp_free(tx);
+    rtp_transport_udp_free(rx);
+}
+
+/**
+ * @brief Send a 100 packet burst and receive it, returns packets received.
+ */
+static int burst_loopback(rtp_transport_udp *rx, rtp_transport_udp_stats *stats)
+{
+    rtp_transport_udp_config config = {};
+    rtp_transport_udp *tx = rtp_transport_udp_create(AF_INET, &config);
+    EXPECT_NE(tx, nullptr);
+
+    struct sockaddr_in addr;
+    bind_loopback(rx, &addr);
+    EXPECT_EQ(rtp_transport_udp_connect(
+        tx, (struct sockaddr*)&addr, sizeof(addr)), 0);
+
+    // 99 full packets and a shorter one at the end
+    rtp_packet *packets[100];
+    uint8_t payload[160];
+    for(int i = 0; i < 100; ++i) {
+        packets[i] = rtp_packet_create();
+        rtp_packet_init(packets[i], 96, 0xdeadbeef, (uint16_t)i, 0);
+        memset(payload, i, sizeof(payload));
+        rtp_packet_set_payload(packets[i], payload, (i < 99) ? 160 : 80);
+    }
+
+    static uint8_t buffer[100 * 172];
+    EXPECT_EQ(rtp_transport_udp_send_burst(
+        tx, packets, 100, buffer, sizeof(buffer)), 100);
+
+    // Every packet but the last must be the same size
+    EXPECT_EQ(rtp_transport_udp_send_burst(
+        tx, &packets[98], 2, buffer, 172), -1);
+    EXPECT_EQ(rtp_transport_udp_send_burst(
+        tx, &packets[99], 1, buffer, 80), -1);
+
+    for(int i = 0; i < 100; ++i)
+        rtp_packet_free(packets[i]);
+
+    rtp_transport_udp_get_stats(tx, stats);
+    EXPECT_EQ(stats->tx_packets, 100);
+    rtp_transport_udp_free(tx);
+
+    // A small out forces coalesced datagrams to be split across calls
+    rtp_transport_udp_packet out[7];
+    int received = 0;
+    for(int tries = 0; received < 100 && tries < 100; ++tries) {
+        const int n = rtp_transport_udp_recv(rx, out, 7);
+        EXPECT_GE(n, 0);
+
+        for(int i = 0; i < n; ++i) {
+            const rtp_packet_view *view = &out[i].view;
+            EXPECT_EQ(view->seq, received);
+            EXPECT_EQ(view->payload_size, (received < 99) ? 160 : 80);
+            EXPECT_EQ(view->payload_data[0], received);
+            received += 1;
+        }
+    }
+
+    rtp_transport_udp_get_stats(rx, stats);
+    return received;
+}
+
+TEST(TransportUdp, Segmented) {
+    rtp_transport_udp_config config = {};
+    config.nonblocking = 1;
+
+    rtp_transport_udp *rx = rtp_transport_udp_create(AF_INET, &config);
+    ASSERT_NE(rx, nullptr);
+
+    rtp_transport_udp_stats stats;
+    EXPECT_EQ(burst_loopback(rx, &stats), 100);
+    EXPECT_EQ(stats.rx_packets, 100);
+    EXPECT_EQ(stats.rx_coalesced, 0);
+
+    rtp_transport_udp_free(rx);
+}
+
+TEST(TransportUdp, Coalesced) {
+    rtp_transport_udp_config config = {};
+    config.nonblocking = 1;
+    config.gro = 1;
+
+    rtp_transport_udp *rx = rtp_transport_udp_create(AF_INET, &config);
+    ASSERT_NE(rx, nullptr);
+
+    rtp_transport_udp_stats stats;
+    EXPECT_EQ(burst_loopback(rx, &stats), 100);
+    EXPECT_EQ(stats.rx_packets, 100);
+    EXPECT_EQ(stats.rx_invalid, 0);
+
+    rtp_transport_udp_free(rx);
+}
+
+TEST(TransportUdp, Timestamps) {
+    rtp_transport_udp_config config = {};
+    config.nonblocking = 1;
+    config.timestamps = 1;
+
+    rtp_transport_udp *rx = rtp_transport_udp_create(AF_INET, &config);
+    rtp_transport_udp *tx = rtp_transport_udp_create(AF_INET, &config);
+    ASSERT_NE(rx, nullptr);
+    ASSERT_NE(tx, nullptr);
+
+    struct sockaddr_in addr;
+    bind_loopback(rx, &addr);
+    ASSERT_EQ(rtp_transport_udp_connect(
+        tx, (struct sockaddr*)&addr, sizeof(addr)), 0);
+
+    struct timespec before, after;
+    clock_gettime(CLOCK_REALTIME, &before);
+
+    uint8_t data[64] = { 0x80, 96 };
+    struct iovec iov = { data, sizeof(data) };
+    EXPECT_EQ(rtp_transport_udp_send(tx, &iov, 1), 1);
+
+    rtp_transport_udp_packet packet;
+    int n = 0;
+    for(int tries = 0; n == 0 && tries < 100; ++tries)
+        n = rtp_transport_udp_recv(rx, &packet, 1);
+
+    clock_gettime(CLOCK_REALTIME, &after);
+    ASSERT_EQ(n, 1);
+
+    // The kernel stamped the datagram between the send and the receive
+    const double arrival = packet.arrival.tv_sec + packet.arrival.tv_nsec / 1e9;
+    EXPECT_GE(arrival, before.tv_sec + before.tv_nsec / 1e9);
+    EXPECT_LE(arrival, after.tv_sec + after.tv_nsec / 1e9);
+
+    rtp_transport_udp_free(tx);
+    rtp_transport_udp_free(rx);
+}
@@ -0,0 +1,225 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "rtp_transport_uring.h"
+#include "rtp_header.h"
+
+/**
+ * @brief Open a socket bound to an ephemeral loopback port.
+ */
+static int bind_loopback(struct sockaddr_in *addr)
+{
+    memset(addr, 0, sizeof(struct sockaddr_in));
+    addr->sin_family = AF_INET;
+    addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(bind(fd, (struct sockaddr*)addr, sizeof(struct sockaddr_in)), 0);
+
+    socklen_t len = sizeof(struct sockaddr_in);
+    EXPECT_EQ(getsockname(fd, (struct sockaddr*)addr, &len), 0);
+    return fd;
+}
+
+/**
+ * @brief Open a socket connected to addr.
+ */
+static int connect_loopback(const struct sockaddr_in *addr)
+{
+    const int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    EXPECT_GE(fd, 0);
+    EXPECT_EQ(connect(fd,
+        (const struct sockaddr*)addr, sizeof(struct sockaddr_in)), 0);
+    return fd;
+}
+
+/**
+ * @brief Serialize an RTP packet with a one byte payload.
+ */
+static void make_packet(uint8_t *data, size_t size, uint32_t ssrc, uint16_t seq)
+{
+    rtp_header *header = rtp_header_create();
+    rtp_header_init(header, 96, ssrc, seq, 0);
+    const int len = rtp_header_serialize(header, data, size);
+    memset(data + len, seq, size - (size_t)len);
+    rtp_header_free(header);
+}
+
+TEST(TransportUring, Create) {
+    rtp_transport_uring_config config = {};
+    config.buffers = 100;
+    EXPECT_EQ(rtp_transport_uring_create(&config), nullptr);
+
+    rtp_transport_uring *t = rtp_transport_uring_create(nullptr);
+    if(!t)
+        GTEST_SKIP() << "io_uring unavailable";
+
+    EXPECT_EQ(rtp_transport_uring_add(t, -1), -1);
+
+    struct iovec iov = { nullptr, 0 };
+    EXPECT_EQ(rtp_transport_uring_send(t, 0, &iov, 1), -1);
+
+    EXPECT_DEATH(rtp_transport_uring_free(nullptr), "");
+    rtp_transport_uring_free(t);
+}
+
+TEST(TransportUring, Loopback) {
+    rtp_transport_uring_config config = {};
+    config.nonblocking = 1;
+
+    rtp_transport_uring *t = rtp_transport_uring_create(&config);
+    if(!t)
+        GTEST_SKIP() << "io_uring unavailable";
+
+    // Two receivers, each with a connected sender, on one ring
+    struct sockaddr_in addr[2];
+    int rx_fd[2], tx_fd[2], rx[2], tx[2];
+    for(int i = 0; i < 2; ++i) {
+        rx_fd[i] = bind_loopback(&addr[i]);
+        tx_fd[i] = connect_loopback(&addr[i]);
+        rx[i] = rtp_transport_uring_add(t, rx_fd[i]);
+        tx[i] = rtp_transport_uring_add(t, tx_fd[i]);
+        EXPECT_GE(rx[i], 0);
+        EXPECT_GE(tx[i], 0);
+    }
+
+    rtp_transport_uring_packet packets[16];
+    EXPECT_EQ(rtp_transport_uring_recv(t, packets, 16), 0);
+
+    // 32 packets to each receiver plus one runt
+    static uint8_t data[32][64];
+    struct iovec iov[32];
+    for(int i = 0; i < 32; ++i) {
+        make_packet(data[i], sizeof(data[i]), 0xdeadbeef, (uint16_t)i);
+        iov[i].iov_base = data[i];
+        iov[i].iov_len = sizeof(data[i]);
+    }
+
+    EXPECT_EQ(rtp_transport_uring_send(t, tx[0], iov, 32), 32);
+    EXPECT_EQ(rtp_transport_uring_send(t, tx[1], iov, 32), 32);
+
+    iov[0].iov_len = 4;
+    EXPECT_EQ(rtp_transport_uring_send(t, tx[1], iov, 1), 1);
+    EXPECT_EQ(rtp_transport_uring_submit(t), 0);
+
+    int received[2] = { 0, 0 };
+    for(int tries = 0; received[0] + received[1] < 64 && tries < 100; ++tries) {
+        const int n = rtp_transport_uring_recv(t, packets, 16);
+        ASSERT_GE(n, 0);
+
+        for(int i = 0; i < n; ++i) {
+            const int s = (packets[i].socket == rx[0]) ? 0 : 1;
+            EXPECT_EQ(packets[i].socket, rx[s]);
+
+            const rtp_packet_view *view = &packets[i].view;
+            EXPECT_EQ(view->seq, received[s]);
+            EXPECT_EQ(view->ssrc, 0xdeadbeef);
+            EXPECT_EQ(view->payload_size, 52);
+            EXPECT_EQ(view->payload_data[0], received[s]);
+            EXPECT_EQ(packets[i].from.ss_family, AF_INET);
+            received[s] += 1;
+        }
+    }
+
+    EXPECT_EQ(received[0], 32);
+    EXPECT_EQ(received[1], 32);
+
+    // Drain the runt
+    for(int tries = 0; tries < 10; ++tries)
+        EXPECT_EQ(rtp_transport_uring_recv(t, packets, 16), 0);
+
+    rtp_transport_uring_stats stats;
+    rtp_transport_uring_get_stats(t, &stats);
+    EXPECT_EQ(stats.tx_packets, 65);
+    EXPECT_EQ(stats.tx_errors, 0);
+    EXPECT_EQ(stats.rx_packets, 65);
+    EXPECT_EQ(stats.rx_invalid, 1);
+
+    rtp_transport_uring_free(t);
+    for(int i = 0; i < 2; ++i) {
+        close(rx_fd[i]);
+        close(tx_fd[i]);
+    }
+}
+
+TEST(TransportUring, Rearm) {
+    rtp_transport_uring_config config = {};
+    config.buffers = 4;
+
+    rtp_transport_uring *t = rtp_transport_uring_create(&config);
+    if(!t)
+        GTEST_SKIP() << "io_uring unavailable";
+
+    struct sockaddr_in addr;
+    const int rx_fd = bind_loopback(&addr);
+    const int tx_fd = connect_loopback(&addr);
+    ASSERT_EQ(rtp_transport_uring_add(t, rx_fd), 0);
+
+    // More datagrams than buffers, the receive restarts as buffers return
+    uint8_t data[64];
+    for(int i = 0; i < 16; ++i) {
+        make_packet(data, sizeof(data), 0xfeedface, (uint16_t)i);
+        EXPECT_EQ(send(tx_fd, data, sizeof(data), 0), (ssize_t)sizeof(data));
+    }
+
+    rtp_transport_uring_packet packets[2];
+    int received = 0;
+    while(received < 16) {
+        const int n = rtp_transport_uring_recv(t, packets, 2);
+        ASSERT_GT(n, 0);
+
+        for(int i = 0; i < n; ++i) {
+            EXPECT_EQ(packets[i].view.seq, received);
+            received += 1;
+        }
+    }
+
+    rtp_transport_uring_stats stats;
+    rtp_transport_uring_get_stats(t, &stats);
+    EXPECT_EQ(stats.rx_packets, 16);
+    EXPECT_GT(stats.rx_rearmed, 0);
+
+    rtp_transport_uring_free(t);
+    close(rx_fd);
+    close(tx_fd);
+}
+
+TEST(TransportUring, Timestamps) {
+    rtp_transport_uring_config config = {};
+    config.timestamps = 1;
+
+    rtp_transport_uring *t = rtp_transport_uring_create(&config);
+    if(!t)
+        GTEST_SKIP() << "io_uring unavailable";
+
+    struct sockaddr_in addr;
+    const int rx_fd = bind_loopback(&addr);
+    const int tx_fd = connect_loopback(&addr);
+    ASSERT_EQ(rtp_transport_uring_add(t, rx_fd), 0);
+
+    struct timespec before, after;
+    clock_gettime(CLOCK_REALTIME, &before);
+
+    uint8_t data[64];
+    make_packet(data, sizeof(data), 0xfeedface, 7);
+    EXPECT_EQ(send(tx_fd, data, sizeof(data), 0), (ssize_t)sizeof(data));
+
+    rtp_transport_uring_packet packet;
+    ASSERT_EQ(rtp_transport_uring_recv(t, &packet, 1), 1);
+    clock_gettime(CLOCK_REALTIME, &after);
+
+    // The payload follows the reserved control space
+    EXPECT_EQ(packet.view.seq, 7);
+    EXPECT_EQ(packet.view.payload_size, 52);
+
+    const double arrival = packet.arrival.tv_sec + packet.arrival.tv_nsec / 1e9;
+    EXPECT_GE(arrival, before.tv_sec + before.tv_nsec / 1e9);
+    EXPECT_LE(arrival, after.tv_sec + after.tv_nsec / 1e9);
+
+    rtp_transport_uring_free(t);
+    close(rx_fd);
+    close(tx_fd);
+}
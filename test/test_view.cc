@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include "rtp_packet.h"
+#include "rtp_packet_view.h"
+
+TEST(RtpPacketView, Parse) {
+    rtp_packet *packet = rtp_packet_create();
+    EXPECT_NE(packet, nullptr);
+
+    rtp_packet_init(packet, 96, rand(), rand(), rand());
+    rtp_header_add_csrc(packet->header, 0x1234);
+    rtp_header_add_csrc(packet->header, 0x5678);
+
+    const uint32_t ext[] = { 0xdeadbeef, 0xcafebabe };
+    packet->header->x = 1;
+    rtp_header_set_ext(packet->header, 0xbede, ext, 2);
+
+    char data[] = "payload string of arbitrary length";
+    rtp_packet_set_payload(packet, data, sizeof(data));
+
+    const int size = rtp_packet_size(packet);
+    uint8_t *buffer = new uint8_t[size];
+
+    rtp_packet_serialize(packet, buffer, size);
+
+    rtp_packet_view view;
+    EXPECT_DEATH(rtp_packet_view_parse(nullptr, buffer, size), "");
+    EXPECT_DEATH(rtp_packet_view_parse(&view, nullptr, 0), "");
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, size), 0);
+
+    EXPECT_EQ(view.version, 2);
+    EXPECT_EQ(view.pt, 96);
+    EXPECT_EQ(view.seq, packet->header->seq);
+    EXPECT_EQ(view.ts, packet->header->ts);
+    EXPECT_EQ(view.ssrc, packet->header->ssrc);
+
+    EXPECT_EQ(view.cc, 2);
+    EXPECT_EQ(rtp_packet_view_csrc(&view, 0), 0x1234);
+    EXPECT_EQ(rtp_packet_view_csrc(&view, 1), 0x5678);
+
+    EXPECT_EQ(view.ext_id, 0xbede);
+    EXPECT_EQ(view.ext_count, 2);
+    EXPECT_EQ(rtp_packet_view_ext(&view, 0), ext[0]);
+    EXPECT_EQ(rtp_packet_view_ext(&view, 1), ext[1]);
+
+    EXPECT_EQ(rtp_packet_view_header_size(&view),
+        rtp_header_size(packet->header));
+
+    // Payload must point into the original buffer
+    EXPECT_EQ(view.payload_size, sizeof(data));
+    EXPECT_EQ(view.payload_data, buffer + rtp_header_size(packet->header));
+    EXPECT_EQ(memcmp(view.payload_data, data, sizeof(data)), 0);
+
+    rtp_packet_free(packet);
+    delete[] buffer;
+}
+
+TEST(RtpPacketView, Padding) {
+    uint8_t buffer[20] = {
+        0xa0, 0x60, 0x00, 0x01,     // V=2, P=1, PT=96, seq=1
+        0x00, 0x00, 0x00, 0x02,     // ts
+        0x00, 0x00, 0x00, 0x03,     // ssrc
+        0x11, 0x22, 0x33, 0x44,     // payload
+        0x00, 0x00, 0x00, 0x04,     // padding
+    };
+
+    rtp_packet_view view;
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, sizeof(buffer)), 0);
+    EXPECT_EQ(view.p, 1);
+    EXPECT_EQ(view.payload_size, 4);
+    EXPECT_EQ(view.payload_data, buffer + 12);
+
+    // Padding count larger than the packet
+    buffer[19] = 9;
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, sizeof(buffer)), -1);
+
+    // Padding count of zero
+    buffer[19] = 0;
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, sizeof(buffer)), -1);
+}
+
+TEST(RtpPacketView, Invalid) {
+    uint8_t buffer[16] = {
+        0x80, 0x60, 0x00, 0x01,     // V=2, PT=96, seq=1
+        0x00, 0x00, 0x00, 0x02,     // ts
+        0x00, 0x00, 0x00, 0x03,     // ssrc
+        0x00, 0x00, 0x00, 0x00,
+    };
+
+    rtp_packet_view view;
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, sizeof(buffer)), 0);
+
+    // Too short
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, 11), -1);
+
+    // Bad version
+    buffer[0] = 0x40;
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, sizeof(buffer)), -1);
+    buffer[0] = 0x80;
+
+    // RTCP payload type range
+    buffer[1] = 72;
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, sizeof(buffer)), -1);
+    buffer[1] = 0x60;
+
+    // CSRC list exceeds packet
+    buffer[0] = 0x82;
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, sizeof(buffer)), -1);
+
+    // Extension exceeds packet
+    buffer[0] = 0x90;
+    buffer[14] = 0x00;
+    buffer[15] = 0x01;
+    EXPECT_EQ(rtp_packet_view_parse(&view, buffer, sizeof(buffer)), -1);
+}
+
+TEST(RtpPacketView, Batch) {
+    uint8_t valid[16] = {
+        0x80, 0x60, 0x00, 0x01,     // V=2, PT=96, seq=1
+        0x00, 0x00, 0x00, 0x02,     // ts
+        0x00, 0x00, 0x00, 0x03,     // ssrc
+        0x11, 0x22, 0x33, 0x44,     // payload
+    };
+
+    uint8_t version[16];
+    memcpy(version, valid, sizeof(valid));
+    version[0] = 0x40;
+
+    uint8_t pt[16];
+    memcpy(pt, valid, sizeof(valid));
+    pt[1] = 80;
+
+    uint8_t csrc[16];
+    memcpy(csrc, valid, sizeof(valid));
+    csrc[0] = 0x82;
+
+    // Interleave good and bad packets across more than one block
+    const size_t n = 130;
+    struct iovec *iov = new struct iovec[n];
+    rtp_packet_view *views = new rtp_packet_view[n];
+    uint8_t *status = new uint8_t[n];
+
+    for(size_t i = 0; i < n; ++i) {
+        iov[i].iov_base = valid;
+        iov[i].iov_len = sizeof(valid);
+
+        switch(i % 5) {
+            case 1:
+                iov[i].iov_len = 11;
+                break;
+            case 2:
+                iov[i].iov_base = version;
+                break;
+            case 3:
+                iov[i].iov_base = pt;
+                break;
+            case 4:
+                iov[i].iov_base = csrc;
+                break;
+        }
+    }
+
+    EXPECT_DEATH(rtp_parse_batch(nullptr, n, views, status), "");
+    EXPECT_EQ(rtp_parse_batch(iov, 0, nullptr, nullptr), 0);
+    EXPECT_EQ(rtp_parse_batch(iov, n, views, status), n / 5);
+
+    for(size_t i = 0; i < n; ++i) {
+        switch(i % 5) {
+            case 0:
+                EXPECT_EQ(status[i], RTP_PARSE_OK);
+                EXPECT_EQ(views[i].seq, 1);
+                EXPECT_EQ(views[i].ts, 2);
+                EXPECT_EQ(views[i].ssrc, 3);
+                EXPECT_EQ(views[i].payload_size, 4);
+                EXPECT_EQ(views[i].payload_data, valid + 12);
+                break;
+            case 1:
+                EXPECT_EQ(status[i], RTP_PARSE_SHORT);
+                break;
+            case 2:
+                EXPECT_EQ(status[i], RTP_PARSE_VERSION);
+                break;
+            case 3:
+                EXPECT_EQ(status[i], RTP_PARSE_PT);
+                break;
+            case 4:
+                EXPECT_EQ(status[i], RTP_PARSE_LENGTH);
+                break;
+        }
+    }
+
+    delete[] iov;
+    delete[] views;
+    delete[] status;
+}